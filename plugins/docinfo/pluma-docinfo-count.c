@@ -0,0 +1,137 @@
+/*
+ * pluma-docinfo-count.c
+ *
+ * Copyright (C) 2002-2005 Paolo Maggi
+ * Copyright (C) 2012-2021 MATE Developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "pluma-docinfo-count.h"
+
+#include <string.h> /* For strlen (...) */
+
+#include <pango/pango-break.h>
+
+#include <pluma/pluma-debug.h>
+
+#define CHUNK_CHARS (64 * 1024)
+
+static gboolean
+is_space (gunichar ch,
+	  gpointer user_data)
+{
+	return g_unichar_isspace (ch);
+}
+
+/* The text is looked at in chunks of about CHUNK_CHARS characters, cut
+ * on white space so that no word is split: neither the text nor the
+ * PangoLogAttr array of a huge document or line are ever allocated whole */
+void
+pluma_docinfo_count (PlumaDocument     *doc,
+		     const GtkTextIter *start,
+		     const GtkTextIter *end,
+		     gint              *chars,
+		     gint              *words,
+		     gint              *white_chars,
+		     gint              *bytes)
+{
+	GtkTextIter chunk_start;
+	PangoLogAttr *attrs = NULL;
+	gint n_attrs = 0;
+
+	pluma_debug (DEBUG_PLUGINS);
+
+	*chars = 0;
+	*words = 0;
+	*white_chars = 0;
+	*bytes = 0;
+
+	chunk_start = *start;
+
+	while (gtk_text_iter_compare (&chunk_start, end) < 0)
+	{
+		GtkTextIter chunk_end;
+		gchar *text;
+		gint n_chars;
+		gint i;
+
+		chunk_end = chunk_start;
+		gtk_text_iter_forward_chars (&chunk_end, CHUNK_CHARS);
+
+		if (gtk_text_iter_compare (&chunk_end, end) < 0)
+		{
+			GtkTextIter limit;
+
+			/* a word longer than the chunk is counted twice, but
+			 * a chunk never grows past twice its size */
+			limit = chunk_end;
+			gtk_text_iter_forward_chars (&limit, CHUNK_CHARS);
+			if (gtk_text_iter_compare (&limit, end) > 0)
+				limit = *end;
+
+			if (!gtk_text_iter_forward_find_char (&chunk_end,
+							      is_space,
+							      NULL,
+							      &limit))
+				chunk_end = limit;
+		}
+		else
+		{
+			chunk_end = *end;
+		}
+
+		text = gtk_text_buffer_get_slice (GTK_TEXT_BUFFER (doc),
+						  &chunk_start,
+						  &chunk_end,
+						  TRUE);
+
+		n_chars = g_utf8_strlen (text, -1);
+		*chars += n_chars;
+		*bytes += strlen (text);
+
+		if (n_chars + 1 > n_attrs)
+		{
+			n_attrs = n_chars + 1;
+			attrs = g_renew (PangoLogAttr, attrs, n_attrs);
+		}
+
+		pango_get_log_attrs (text,
+				     -1,
+				     0,
+				     pango_language_from_string ("C"),
+				     attrs,
+				     n_chars + 1);
+
+		for (i = 0; i < n_chars; i++)
+		{
+			if (attrs[i].is_white)
+				++(*white_chars);
+
+			if (attrs[i].is_word_start)
+				++(*words);
+		}
+
+		g_free (text);
+
+		chunk_start = chunk_end;
+	}
+
+	g_free (attrs);
+}
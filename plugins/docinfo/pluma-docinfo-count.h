@@ -0,0 +1,39 @@
+/*
+ * pluma-docinfo-count.h
+ *
+ * Copyright (C) 2002-2005 Paolo Maggi
+ * Copyright (C) 2012-2021 MATE Developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __PLUMA_DOCINFO_COUNT_H__
+#define __PLUMA_DOCINFO_COUNT_H__
+
+#include <pluma/pluma-document.h>
+
+G_BEGIN_DECLS
+
+void	pluma_docinfo_count	(PlumaDocument     *doc,
+				 const GtkTextIter *start,
+				 const GtkTextIter *end,
+				 gint              *chars,
+				 gint              *words,
+				 gint              *white_chars,
+				 gint              *bytes);
+
+G_END_DECLS
+
+#endif /* __PLUMA_DOCINFO_COUNT_H__ */
@@ -26,11 +26,9 @@
 #endif
 
 #include "pluma-docinfo-plugin.h"
-
-#include <string.h> /* For strlen (...) */
+#include "pluma-docinfo-count.h"
 
 #include <glib/gi18n-lib.h>
-#include <pango/pango-break.h>
 #include <gmodule.h>
 
 #include <pluma/pluma-window-activatable.h>
@@ -173,61 +171,6 @@ get_docinfo_dialog (PlumaDocInfoPlugin *plugin)
 	return dialog;
 }
 
-static void
-calculate_info (PlumaDocument *doc,
-		GtkTextIter   *start,
-		GtkTextIter   *end,
-		gint          *chars,
-		gint          *words,
-		gint          *white_chars,
-		gint          *bytes)
-{
-	gchar *text;
-
-	pluma_debug (DEBUG_PLUGINS);
-
-	text = gtk_text_buffer_get_slice (GTK_TEXT_BUFFER (doc),
-					  start,
-					  end,
-					  TRUE);
-
-	*chars = g_utf8_strlen (text, -1);
-	*bytes = strlen (text);
-
-	if (*chars > 0)
-	{
-		PangoLogAttr *attrs;
-		gint i;
-
-		attrs = g_new0 (PangoLogAttr, *chars + 1);
-
-		pango_get_log_attrs (text,
-				     -1,
-				     0,
-				     pango_language_from_string ("C"),
-				     attrs,
-				     *chars + 1);
-
-		for (i = 0; i < (*chars); i++)
-		{
-			if (attrs[i].is_white)
-				++(*white_chars);
-
-			if (attrs[i].is_word_start)
-				++(*words);
-		}
-
-		g_free (attrs);
-	}
-	else
-	{
-		*white_chars = 0;
-		*words = 0;
-	}
-
-	g_free (text);
-}
-
 static void
 docinfo_real (PlumaDocument *doc,
 	      DocInfoDialog *dialog)
@@ -249,9 +192,9 @@ docinfo_real (PlumaDocument *doc,
 
 	lines = gtk_text_buffer_get_line_count (GTK_TEXT_BUFFER (doc));
 
-	calculate_info (doc,
-			&start, &end,
-			&chars, &words, &white_chars, &bytes);
+	pluma_docinfo_count (doc,
+			     &start, &end,
+			     &chars, &words, &white_chars, &bytes);
 
 	if (chars == 0)
 		lines = 0;
@@ -312,9 +255,9 @@ selectioninfo_real (PlumaDocument *doc,
 	{
 		lines = gtk_text_iter_get_line (&end) - gtk_text_iter_get_line (&start) + 1;
 
-		calculate_info (doc,
-				&start, &end,
-				&chars, &words, &white_chars, &bytes);
+		pluma_docinfo_count (doc,
+				     &start, &end,
+				     &chars, &words, &white_chars, &bytes);
 
 		pluma_debug_message (DEBUG_PLUGINS, "Selected chars: %d", chars);
 		pluma_debug_message (DEBUG_PLUGINS, "Selected lines: %d", lines);
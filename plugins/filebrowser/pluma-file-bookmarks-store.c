@@ -28,12 +28,32 @@
 #include "pluma-file-bookmarks-store.h"
 #include "pluma-file-browser-utils.h"
 
+/* Seconds to wait for the info of a local file before giving up on it */
+#define QUERY_TIMEOUT 5
+
 struct _PlumaFileBookmarksStorePrivate
 {
 	GVolumeMonitor * volume_monitor;
 	GFileMonitor * bookmarks_monitor;
+
+	GCancellable * bookmarks_cancellable;
+	GList * queries;
+	guint init_fs_id;
 };
 
+typedef struct
+{
+	PlumaFileBookmarksStore *model;
+	GtkTreeRowReference *row;
+	GCancellable *cancellable;
+	guint timeout_id;
+	gboolean set_name;
+} FileQuery;
+
+/* uri -> GFileInfo with the icon and the display name, shared by the
+ * stores of all the windows */
+static GHashTable *file_info_cache = NULL;
+
 static void remove_node               (GtkTreeModel * model,
                                        GtkTreeIter * iter);
 
@@ -51,6 +71,7 @@ static gboolean find_with_flags       (GtkTreeModel * model,
                                        gpointer obj,
                                        guint flags,
                                        guint notflags);
+static void file_query_detach         (FileQuery * query);
 
 G_DEFINE_DYNAMIC_TYPE_EXTENDED (PlumaFileBookmarksStore,
                                 pluma_file_bookmarks_store,
@@ -63,6 +84,21 @@ pluma_file_bookmarks_store_dispose (GObject * object)
 {
 	PlumaFileBookmarksStore *obj = PLUMA_FILE_BOOKMARKS_STORE (object);
 
+	if (obj->priv->init_fs_id != 0) {
+		g_source_remove (obj->priv->init_fs_id);
+		obj->priv->init_fs_id = 0;
+	}
+
+	if (obj->priv->bookmarks_cancellable != NULL) {
+		g_cancellable_cancel (obj->priv->bookmarks_cancellable);
+		g_object_unref (obj->priv->bookmarks_cancellable);
+		obj->priv->bookmarks_cancellable = NULL;
+	}
+
+	g_list_foreach (obj->priv->queries, (GFunc)file_query_detach, NULL);
+	g_list_free (obj->priv->queries);
+	obj->priv->queries = NULL;
+
 	if (obj->priv->volume_monitor != NULL) {
 		g_signal_handlers_disconnect_by_func (obj->priv->volume_monitor,
 						      on_fs_changed,
@@ -93,12 +129,18 @@ pluma_file_bookmarks_store_class_init (PlumaFileBookmarksStoreClass *klass)
 
 	object_class->dispose = pluma_file_bookmarks_store_dispose;
 	object_class->finalize = pluma_file_bookmarks_store_finalize;
+
+	file_info_cache = g_hash_table_new_full (g_str_hash,
+						 g_str_equal,
+						 g_free,
+						 g_object_unref);
 }
 
 static void
 pluma_file_bookmarks_store_class_finalize (PlumaFileBookmarksStoreClass *klass)
 {
-	/* dummy function - used by G_DEFINE_DYNAMIC_TYPE_EXTENDED */
+	g_hash_table_destroy (file_info_cache);
+	file_info_cache = NULL;
 }
 
 static void
@@ -131,6 +173,194 @@ add_node (PlumaFileBookmarksStore *model,
 		*iter = newiter;
 }
 
+static void
+set_file_info (PlumaFileBookmarksStore *model,
+	       GtkTreeIter             *iter,
+	       GFileInfo               *info,
+	       gboolean                 set_name)
+{
+	GIcon *icon;
+	guint flags;
+
+	gtk_tree_model_get (GTK_TREE_MODEL (model), iter,
+			    PLUMA_FILE_BOOKMARKS_STORE_COLUMN_FLAGS, &flags,
+			    -1);
+
+	/* These have their own themed icons */
+	icon = g_file_info_get_icon (info);
+
+	if (icon != NULL &&
+	    !(flags & (PLUMA_FILE_BOOKMARKS_STORE_IS_HOME |
+		       PLUMA_FILE_BOOKMARKS_STORE_IS_DESKTOP |
+		       PLUMA_FILE_BOOKMARKS_STORE_IS_ROOT)))
+	{
+		GdkPixbuf *pixbuf;
+
+		pixbuf = pluma_file_browser_utils_pixbuf_from_icon (icon, GTK_ICON_SIZE_MENU);
+
+		if (pixbuf != NULL) {
+			gtk_tree_store_set (GTK_TREE_STORE (model), iter,
+					    PLUMA_FILE_BOOKMARKS_STORE_COLUMN_ICON, pixbuf,
+					    -1);
+			g_object_unref (pixbuf);
+		}
+	}
+
+	if (set_name && g_file_info_get_display_name (info) != NULL) {
+		gtk_tree_store_set (GTK_TREE_STORE (model), iter,
+				    PLUMA_FILE_BOOKMARKS_STORE_COLUMN_NAME,
+				    g_file_info_get_display_name (info),
+				    -1);
+	}
+}
+
+static void
+check_bookmarks_separator (PlumaFileBookmarksStore *model)
+{
+	GtkTreeIter iter;
+
+	/* Drop the separator once the last bookmark went away */
+	if (!find_with_flags (GTK_TREE_MODEL (model), &iter, NULL,
+			      PLUMA_FILE_BOOKMARKS_STORE_IS_BOOKMARK,
+			      PLUMA_FILE_BOOKMARKS_STORE_IS_SEPARATOR) &&
+	    find_with_flags (GTK_TREE_MODEL (model), &iter, NULL,
+			     PLUMA_FILE_BOOKMARKS_STORE_IS_BOOKMARK |
+			     PLUMA_FILE_BOOKMARKS_STORE_IS_SEPARATOR, 0))
+	{
+		gtk_tree_store_remove (GTK_TREE_STORE (model), &iter);
+	}
+}
+
+static void
+file_query_detach (FileQuery *query)
+{
+	if (query->timeout_id != 0) {
+		g_source_remove (query->timeout_id);
+		query->timeout_id = 0;
+	}
+
+	g_cancellable_cancel (query->cancellable);
+
+	if (query->row != NULL) {
+		gtk_tree_row_reference_free (query->row);
+		query->row = NULL;
+	}
+
+	/* The query is freed when its callback runs */
+	query->model = NULL;
+}
+
+static gboolean
+file_query_timeout (gpointer data)
+{
+	FileQuery *query = data;
+	PlumaFileBookmarksStore *model = query->model;
+
+	/* A blocked stat cannot really be cancelled, so we just keep the
+	 * default icon and name and stop caring about the answer */
+	query->timeout_id = 0;
+
+	model->priv->queries = g_list_remove (model->priv->queries, query);
+	file_query_detach (query);
+
+	return FALSE;
+}
+
+static void
+file_info_queried (GObject      *source,
+		   GAsyncResult *res,
+		   gpointer      user_data)
+{
+	FileQuery *query = user_data;
+	PlumaFileBookmarksStore *model = query->model;
+	GFileInfo *info;
+	GError *error = NULL;
+
+	info = g_file_query_info_finish (G_FILE (source), res, &error);
+
+	if (model != NULL)
+	{
+		GtkTreePath *path = NULL;
+		GtkTreeIter iter;
+
+		model->priv->queries = g_list_remove (model->priv->queries, query);
+
+		if (info != NULL) {
+			g_hash_table_replace (file_info_cache,
+					      g_file_get_uri (G_FILE (source)),
+					      g_object_ref (info));
+		}
+
+		if (gtk_tree_row_reference_valid (query->row))
+			path = gtk_tree_row_reference_get_path (query->row);
+
+		if (path != NULL &&
+		    gtk_tree_model_get_iter (GTK_TREE_MODEL (model), &iter, path))
+		{
+			if (info != NULL) {
+				set_file_info (model, &iter, info, query->set_name);
+			} else if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND)) {
+				guint flags;
+
+				gtk_tree_model_get (GTK_TREE_MODEL (model), &iter,
+						    PLUMA_FILE_BOOKMARKS_STORE_COLUMN_FLAGS, &flags,
+						    -1);
+
+				remove_node (GTK_TREE_MODEL (model), &iter);
+
+				if (flags & PLUMA_FILE_BOOKMARKS_STORE_IS_BOOKMARK)
+					check_bookmarks_separator (model);
+			}
+		}
+
+		gtk_tree_path_free (path);
+		file_query_detach (query);
+	}
+
+	if (info != NULL)
+		g_object_unref (info);
+
+	if (error != NULL)
+		g_error_free (error);
+
+	g_object_unref (query->cancellable);
+	g_free (query);
+}
+
+static void
+query_file_info (PlumaFileBookmarksStore *model,
+		 GFile                   *file,
+		 GtkTreeIter             *iter,
+		 gboolean                 set_name)
+{
+	FileQuery *query;
+	GtkTreePath *path;
+
+	query = g_new0 (FileQuery, 1);
+	query->model = model;
+	query->set_name = set_name;
+	query->cancellable = g_cancellable_new ();
+
+	path = gtk_tree_model_get_path (GTK_TREE_MODEL (model), iter);
+	query->row = gtk_tree_row_reference_new (GTK_TREE_MODEL (model), path);
+	gtk_tree_path_free (path);
+
+	query->timeout_id = g_timeout_add_seconds (QUERY_TIMEOUT,
+						   file_query_timeout,
+						   query);
+
+	model->priv->queries = g_list_prepend (model->priv->queries, query);
+
+	g_file_query_info_async (file,
+				 G_FILE_ATTRIBUTE_STANDARD_ICON ","
+				 G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME,
+				 G_FILE_QUERY_INFO_NONE,
+				 G_PRIORITY_LOW,
+				 query->cancellable,
+				 file_info_queried,
+				 query);
+}
+
 static gboolean
 add_file (PlumaFileBookmarksStore *model,
 	  GFile 		  *file,
@@ -139,13 +369,19 @@ add_file (PlumaFileBookmarksStore *model,
 	  GtkTreeIter 		  *iter)
 {
 	GdkPixbuf *pixbuf = NULL;
+	GFileInfo *info = NULL;
+	GtkTreeIter newiter;
 	gboolean native;
 	gchar *newname;
 
 	native = g_file_is_native (file);
 
-	if (native && !g_file_query_exists (file, NULL)) {
-		return FALSE;
+	if (native) {
+		gchar *uri;
+
+		uri = g_file_get_uri (file);
+		info = g_hash_table_lookup (file_info_cache, uri);
+		g_free (uri);
 	}
 
 	if (flags & PLUMA_FILE_BOOKMARKS_STORE_IS_HOME)
@@ -155,28 +391,43 @@ add_file (PlumaFileBookmarksStore *model,
 	else if (flags & PLUMA_FILE_BOOKMARKS_STORE_IS_ROOT)
 		pixbuf = pluma_file_browser_utils_pixbuf_from_theme ("drive-harddisk", GTK_ICON_SIZE_MENU);
 
-	if (pixbuf == NULL) {
-		/* getting the icon is a sync get_info call, so we just do it for local files */
-		if (native) {
-			pixbuf = pluma_file_browser_utils_pixbuf_from_file (file, GTK_ICON_SIZE_MENU);
-		} else {
-			pixbuf = pluma_file_browser_utils_pixbuf_from_theme ("folder", GTK_ICON_SIZE_MENU);
-		}
-	}
+	if (pixbuf == NULL && info != NULL && g_file_info_get_icon (info) != NULL)
+		pixbuf = pluma_file_browser_utils_pixbuf_from_icon (g_file_info_get_icon (info), GTK_ICON_SIZE_MENU);
 
-	if (name == NULL) {
-		newname = pluma_file_browser_utils_file_basename (file);
-	} else {
+	if (pixbuf == NULL)
+		pixbuf = pluma_file_browser_utils_pixbuf_from_theme ("folder", GTK_ICON_SIZE_MENU);
+
+	if (name != NULL) {
 		newname = g_strdup (name);
+	} else if (info != NULL && g_file_info_get_display_name (info) != NULL) {
+		newname = g_strdup (g_file_info_get_display_name (info));
+	} else if (native) {
+		gchar *path;
+
+		/* the display name comes with the file info */
+		path = g_file_get_path (file);
+		newname = g_filename_display_basename (path);
+		g_free (path);
+	} else {
+		newname = pluma_file_browser_utils_file_basename (file);
 	}
 
-	add_node (model, pixbuf, newname, G_OBJECT (file), flags, iter);
+	add_node (model, pixbuf, newname, G_OBJECT (file), flags, &newiter);
+
+	/* Checking that a local file exists and getting its icon can hang
+	 * on a stale mount, so the row is added right away and updated (or
+	 * removed) when the info arrives. Remote files are never queried */
+	if (native)
+		query_file_info (model, file, &newiter, name == NULL);
 
 	if (pixbuf)
 		g_object_unref (pixbuf);
 
 	g_free (newname);
 
+	if (iter != NULL)
+		*iter = newiter;
+
 	return TRUE;
 }
 
@@ -465,6 +716,17 @@ init_fs (PlumaFileBookmarksStore * model)
 	init_mounts (model);
 }
 
+static gboolean
+init_fs_idle (gpointer data)
+{
+	PlumaFileBookmarksStore *model = PLUMA_FILE_BOOKMARKS_STORE (data);
+
+	model->priv->init_fs_id = 0;
+	init_fs (model);
+
+	return FALSE;
+}
+
 static gboolean
 add_bookmark (PlumaFileBookmarksStore * model,
 	      gchar const * name,
@@ -502,23 +764,14 @@ get_legacy_bookmarks_file (void)
 	return g_build_filename (g_get_home_dir (), ".gtk-bookmarks", NULL);
 }
 
-static gboolean
-parse_bookmarks_file (PlumaFileBookmarksStore *model,
-		      const gchar             *bookmarks,
-		      gboolean                *added)
+static void
+parse_bookmarks (PlumaFileBookmarksStore *model,
+		 GFile                   *file,
+		 gchar                   *contents)
 {
-	GError *error = NULL;
-	gchar *contents;
 	gchar **lines;
 	gchar **line;
-
-	if (!g_file_get_contents (bookmarks, &contents, NULL, &error))
-	{
-		/* The bookmarks file doesn't exist (which is perfectly fine) */
-		g_error_free (error);
-
-		return FALSE;
-	}
+	gboolean added = FALSE;
 
 	lines = g_strsplit (contents, "\n", 0);
 
@@ -546,56 +799,110 @@ parse_bookmarks_file (PlumaFileBookmarksStore *model,
 			 * URIs, but paranoia is good */
 			if (pluma_utils_is_valid_uri (*line))
 			{
-				*added |= add_bookmark (model, name, *line);
+				added |= add_bookmark (model, name, *line);
 			}
 		}
 	}
 
 	g_strfreev (lines);
-	g_free (contents);
+
+	if (added) {
+		/* Bookmarks separator */
+		add_node (model, NULL, NULL, NULL,
+			  PLUMA_FILE_BOOKMARKS_STORE_IS_BOOKMARK |
+			  PLUMA_FILE_BOOKMARKS_STORE_IS_SEPARATOR, NULL);
+	}
 
 	/* Add a watch */
 	if (model->priv->bookmarks_monitor == NULL)
 	{
-		GFile *file;
-
-		file = g_file_new_for_path (bookmarks);
 		model->priv->bookmarks_monitor = g_file_monitor_file (file, G_FILE_MONITOR_NONE, NULL, NULL);
-		g_object_unref (file);
 
 		g_signal_connect (model->priv->bookmarks_monitor,
 				  "changed",
 				  G_CALLBACK (on_bookmarks_file_changed),
 				  model);
 	}
-
-	return TRUE;
 }
 
+static void load_bookmarks_file (PlumaFileBookmarksStore *model,
+				 const gchar             *bookmarks);
+
 static void
-init_bookmarks (PlumaFileBookmarksStore *model)
+bookmarks_file_loaded (GObject      *source,
+		       GAsyncResult *res,
+		       gpointer      user_data)
 {
-	gchar *bookmarks;
-	gboolean added = FALSE;
-
-	bookmarks = get_bookmarks_file ();
+	PlumaFileBookmarksStore *model;
+	GFile *file = G_FILE (source);
+	GError *error = NULL;
+	gchar *contents;
+	gchar *path;
+	gchar *legacy;
 
-	if (!parse_bookmarks_file (model, bookmarks, &added))
+	if (!g_file_load_contents_finish (file, res, &contents, NULL, NULL, &error))
 	{
-		g_free (bookmarks);
+		/* the store may be gone already */
+		if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+		{
+			g_error_free (error);
+			return;
+		}
+
+		/* The bookmarks file doesn't exist (which is perfectly fine) */
+		g_error_free (error);
+
+		model = PLUMA_FILE_BOOKMARKS_STORE (user_data);
+		path = g_file_get_path (file);
+		legacy = get_legacy_bookmarks_file ();
 
 		/* try the old location (gtk <= 3.4) */
-		bookmarks = get_legacy_bookmarks_file ();
-		parse_bookmarks_file (model, bookmarks, &added);
+		if (g_strcmp0 (path, legacy) != 0)
+			load_bookmarks_file (model, legacy);
+
+		g_free (legacy);
+		g_free (path);
+
+		return;
 	}
 
-	if (added) {
-		/* Bookmarks separator */
-		add_node (model, NULL, NULL, NULL,
-			  PLUMA_FILE_BOOKMARKS_STORE_IS_BOOKMARK |
-			  PLUMA_FILE_BOOKMARKS_STORE_IS_SEPARATOR, NULL);
+	model = PLUMA_FILE_BOOKMARKS_STORE (user_data);
+
+	parse_bookmarks (model, file, contents);
+	g_free (contents);
+}
+
+static void
+load_bookmarks_file (PlumaFileBookmarksStore *model,
+		     const gchar             *bookmarks)
+{
+	GFile *file;
+
+	file = g_file_new_for_path (bookmarks);
+
+	g_file_load_contents_async (file,
+				    model->priv->bookmarks_cancellable,
+				    bookmarks_file_loaded,
+				    model);
+
+	g_object_unref (file);
+}
+
+static void
+init_bookmarks (PlumaFileBookmarksStore *model)
+{
+	gchar *bookmarks;
+
+	if (model->priv->bookmarks_cancellable != NULL)
+	{
+		g_cancellable_cancel (model->priv->bookmarks_cancellable);
+		g_object_unref (model->priv->bookmarks_cancellable);
 	}
 
+	model->priv->bookmarks_cancellable = g_cancellable_new ();
+
+	bookmarks = get_bookmarks_file ();
+	load_bookmarks_file (model, bookmarks);
 	g_free (bookmarks);
 }
 
@@ -786,7 +1093,12 @@ static void
 initialize_fill (PlumaFileBookmarksStore * model)
 {
 	init_special_directories (model);
-	init_fs (model);
+
+	/* Getting the volume monitor may have to wait for the volume
+	 * monitor services, do not hold up the window for it */
+	if (model->priv->init_fs_id == 0)
+		model->priv->init_fs_id = g_idle_add (init_fs_idle, model);
+
 	init_bookmarks (model);
 }
 
@@ -867,6 +1179,10 @@ pluma_file_bookmarks_store_get_uri (PlumaFileBookmarksStore * model,
 void
 pluma_file_bookmarks_store_refresh (PlumaFileBookmarksStore * model)
 {
+	g_list_foreach (model->priv->queries, (GFunc)file_query_detach, NULL);
+	g_list_free (model->priv->queries);
+	model->priv->queries = NULL;
+
 	gtk_tree_store_clear (GTK_TREE_STORE (model));
 	initialize_fill (model);
 }
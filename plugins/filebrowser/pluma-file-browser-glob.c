@@ -0,0 +1,194 @@
+/*
+ * pluma-file-browser-glob.c - Pluma plugin providing easy file access
+ * from the sidepanel
+ *
+ * Copyright (C) 2012-2021 MATE Developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <string.h>
+
+#include "pluma-file-browser-glob.h"
+
+/*
+ * A list of globs separated by spaces or commas, like "*.c *.h !*-test.c".
+ * A glob starting with '!' hides the files it matches. As in gitignore the
+ * last glob matching a name decides; names that match nothing are shown
+ * unless there is at least one glob which is not an exclusion.
+ *
+ * Plain names and "*suffix" globs, by far the most common ones, are looked
+ * up in hash tables; only the remaining globs go through GPatternSpec.
+ */
+
+typedef struct
+{
+	GPatternSpec *spec;
+	guint index;
+} GlobSpec;
+
+struct _PlumaFileBrowserGlob
+{
+	/* name or suffix -> index + 1 of the last glob using it */
+	GHashTable *names;
+	GHashTable *suffixes;
+	gsize max_suffix;
+
+	/* GlobSpec, in the order of the globs */
+	GArray *specs;
+
+	/* per glob index */
+	GArray *exclude;
+	gboolean has_include;
+};
+
+static gboolean
+has_wildcards (gchar const * str)
+{
+	return strpbrk (str, "*?") != NULL;
+}
+
+PlumaFileBrowserGlob *
+pluma_file_browser_glob_new (gchar const * patterns)
+{
+	PlumaFileBrowserGlob *glob;
+	gchar **globs;
+	gchar **item;
+
+	g_return_val_if_fail (patterns != NULL, NULL);
+
+	glob = g_new0 (PlumaFileBrowserGlob, 1);
+	glob->names = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	glob->suffixes = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	glob->specs = g_array_new (FALSE, FALSE, sizeof (GlobSpec));
+	glob->exclude = g_array_new (FALSE, FALSE, sizeof (gboolean));
+
+	globs = g_strsplit_set (patterns, " \t,", 0);
+
+	for (item = globs; *item; ++item) {
+		gchar const *pattern = *item;
+		gboolean exclude = FALSE;
+		guint index;
+
+		if (*pattern == '!') {
+			exclude = TRUE;
+			++pattern;
+		}
+
+		if (*pattern == '\0')
+			continue;
+
+		index = glob->exclude->len;
+		g_array_append_val (glob->exclude, exclude);
+
+		if (!exclude)
+			glob->has_include = TRUE;
+
+		if (!has_wildcards (pattern)) {
+			g_hash_table_replace (glob->names,
+					      g_strdup (pattern),
+					      GUINT_TO_POINTER (index + 1));
+		} else if (*pattern == '*' && pattern[1] != '\0' &&
+			   !has_wildcards (pattern + 1)) {
+			g_hash_table_replace (glob->suffixes,
+					      g_strdup (pattern + 1),
+					      GUINT_TO_POINTER (index + 1));
+			glob->max_suffix = MAX (glob->max_suffix, strlen (pattern + 1));
+		} else {
+			GlobSpec spec;
+
+			spec.spec = g_pattern_spec_new (pattern);
+			spec.index = index;
+			g_array_append_val (glob->specs, spec);
+		}
+	}
+
+	g_strfreev (globs);
+
+	if (glob->exclude->len == 0) {
+		pluma_file_browser_glob_free (glob);
+		return NULL;
+	}
+
+	return glob;
+}
+
+void
+pluma_file_browser_glob_free (PlumaFileBrowserGlob * glob)
+{
+	guint i;
+
+	if (glob == NULL)
+		return;
+
+	for (i = 0; i < glob->specs->len; ++i)
+		g_pattern_spec_free (g_array_index (glob->specs, GlobSpec, i).spec);
+
+	g_hash_table_destroy (glob->names);
+	g_hash_table_destroy (glob->suffixes);
+	g_array_free (glob->specs, TRUE);
+	g_array_free (glob->exclude, TRUE);
+	g_free (glob);
+}
+
+gboolean
+pluma_file_browser_glob_match (PlumaFileBrowserGlob * glob,
+			       gchar const * name)
+{
+	guint best;
+	gsize len;
+	gsize start;
+	gint i;
+
+	g_return_val_if_fail (glob != NULL, TRUE);
+	g_return_val_if_fail (name != NULL, TRUE);
+
+	/* index + 1 of the last matching glob, 0 when none matched */
+	best = GPOINTER_TO_UINT (g_hash_table_lookup (glob->names, name));
+
+	if (glob->max_suffix > 0) {
+		len = strlen (name);
+		start = len > glob->max_suffix ? len - glob->max_suffix : 0;
+
+		/* the '*' may match nothing, so "*.c" matches ".c" too */
+		for (; start < len; ++start) {
+			guint index;
+
+			index = GPOINTER_TO_UINT (g_hash_table_lookup (glob->suffixes,
+								       name + start));
+			best = MAX (best, index);
+		}
+	}
+
+	/* Only the globs after the best match so far can change the verdict */
+	for (i = (gint) glob->specs->len - 1; i >= 0; --i) {
+		GlobSpec *spec = &g_array_index (glob->specs, GlobSpec, i);
+
+		if (spec->index + 1 <= best)
+			break;
+
+		if (g_pattern_match_string (spec->spec, name)) {
+			best = spec->index + 1;
+			break;
+		}
+	}
+
+	if (best == 0)
+		return !glob->has_include;
+
+	return !g_array_index (glob->exclude, gboolean, best - 1);
+}
+
+// ex:ts=8:noet:
@@ -0,0 +1,40 @@
+/*
+ * pluma-file-browser-glob.h - Pluma plugin providing easy file access
+ * from the sidepanel
+ *
+ * Copyright (C) 2012-2021 MATE Developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __PLUMA_FILE_BROWSER_GLOB_H__
+#define __PLUMA_FILE_BROWSER_GLOB_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _PlumaFileBrowserGlob PlumaFileBrowserGlob;
+
+PlumaFileBrowserGlob *pluma_file_browser_glob_new   (gchar const * patterns);
+void pluma_file_browser_glob_free                   (PlumaFileBrowserGlob * glob);
+gboolean pluma_file_browser_glob_match              (PlumaFileBrowserGlob * glob,
+                                                     gchar const * name);
+
+G_END_DECLS
+
+#endif /* __PLUMA_FILE_BROWSER_GLOB_H__ */
+
+// ex:ts=8:noet:
@@ -0,0 +1,387 @@
+/*
+ * pluma-file-browser-search.c - Pluma plugin providing easy file access
+ * from the sidepanel
+ *
+ * Copyright (C) 2012-2021 MATE Developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <string.h>
+
+#include "pluma-file-browser-search.h"
+#include "pluma-file-browser-glob.h"
+#include "pluma-file-browser-utils.h"
+
+#define SEARCH_ATTRIBUTES G_FILE_ATTRIBUTE_STANDARD_TYPE "," \
+			  G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN "," \
+			  G_FILE_ATTRIBUTE_STANDARD_IS_BACKUP "," \
+			  G_FILE_ATTRIBUTE_STANDARD_NAME "," \
+			  G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME "," \
+			  G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE "," \
+			  G_FILE_ATTRIBUTE_STANDARD_ICON
+
+/* Matches are handed to the main loop in batches of this size, or after
+ * this many microseconds, whatever comes first */
+#define SEARCH_BATCH_SIZE 64
+#define SEARCH_BATCH_INTERVAL (100 * 1000)
+
+typedef struct
+{
+	GFile *root;
+	gchar *text;
+	PlumaFileBrowserStoreFilterMode filter_mode;
+	PlumaFileBrowserGlob *glob;
+	guint max_results;
+
+	GMainContext *context;
+	PlumaFileBrowserSearchMatchFunc match_func;
+	gpointer match_data;
+} SearchData;
+
+typedef struct
+{
+	GTask *task;
+	GList *files;
+	GList *infos;
+} SearchBatch;
+
+static void
+search_data_free (SearchData *data)
+{
+	g_object_unref (data->root);
+	g_free (data->text);
+	pluma_file_browser_glob_free (data->glob);
+	g_main_context_unref (data->context);
+	g_free (data);
+}
+
+static void
+search_batch_free (SearchBatch *batch)
+{
+	g_object_unref (batch->task);
+	g_list_free_full (batch->files, g_object_unref);
+	g_list_free_full (batch->infos, g_object_unref);
+	g_free (batch);
+}
+
+static gboolean
+search_batch_deliver (gpointer user_data)
+{
+	SearchBatch *batch = user_data;
+	SearchData *data = g_task_get_task_data (batch->task);
+	GList *file;
+	GList *info;
+
+	/* Checked here, in the main loop, so that nothing is reported once
+	 * the caller cancelled the search */
+	if (g_cancellable_is_cancelled (g_task_get_cancellable (batch->task)))
+		return FALSE;
+
+	for (file = batch->files, info = batch->infos;
+	     file != NULL;
+	     file = file->next, info = info->next)
+	{
+		data->match_func (G_FILE (file->data),
+				  G_FILE_INFO (info->data),
+				  data->match_data);
+	}
+
+	return FALSE;
+}
+
+static void
+search_batch_flush (GTask *task,
+		    SearchBatch **batch)
+{
+	SearchData *data = g_task_get_task_data (task);
+
+	if (*batch == NULL)
+		return;
+
+	(*batch)->files = g_list_reverse ((*batch)->files);
+	(*batch)->infos = g_list_reverse ((*batch)->infos);
+
+	g_main_context_invoke_full (data->context,
+				    G_PRIORITY_DEFAULT,
+				    search_batch_deliver,
+				    *batch,
+				    (GDestroyNotify) search_batch_free);
+	*batch = NULL;
+}
+
+/* Same rules as the file browser store: hidden and backup files are
+ * hidden, files without a text content type are binary */
+static gboolean
+search_info_is_filtered (SearchData *data,
+			 GFileInfo  *info,
+			 gboolean    is_dir)
+{
+	if ((data->filter_mode & PLUMA_FILE_BROWSER_STORE_FILTER_MODE_HIDE_HIDDEN) &&
+	    (g_file_info_get_is_hidden (info) || g_file_info_get_is_backup (info)))
+		return TRUE;
+
+	if (is_dir)
+		return FALSE;
+
+	if ((data->filter_mode & PLUMA_FILE_BROWSER_STORE_FILTER_MODE_HIDE_BINARY) &&
+	    !pluma_file_browser_utils_file_info_is_text (info))
+		return TRUE;
+
+	if (data->glob != NULL &&
+	    !pluma_file_browser_glob_match (data->glob, g_file_info_get_name (info)))
+		return TRUE;
+
+	return FALSE;
+}
+
+static gboolean
+search_info_matches (SearchData *data,
+		     GFileInfo  *info)
+{
+	gchar *name;
+	gboolean ret;
+
+	name = g_utf8_casefold (g_file_info_get_display_name (info), -1);
+	ret = strstr (name, data->text) != NULL;
+	g_free (name);
+
+	return ret;
+}
+
+static void
+search_thread (GTask        *task,
+	       gpointer      source_object,
+	       gpointer      task_data,
+	       GCancellable *cancellable)
+{
+	SearchData *data = task_data;
+	GQueue dirs = G_QUEUE_INIT;
+	SearchBatch *batch = NULL;
+	gint64 last_flush;
+	guint found = 0;
+	gboolean truncated = FALSE;
+	GError *error = NULL;
+
+	last_flush = g_get_monotonic_time ();
+	g_queue_push_tail (&dirs, g_object_ref (data->root));
+
+	/* Breadth first, so that the closest matches come first */
+	while (!g_queue_is_empty (&dirs) && !truncated) {
+		GFile *dir;
+		GFileEnumerator *enumerator;
+		GFileInfo *info;
+
+		if (g_cancellable_is_cancelled (cancellable))
+			break;
+
+		dir = g_queue_pop_head (&dirs);
+
+		/* Symbolic links are not followed, which also keeps us out of
+		 * loops */
+		enumerator = g_file_enumerate_children (dir,
+							SEARCH_ATTRIBUTES,
+							G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+							cancellable,
+							dir == data->root ? &error : NULL);
+
+		if (enumerator == NULL) {
+			g_object_unref (dir);
+
+			/* Unreadable directories below the root are skipped */
+			if (error != NULL)
+				break;
+
+			continue;
+		}
+
+		while (!truncated &&
+		       (info = g_file_enumerator_next_file (enumerator, cancellable, NULL)) != NULL)
+		{
+			GFileType type;
+			gboolean is_dir;
+			gboolean is_link;
+
+			type = g_file_info_get_file_type (info);
+			is_link = type == G_FILE_TYPE_SYMBOLIC_LINK;
+
+			/* The tree shows links as their target: filter and
+			 * match on that, but do not walk into linked
+			 * directories */
+			if (is_link) {
+				GFile *child;
+				GFileInfo *target;
+
+				child = g_file_get_child (dir, g_file_info_get_name (info));
+				target = g_file_query_info (child,
+							    SEARCH_ATTRIBUTES,
+							    G_FILE_QUERY_INFO_NONE,
+							    cancellable,
+							    NULL);
+				g_object_unref (child);
+				g_object_unref (info);
+
+				/* dangling */
+				if (target == NULL)
+					continue;
+
+				info = target;
+				type = g_file_info_get_file_type (info);
+			}
+
+			is_dir = type == G_FILE_TYPE_DIRECTORY;
+
+			if ((!is_dir && type != G_FILE_TYPE_REGULAR) ||
+			    (is_dir && is_link) ||
+			    search_info_is_filtered (data, info, is_dir))
+			{
+				g_object_unref (info);
+				continue;
+			}
+
+			if (is_dir) {
+				g_queue_push_tail (&dirs,
+						   g_file_get_child (dir, g_file_info_get_name (info)));
+			} else if (search_info_matches (data, info)) {
+				if (found == data->max_results) {
+					truncated = TRUE;
+					g_object_unref (info);
+					break;
+				}
+
+				if (batch == NULL) {
+					batch = g_new0 (SearchBatch, 1);
+					batch->task = g_object_ref (task);
+				}
+
+				batch->files = g_list_prepend (batch->files,
+							       g_file_get_child (dir, g_file_info_get_name (info)));
+				batch->infos = g_list_prepend (batch->infos, g_object_ref (info));
+				++found;
+
+				if (found % SEARCH_BATCH_SIZE == 0 ||
+				    g_get_monotonic_time () - last_flush > SEARCH_BATCH_INTERVAL)
+				{
+					search_batch_flush (task, &batch);
+					last_flush = g_get_monotonic_time ();
+				}
+			}
+
+			g_object_unref (info);
+		}
+
+		g_file_enumerator_close (enumerator, NULL, NULL);
+		g_object_unref (enumerator);
+		g_object_unref (dir);
+
+		/* Do not sit on a few matches while walking a large tree */
+		if (batch != NULL &&
+		    g_get_monotonic_time () - last_flush > SEARCH_BATCH_INTERVAL)
+		{
+			search_batch_flush (task, &batch);
+			last_flush = g_get_monotonic_time ();
+		}
+	}
+
+	while (!g_queue_is_empty (&dirs))
+		g_object_unref (g_queue_pop_head (&dirs));
+
+	search_batch_flush (task, &batch);
+
+	if (error != NULL)
+		g_task_return_error (task, error);
+	else if (!g_task_return_error_if_cancelled (task))
+		g_task_return_boolean (task, truncated);
+}
+
+/**
+ * pluma_file_browser_search_async:
+ * @root: the directory to search in
+ * @text: the text to look for in the file names
+ * @filter_mode: the filter mode of the file browser store
+ * @filter_pattern: (allow-none): the filter pattern of the file browser
+ * @max_results: stop after this many matches
+ * @cancellable: a #GCancellable
+ * @match_func: called for every match, in batches
+ * @match_data: data for @match_func
+ * @callback: called when the search is over
+ * @user_data: data for @callback
+ *
+ * Looks for the files below @root whose name contains @text, ignoring
+ * the case, in a worker thread. The files and directories hidden by
+ * @filter_mode and @filter_pattern are skipped, as in the file browser.
+ **/
+void
+pluma_file_browser_search_async (GFile * root,
+				 gchar const * text,
+				 PlumaFileBrowserStoreFilterMode filter_mode,
+				 gchar const * filter_pattern,
+				 guint max_results,
+				 GCancellable * cancellable,
+				 PlumaFileBrowserSearchMatchFunc match_func,
+				 gpointer match_data,
+				 GAsyncReadyCallback callback,
+				 gpointer user_data)
+{
+	SearchData *data;
+	GTask *task;
+
+	g_return_if_fail (G_IS_FILE (root));
+	g_return_if_fail (text != NULL);
+	g_return_if_fail (match_func != NULL);
+
+	data = g_new0 (SearchData, 1);
+	data->root = g_object_ref (root);
+	data->text = g_utf8_casefold (text, -1);
+	data->filter_mode = filter_mode;
+	data->max_results = max_results;
+	data->context = g_main_context_ref_thread_default ();
+	data->match_func = match_func;
+	data->match_data = match_data;
+
+	/* A private copy, the thread must not share the one of the widget */
+	if (filter_pattern != NULL)
+		data->glob = pluma_file_browser_glob_new (filter_pattern);
+
+	task = g_task_new (NULL, cancellable, callback, user_data);
+	g_task_set_task_data (task, data, (GDestroyNotify) search_data_free);
+	g_task_run_in_thread (task, search_thread);
+	g_object_unref (task);
+}
+
+gboolean
+pluma_file_browser_search_finish (GAsyncResult * result,
+				  gboolean * truncated,
+				  GError ** error)
+{
+	GError *err = NULL;
+	gboolean ret;
+
+	g_return_val_if_fail (G_IS_TASK (result), FALSE);
+
+	ret = g_task_propagate_boolean (G_TASK (result), &err);
+
+	if (err != NULL) {
+		g_propagate_error (error, err);
+		return FALSE;
+	}
+
+	if (truncated != NULL)
+		*truncated = ret;
+
+	return TRUE;
+}
+
+// ex:ts=8:noet:
@@ -0,0 +1,55 @@
+/*
+ * pluma-file-browser-search.h - Pluma plugin providing easy file access
+ * from the sidepanel
+ *
+ * Copyright (C) 2012-2021 MATE Developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __PLUMA_FILE_BROWSER_SEARCH_H__
+#define __PLUMA_FILE_BROWSER_SEARCH_H__
+
+#include <gio/gio.h>
+
+#include "pluma-file-browser-store.h"
+
+G_BEGIN_DECLS
+
+/* Called in the thread default main context of the caller, never after
+ * the search got cancelled */
+typedef void (*PlumaFileBrowserSearchMatchFunc) (GFile * file,
+						 GFileInfo * info,
+						 gpointer user_data);
+
+void pluma_file_browser_search_async         (GFile * root,
+                                              gchar const * text,
+                                              PlumaFileBrowserStoreFilterMode filter_mode,
+                                              gchar const * filter_pattern,
+                                              guint max_results,
+                                              GCancellable * cancellable,
+                                              PlumaFileBrowserSearchMatchFunc match_func,
+                                              gpointer match_data,
+                                              GAsyncReadyCallback callback,
+                                              gpointer user_data);
+gboolean pluma_file_browser_search_finish    (GAsyncResult * result,
+                                              gboolean * truncated,
+                                              GError ** error);
+
+G_END_DECLS
+
+#endif /* __PLUMA_FILE_BROWSER_SEARCH_H__ */
+
+// ex:ts=8:noet:
@@ -43,6 +43,7 @@
 #define FILE_BROWSER_NODE_DIR(node)	((FileBrowserNodeDir *)(node))
 
 #define DIRECTORY_LOAD_ITEMS_PER_CALLBACK 100
+#define MONITOR_EVENTS_DELAY 200 /* ms to collect monitor events before applying them */
 #define STANDARD_ATTRIBUTE_TYPES G_FILE_ATTRIBUTE_STANDARD_TYPE "," \
 				 G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN "," \
 			 	 G_FILE_ATTRIBUTE_STANDARD_IS_BACKUP "," \
@@ -94,6 +95,11 @@ struct _FileBrowserNode
 	FileBrowserNode *parent;
 	gint pos;
 	gboolean inserted;
+
+	/* Verdict of the filter function, valid while filter_stamp matches
+	 * the one of the model */
+	guint filter_stamp;
+	gboolean filter_result;
 };
 
 struct _FileBrowserNodeDir
@@ -104,6 +110,11 @@ struct _FileBrowserNodeDir
 	GCancellable *cancellable;
 	GFileMonitor *monitor;
 	PlumaFileBrowserStore *model;
+
+	/* Monitor events waiting to be applied, GFile -> GFileMonitorEvent */
+	GHashTable *monitor_events;
+	guint monitor_events_id;
+	GCancellable *monitor_cancellable;
 };
 
 struct _PlumaFileBrowserStorePrivate
@@ -115,6 +126,7 @@ struct _PlumaFileBrowserStorePrivate
 	PlumaFileBrowserStoreFilterMode filter_mode;
 	PlumaFileBrowserStoreFilterFunc filter_func;
 	gpointer filter_user_data;
+	guint filter_stamp;
 
 	SortFunc sort_func;
 
@@ -462,6 +474,7 @@ pluma_file_browser_store_init (PlumaFileBrowserStore * obj)
 
 	// Default filter mode is hiding the hidden files
 	obj->priv->filter_mode = pluma_file_browser_store_filter_mode_get_default ();
+	obj->priv->filter_stamp = 1;
 	obj->priv->sort_func = model_sort_default;
 }
 
@@ -999,16 +1012,30 @@ model_node_update_visibility (PlumaFileBrowserStore * model,
 		 (!NODE_IS_TEXT (node) && !NODE_IS_DIR (node)))
 		node->flags |= PLUMA_FILE_BROWSER_STORE_FLAG_IS_FILTERED;
 	else if (model->priv->filter_func) {
-		iter.user_data = node;
+		if (node->filter_stamp != model->priv->filter_stamp) {
+			iter.user_data = node;
+
+			node->filter_result =
+			    model->priv->filter_func (model, &iter,
+						      model->priv->filter_user_data);
+			node->filter_stamp = model->priv->filter_stamp;
+		}
 
-		if (!model->priv->
-		    filter_func (model, &iter,
-				 model->priv->filter_user_data))
+		if (!node->filter_result)
 			node->flags |=
 			    PLUMA_FILE_BROWSER_STORE_FLAG_IS_FILTERED;
 	}
 }
 
+/* Forget the cached verdicts of the filter function of all the nodes */
+static void
+model_invalidate_filter (PlumaFileBrowserStore * model)
+{
+	/* 0 is the stamp of nodes that never went through the filter */
+	if (++model->priv->filter_stamp == 0)
+		model->priv->filter_stamp = 1;
+}
+
 static gint
 collate_nodes (FileBrowserNode * node1, FileBrowserNode * node2)
 {
@@ -1263,6 +1290,7 @@ static void
 file_browser_node_set_name (FileBrowserNode * node)
 {
 	g_free (node->name);
+	node->filter_stamp = 0;
 
 	if (node->file) {
 		node->name = pluma_file_browser_utils_file_basename (node->file);
@@ -1332,6 +1360,26 @@ file_browser_node_free_children (PlumaFileBrowserStore * model,
 	}
 }
 
+static void
+file_browser_node_cancel_monitor_events (FileBrowserNodeDir * dir)
+{
+	if (dir->monitor_events_id != 0) {
+		g_source_remove (dir->monitor_events_id);
+		dir->monitor_events_id = 0;
+	}
+
+	if (dir->monitor_events != NULL) {
+		g_hash_table_destroy (dir->monitor_events);
+		dir->monitor_events = NULL;
+	}
+
+	if (dir->monitor_cancellable != NULL) {
+		g_cancellable_cancel (dir->monitor_cancellable);
+		g_object_unref (dir->monitor_cancellable);
+		dir->monitor_cancellable = NULL;
+	}
+}
+
 static void
 file_browser_node_free (PlumaFileBrowserStore * model,
 			FileBrowserNode * node)
@@ -1360,6 +1408,8 @@ file_browser_node_free (PlumaFileBrowserStore * model,
 			g_file_monitor_cancel (dir->monitor);
 			g_object_unref (dir->monitor);
 		}
+
+		file_browser_node_cancel_monitor_events (dir);
 	}
 
 	if (node->file)
@@ -1577,6 +1627,8 @@ file_browser_node_unload (PlumaFileBrowserStore * model,
 		dir->monitor = NULL;
 	}
 
+	file_browser_node_cancel_monitor_events (dir);
+
 	node->flags &= ~PLUMA_FILE_BROWSER_STORE_FLAG_LOADED;
 }
 
@@ -1876,34 +1928,19 @@ model_add_nodes_batch (PlumaFileBrowserStore * model,
 	}
 }
 
-static gchar const *
-backup_content_type (GFileInfo * info)
-{
-	gchar const * content;
-
-	if (!g_file_info_get_is_backup (info))
-		return NULL;
-
-	content = g_file_info_get_content_type (info);
-
-	if (!content || g_content_type_equals (content, "application/x-trash"))
-		return "text/plain";
-
-	return content;
-}
-
 static void
 file_browser_node_set_from_info (PlumaFileBrowserStore * model,
 				 FileBrowserNode * node,
 				 GFileInfo * info,
 				 gboolean isadded)
 {
-	gchar const * content;
 	gboolean free_info = FALSE;
 	GtkTreePath * path;
 	gchar * uri;
 	GError * error = NULL;
 
+	node->filter_stamp = 0;
+
 	if (info == NULL) {
 		info = g_file_query_info (node->file,
 					  STANDARD_ATTRIBUTE_TYPES,
@@ -1930,15 +1967,8 @@ file_browser_node_set_from_info (PlumaFileBrowserStore * model,
 
 	if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY)
 		node->flags |= PLUMA_FILE_BROWSER_STORE_FLAG_IS_DIRECTORY;
-	else {
-		if (!(content = backup_content_type (info)))
-			content = g_file_info_get_content_type (info);
-
-		if (!content ||
-		    g_content_type_is_unknown (content) ||
-		    g_content_type_is_a (content, "text/plain"))
-			node->flags |= PLUMA_FILE_BROWSER_STORE_FLAG_IS_TEXT;
-	}
+	else if (pluma_file_browser_utils_file_info_is_text (info))
+		node->flags |= PLUMA_FILE_BROWSER_STORE_FLAG_IS_TEXT;
 
 	model_recomposite_icon_real (model, node, info);
 
@@ -2103,6 +2133,237 @@ model_add_node_from_dir (PlumaFileBrowserStore * model,
 	return node;
 }
 
+static gboolean model_apply_monitor_events (gpointer data);
+
+static void
+file_info_list_free (GList * infos)
+{
+	g_list_free_full (infos, g_object_unref);
+}
+
+static void
+query_created_files_thread (GTask * task,
+			    gpointer source_object,
+			    gpointer task_data,
+			    GCancellable * cancellable)
+{
+	GList *item;
+	GList *infos = NULL;
+
+	for (item = task_data; item; item = item->next) {
+		GFileInfo *info;
+
+		if (g_task_return_error_if_cancelled (task)) {
+			file_info_list_free (infos);
+			return;
+		}
+
+		info = g_file_query_info (G_FILE (item->data),
+					  STANDARD_ATTRIBUTE_TYPES,
+					  G_FILE_QUERY_INFO_NONE,
+					  cancellable,
+					  NULL);
+
+		/* The file may be gone again already */
+		if (info != NULL)
+			infos = g_list_prepend (infos, info);
+	}
+
+	g_task_return_pointer (task, infos, (GDestroyNotify) file_info_list_free);
+}
+
+/* Updates @node from the fresh @info of its file */
+static void
+model_refresh_node (PlumaFileBrowserStore * model,
+		    FileBrowserNode * node,
+		    GFileInfo * info)
+{
+	GtkTreePath *path;
+	GtkTreeIter iter;
+
+	node->flags &= ~(PLUMA_FILE_BROWSER_STORE_FLAG_IS_HIDDEN |
+			 PLUMA_FILE_BROWSER_STORE_FLAG_IS_TEXT);
+
+	file_browser_node_set_from_info (model, node, info, TRUE);
+
+	if (model_node_visibility (model, node)) {
+		path = pluma_file_browser_store_get_path_real (model, node);
+		iter.user_data = node;
+		row_changed (model, &path, &iter);
+		gtk_tree_path_free (path);
+	}
+}
+
+static void
+created_files_queried (GObject * source,
+		       GAsyncResult * result,
+		       gpointer user_data)
+{
+	PlumaFileBrowserStore *model = PLUMA_FILE_BROWSER_STORE (source);
+	FileBrowserNode *parent = user_data;
+	FileBrowserNodeDir *dir;
+	GHashTable *children;
+	GSList *item;
+	GSList *replaced = NULL;
+	GList *infos;
+	GList *l;
+	GList *next;
+	GError *error = NULL;
+
+	infos = g_task_propagate_pointer (G_TASK (result), &error);
+
+	/* Only cancelled: the directory was unloaded or freed */
+	if (error != NULL) {
+		g_error_free (error);
+		return;
+	}
+
+	dir = FILE_BROWSER_NODE_DIR (parent);
+	g_clear_object (&dir->monitor_cancellable);
+
+	/* The files we already have were re-created, or added in the
+	 * meantime, e.g. by pluma_file_browser_store_new_file: refresh
+	 * their node instead of adding another one */
+	children = g_hash_table_new ((GHashFunc) g_file_hash, (GEqualFunc) g_file_equal);
+
+	for (item = dir->children; item; item = item->next) {
+		FileBrowserNode *node = item->data;
+
+		if (node->file != NULL)
+			g_hash_table_insert (children, node->file, node);
+	}
+
+	for (l = infos; l; l = next) {
+		FileBrowserNode *node;
+		GFile *file;
+		gboolean is_dir;
+
+		next = l->next;
+		file = g_file_get_child (parent->file, g_file_info_get_name (l->data));
+		node = g_hash_table_lookup (children, file);
+		g_object_unref (file);
+
+		if (node == NULL)
+			continue;
+
+		is_dir = g_file_info_get_file_type (l->data) == G_FILE_TYPE_DIRECTORY;
+
+		/* A directory became a file or the other way around: the
+		 * node is replaced, as it has to be another kind of node */
+		if (is_dir != (NODE_IS_DIR (node) != 0)) {
+			replaced = g_slist_prepend (replaced, node);
+			continue;
+		}
+
+		model_refresh_node (model, node, l->data);
+
+		g_object_unref (l->data);
+		infos = g_list_delete_link (infos, l);
+	}
+
+	g_hash_table_destroy (children);
+
+	for (item = replaced; item; item = item->next)
+		model_remove_node (model, (FileBrowserNode *) (item->data), NULL, TRUE);
+
+	g_slist_free (replaced);
+
+	/* Sorted insertion of all the new nodes at once */
+	model_add_nodes_from_files (model, parent, NULL, infos);
+	g_list_free (infos);
+
+	model_check_dummy (model, parent);
+
+	/* Apply what came in while querying */
+	if (dir->monitor_events != NULL && dir->monitor_events_id == 0)
+		dir->monitor_events_id = g_timeout_add (MONITOR_EVENTS_DELAY,
+							model_apply_monitor_events,
+							parent);
+}
+
+static gboolean
+model_apply_monitor_events (gpointer data)
+{
+	FileBrowserNode *parent = data;
+	FileBrowserNodeDir *dir = FILE_BROWSER_NODE_DIR (parent);
+	PlumaFileBrowserStore *model = dir->model;
+	GHashTable *events;
+	GHashTableIter iter;
+	gpointer key;
+	gpointer value;
+	GSList *item;
+	GSList *removed = NULL;
+	FileBrowserNode *removed_root = NULL;
+	GList *created = NULL;
+
+	dir->monitor_events_id = 0;
+
+	/* Wait for the previous batch, events must be applied in order */
+	if (dir->monitor_cancellable != NULL)
+		return FALSE;
+
+	events = dir->monitor_events;
+	dir->monitor_events = NULL;
+
+	if (events == NULL)
+		return FALSE;
+
+	/* A single walk over the children finds the deleted nodes. Created
+	 * files we already have were deleted and created again within the
+	 * delay, they are queried too and their node is refreshed */
+	for (item = dir->children; item; item = item->next) {
+		FileBrowserNode *node = item->data;
+
+		if (node->file == NULL ||
+		    !g_hash_table_lookup_extended (events, node->file, NULL, &value) ||
+		    GPOINTER_TO_INT (value) != G_FILE_MONITOR_EVENT_DELETED)
+			continue;
+
+		/* Removing the virtual root changes the tree under us, keep
+		 * it for the end */
+		if (node == model->priv->virtual_root ||
+		    node_has_parent (model->priv->virtual_root, node))
+			removed_root = node;
+		else
+			removed = g_slist_prepend (removed, node);
+
+		g_hash_table_remove (events, node->file);
+	}
+
+	for (item = removed; item; item = item->next)
+		model_remove_node (model, (FileBrowserNode *) (item->data), NULL, TRUE);
+
+	g_slist_free (removed);
+
+	g_hash_table_iter_init (&iter, events);
+
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		if (GPOINTER_TO_INT (value) == G_FILE_MONITOR_EVENT_CREATED)
+			created = g_list_prepend (created, g_object_ref (key));
+	}
+
+	g_hash_table_destroy (events);
+
+	if (created != NULL) {
+		GTask *task;
+
+		dir->monitor_cancellable = g_cancellable_new ();
+
+		task = g_task_new (model,
+				   dir->monitor_cancellable,
+				   created_files_queried,
+				   parent);
+		g_task_set_task_data (task, created, (GDestroyNotify) file_info_list_free);
+		g_task_run_in_thread (task, query_created_files_thread);
+		g_object_unref (task);
+	}
+
+	if (removed_root != NULL)
+		model_remove_node (model, removed_root, NULL, TRUE);
+
+	return FALSE;
+}
+
 static void
 on_directory_monitor_event (GFileMonitor * monitor,
 			    GFile * file,
@@ -2110,22 +2371,28 @@ on_directory_monitor_event (GFileMonitor * monitor,
 			    GFileMonitorEvent event_type,
 			    FileBrowserNode * parent)
 {
-	FileBrowserNode *node;
 	FileBrowserNodeDir *dir = FILE_BROWSER_NODE_DIR (parent);
 
 	switch (event_type) {
 	case G_FILE_MONITOR_EVENT_DELETED:
-		node = node_list_contains_file (dir->children, file);
-
-		if (node != NULL) {
-			model_remove_node (dir->model, node, NULL, TRUE);
-		}
-		break;
 	case G_FILE_MONITOR_EVENT_CREATED:
-		if (g_file_query_exists (file, NULL)) {
-			model_add_node_from_file (dir->model, parent, file, NULL);
-		}
-
+		/* Events are collected for a while and applied together, a
+		 * checkout or a build can easily touch thousands of files */
+		if (dir->monitor_events == NULL)
+			dir->monitor_events = g_hash_table_new_full ((GHashFunc) g_file_hash,
+								     (GEqualFunc) g_file_equal,
+								     g_object_unref,
+								     NULL);
+
+		/* Only the last event for a file matters */
+		g_hash_table_replace (dir->monitor_events,
+				      g_object_ref (file),
+				      GINT_TO_POINTER (event_type));
+
+		if (dir->monitor_events_id == 0 && dir->monitor_cancellable == NULL)
+			dir->monitor_events_id = g_timeout_add (MONITOR_EVENTS_DELAY,
+								model_apply_monitor_events,
+								parent);
 		break;
 	default:
 		break;
@@ -3093,12 +3360,14 @@ pluma_file_browser_store_set_filter_func (PlumaFileBrowserStore * model,
 
 	model->priv->filter_func = func;
 	model->priv->filter_user_data = user_data;
+	model_invalidate_filter (model);
 	model_refilter (model);
 }
 
 void
 pluma_file_browser_store_refilter (PlumaFileBrowserStore * model)
 {
+	model_invalidate_filter (model);
 	model_refilter (model);
 }
 
@@ -148,6 +148,38 @@ pluma_file_browser_utils_uri_basename (gchar const * uri)
 	return pluma_utils_basename_for_display (uri);
 }
 
+static gchar const *
+backup_content_type (GFileInfo * info)
+{
+	gchar const * content;
+
+	if (!g_file_info_get_is_backup (info))
+		return NULL;
+
+	content = g_file_info_get_content_type (info);
+
+	if (!content || g_content_type_equals (content, "application/x-trash"))
+		return "text/plain";
+
+	return content;
+}
+
+/* Whether the file of @info, which needs the standard::content-type and
+ * standard::is-backup attributes, counts as text for the binary filter.
+ * Also called from the search thread. */
+gboolean
+pluma_file_browser_utils_file_info_is_text (GFileInfo * info)
+{
+	gchar const * content;
+
+	if (!(content = backup_content_type (info)))
+		content = g_file_info_get_content_type (info);
+
+	return !content ||
+	       g_content_type_is_unknown (content) ||
+	       g_content_type_is_a (content, "text/plain");
+}
+
 gboolean
 pluma_file_browser_utils_confirmation_dialog (PlumaWindow * window,
                                               GtkMessageType type,
@@ -15,6 +15,8 @@ GdkPixbuf *pluma_file_browser_utils_pixbuf_from_file	  (GFile * file,
 gchar * pluma_file_browser_utils_file_basename		  (GFile * file);
 gchar * pluma_file_browser_utils_uri_basename             (gchar const * uri);
 
+gboolean pluma_file_browser_utils_file_info_is_text       (GFileInfo * info);
+
 gboolean pluma_file_browser_utils_confirmation_dialog     (PlumaWindow * window,
                                                            GtkMessageType type,
                                                            gchar const *message,
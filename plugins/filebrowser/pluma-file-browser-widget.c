@@ -35,6 +35,8 @@
 #include <pluma/pluma-utils.h>
 
 #include "pluma-file-browser-utils.h"
+#include "pluma-file-browser-glob.h"
+#include "pluma-file-browser-search.h"
 #include "pluma-file-browser-error.h"
 #include "pluma-file-browser-widget.h"
 #include "pluma-file-browser-view.h"
@@ -111,6 +113,18 @@ typedef struct
 	GdkPixbuf *icon;
 } NameIcon;
 
+/* Stop a search after this many matches */
+#define SEARCH_MAX_RESULTS 1000
+
+enum
+{
+	SEARCH_COLUMN_ICON = 0,
+	SEARCH_COLUMN_NAME,
+	SEARCH_COLUMN_LOCATION,
+	SEARCH_COLUMN_URI,
+	SEARCH_N_COLUMNS
+};
+
 struct _PlumaFileBrowserWidgetPrivate
 {
 	PlumaFileBrowserView *treeview;
@@ -125,6 +139,16 @@ struct _PlumaFileBrowserWidgetPrivate
 	GtkWidget *filter_expander;
 	GtkWidget *filter_entry;
 
+	GtkWidget *tree_sw;
+	GtkWidget *search_expander;
+	GtkWidget *search_entry;
+	GtkWidget *search_label;
+	GtkWidget *search_sw;
+	GtkWidget *search_view;
+	GtkListStore *search_store;
+	GFile *search_root;
+	GCancellable *search_cancellable;
+
 	GtkUIManager *manager;
 	GtkActionGroup *action_group;
 	GtkActionGroup *action_group_selection;
@@ -139,7 +163,7 @@ struct _PlumaFileBrowserWidgetPrivate
 	GSList *filter_funcs;
 	gulong filter_id;
 	gulong glob_filter_id;
-	GPatternSpec *filter_pattern;
+	PlumaFileBrowserGlob *filter_pattern;
 	gchar *filter_pattern_str;
 
 	GList *locations;
@@ -202,6 +226,14 @@ static void on_bookmarks_row_deleted           (GtkTreeModel * model,
 static void on_filter_mode_changed	       (PlumaFileBrowserStore * model,
                                                 GParamSpec * param,
                                                 PlumaFileBrowserWidget * obj);
+static void on_search_row_activated            (GtkTreeView * view,
+						GtkTreePath * path,
+						GtkTreeViewColumn * column,
+						PlumaFileBrowserWidget * obj);
+static void search_cancel                      (PlumaFileBrowserWidget * obj);
+static void search_start                       (PlumaFileBrowserWidget * obj);
+static void search_stop                        (PlumaFileBrowserWidget * obj);
+static void search_restart                     (PlumaFileBrowserWidget * obj);
 static void on_action_directory_previous       (GtkAction * action,
 						PlumaFileBrowserWidget * obj);
 static void on_action_directory_next           (GtkAction * action,
@@ -344,6 +376,19 @@ pluma_file_browser_widget_finalize (GObject * object)
 	g_object_unref (obj->priv->combo_model);
 
 	g_slist_free_full (obj->priv->filter_funcs, g_free);
+	pluma_file_browser_glob_free (obj->priv->filter_pattern);
+	g_free (obj->priv->filter_pattern_str);
+
+	if (obj->priv->search_cancellable != NULL) {
+		g_cancellable_cancel (obj->priv->search_cancellable);
+		g_object_unref (obj->priv->search_cancellable);
+	}
+
+	if (obj->priv->search_root != NULL)
+		g_object_unref (obj->priv->search_root);
+
+	if (obj->priv->search_store != NULL)
+		g_object_unref (obj->priv->search_store);
 
 	for (loc = obj->priv->locations; loc; loc = loc->next)
 		location_free ((Location *) (loc->data));
@@ -1180,6 +1225,8 @@ create_tree (PlumaFileBrowserWidget * obj)
 			   GTK_WIDGET (obj->priv->treeview));
 	gtk_box_pack_start (GTK_BOX (obj), sw, TRUE, TRUE, 0);
 
+	obj->priv->tree_sw = sw;
+
 	g_signal_connect (obj->priv->treeview, "notify::model",
 			  G_CALLBACK (on_model_set), obj);
 	g_signal_connect (obj->priv->treeview, "error",
@@ -1248,6 +1295,117 @@ create_filter (PlumaFileBrowserWidget * obj)
 	gtk_container_add (GTK_CONTAINER (expander), vbox);
 }
 
+static void
+create_search (PlumaFileBrowserWidget * obj)
+{
+	GtkWidget *expander;
+	GtkWidget *vbox;
+	GtkWidget *entry;
+	GtkWidget *label;
+	GtkWidget *sw;
+	GtkWidget *view;
+	GtkTreeViewColumn *column;
+	GtkCellRenderer *renderer;
+	gint position;
+
+	/* The results take the place of the tree while searching */
+	obj->priv->search_store = gtk_list_store_new (SEARCH_N_COLUMNS,
+						      GDK_TYPE_PIXBUF,
+						      G_TYPE_STRING,
+						      G_TYPE_STRING,
+						      G_TYPE_STRING);
+
+	view = gtk_tree_view_new_with_model (GTK_TREE_MODEL (obj->priv->search_store));
+	gtk_tree_view_set_headers_visible (GTK_TREE_VIEW (view), FALSE);
+	gtk_tree_view_set_tooltip_column (GTK_TREE_VIEW (view), SEARCH_COLUMN_LOCATION);
+	gtk_tree_view_set_activate_on_single_click (GTK_TREE_VIEW (view), FALSE);
+	gtk_widget_show (view);
+
+	column = gtk_tree_view_column_new ();
+
+	renderer = gtk_cell_renderer_pixbuf_new ();
+	gtk_tree_view_column_pack_start (column, renderer, FALSE);
+	gtk_tree_view_column_add_attribute (column, renderer,
+					    "pixbuf", SEARCH_COLUMN_ICON);
+
+	renderer = gtk_cell_renderer_text_new ();
+	gtk_tree_view_column_pack_start (column, renderer, TRUE);
+	gtk_tree_view_column_add_attribute (column, renderer,
+					    "text", SEARCH_COLUMN_NAME);
+
+	gtk_tree_view_append_column (GTK_TREE_VIEW (view), column);
+
+	column = gtk_tree_view_column_new ();
+
+	renderer = gtk_cell_renderer_text_new ();
+	g_object_set (renderer,
+		      "ellipsize", PANGO_ELLIPSIZE_START,
+		      "sensitive", FALSE,
+		      NULL);
+	gtk_tree_view_column_pack_start (column, renderer, TRUE);
+	gtk_tree_view_column_add_attribute (column, renderer,
+					    "text", SEARCH_COLUMN_LOCATION);
+
+	gtk_tree_view_append_column (GTK_TREE_VIEW (view), column);
+
+	g_signal_connect (view, "row-activated",
+			  G_CALLBACK (on_search_row_activated), obj);
+
+	obj->priv->search_view = view;
+
+	sw = gtk_scrolled_window_new (NULL, NULL);
+	gtk_scrolled_window_set_shadow_type (GTK_SCROLLED_WINDOW (sw),
+					     GTK_SHADOW_ETCHED_IN);
+	gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (sw),
+					GTK_POLICY_AUTOMATIC,
+					GTK_POLICY_AUTOMATIC);
+	gtk_container_add (GTK_CONTAINER (sw), view);
+
+	/* Right below the tree */
+	gtk_box_pack_start (GTK_BOX (obj), sw, TRUE, TRUE, 0);
+	gtk_container_child_get (GTK_CONTAINER (obj), obj->priv->tree_sw,
+				 "position", &position, NULL);
+	gtk_box_reorder_child (GTK_BOX (obj), sw, position + 1);
+
+	obj->priv->search_sw = sw;
+
+	expander = gtk_expander_new_with_mnemonic (_("_Search Files"));
+	gtk_widget_show (expander);
+	gtk_box_pack_start (GTK_BOX (obj), expander, FALSE, FALSE, 0);
+
+	obj->priv->search_expander = expander;
+
+	vbox = gtk_box_new (GTK_ORIENTATION_VERTICAL, 3);
+	gtk_widget_show (vbox);
+
+	entry = gtk_search_entry_new ();
+	gtk_widget_set_tooltip_text (entry,
+				     _("Search the files below the current folder by name"));
+	gtk_widget_show (entry);
+
+	obj->priv->search_entry = entry;
+
+	/* Stop the running search right away, the new one starts once the
+	 * user stops typing */
+	g_signal_connect_swapped (entry, "changed",
+				  G_CALLBACK (search_cancel), obj);
+	g_signal_connect_swapped (entry, "search-changed",
+				  G_CALLBACK (search_start), obj);
+	g_signal_connect_swapped (entry, "stop-search",
+				  G_CALLBACK (search_stop), obj);
+
+	gtk_box_pack_start (GTK_BOX (vbox), entry, FALSE, FALSE, 0);
+
+	label = gtk_label_new (NULL);
+	gtk_label_set_xalign (GTK_LABEL (label), 0.0);
+	gtk_label_set_line_wrap (GTK_LABEL (label), TRUE);
+
+	obj->priv->search_label = label;
+
+	gtk_box_pack_start (GTK_BOX (vbox), label, FALSE, FALSE, 0);
+	gtk_container_add (GTK_CONTAINER (expander), vbox);
+}
+
 static void
 pluma_file_browser_widget_init (PlumaFileBrowserWidget * obj)
 {
@@ -1391,8 +1549,8 @@ filter_glob (PlumaFileBrowserWidget * obj, PlumaFileBrowserStore * store,
 		result = TRUE;
 	else
 		result =
-		    g_pattern_match_string (obj->priv->filter_pattern,
-					    name);
+		    pluma_file_browser_glob_match (obj->priv->filter_pattern,
+						   name);
 
 	g_free (name);
 
@@ -1737,10 +1895,7 @@ set_filter_pattern_real (PlumaFileBrowserWidget * obj,
                         gchar const * pattern,
                         gboolean update_entry)
 {
-	GtkTreeModel *model;
-
-	model =
-	    gtk_tree_view_get_model (GTK_TREE_VIEW (obj->priv->treeview));
+	gboolean refiltered = FALSE;
 
 	if (pattern != NULL && *pattern == '\0')
 		pattern = NULL;
@@ -1757,27 +1912,31 @@ set_filter_pattern_real (PlumaFileBrowserWidget * obj,
 	obj->priv->filter_pattern_str = g_strdup (pattern);
 
 	if (obj->priv->filter_pattern) {
-		g_pattern_spec_free (obj->priv->filter_pattern);
+		pluma_file_browser_glob_free (obj->priv->filter_pattern);
 		obj->priv->filter_pattern = NULL;
 	}
 
-	if (pattern == NULL) {
+	if (pattern != NULL)
+		obj->priv->filter_pattern = pluma_file_browser_glob_new (pattern);
+
+	if (obj->priv->filter_pattern == NULL) {
 		if (obj->priv->glob_filter_id != 0) {
 			pluma_file_browser_widget_remove_filter (obj,
 								 obj->
 								 priv->
 								 glob_filter_id);
 			obj->priv->glob_filter_id = 0;
+			refiltered = TRUE;
 		}
 	} else {
-		obj->priv->filter_pattern = g_pattern_spec_new (pattern);
-
-		if (obj->priv->glob_filter_id == 0)
+		if (obj->priv->glob_filter_id == 0) {
 			obj->priv->glob_filter_id =
 			    pluma_file_browser_widget_add_filter (obj,
 								  filter_glob,
 								  NULL,
 								  NULL);
+			refiltered = TRUE;
+		}
 	}
 
 	if (update_entry) {
@@ -1793,9 +1952,13 @@ set_filter_pattern_real (PlumaFileBrowserWidget * obj,
 		}
 	}
 
-	if (PLUMA_IS_FILE_BROWSER_STORE (model))
-		pluma_file_browser_store_refilter (PLUMA_FILE_BROWSER_STORE
-						   (model));
+	/* Adding or removing the filter refilters already. Otherwise only
+	 * the pattern changed: refilter, also when the bookmarks are shown
+	 * since the file store caches the verdicts of the filters */
+	if (!refiltered)
+		pluma_file_browser_store_refilter (obj->priv->file_store);
+
+	search_restart (obj);
 
 	g_object_notify (G_OBJECT (obj), "filter-pattern");
 }
@@ -1814,6 +1977,8 @@ pluma_file_browser_widget_new (const gchar *data_dir)
 	create_tree (obj);
 	create_filter (obj);
 
+	create_search (obj);
+
 	pluma_file_browser_widget_show_bookmarks (obj);
 
 	return GTK_WIDGET (obj);
@@ -1943,16 +2108,12 @@ pluma_file_browser_widget_add_filter (PlumaFileBrowserWidget * obj,
 				      GDestroyNotify notify)
 {
 	FilterFunc *f;
-	GtkTreeModel *model =
-	    gtk_tree_view_get_model (GTK_TREE_VIEW (obj->priv->treeview));
 
 	f = filter_func_new (obj, func, user_data, notify);
 	obj->priv->filter_funcs =
 	    g_slist_append (obj->priv->filter_funcs, f);
 
-	if (PLUMA_IS_FILE_BROWSER_STORE (model))
-		pluma_file_browser_store_refilter (PLUMA_FILE_BROWSER_STORE
-						   (model));
+	pluma_file_browser_store_refilter (obj->priv->file_store);
 
 	return f->id;
 }
@@ -1977,6 +2138,8 @@ pluma_file_browser_widget_remove_filter (PlumaFileBrowserWidget * obj,
 			    g_slist_remove_link (obj->priv->filter_funcs,
 						 item);
 			g_free (func);
+
+			pluma_file_browser_store_refilter (obj->priv->file_store);
 			break;
 		}
 	}
@@ -2633,6 +2796,8 @@ on_virtual_root_changed (PlumaFileBrowserStore * model,
 	} else {
 		g_message ("NO!");
 	}
+
+	search_restart (obj);
 }
 
 static void
@@ -2666,6 +2831,10 @@ on_model_set (GObject * gobject, GParamSpec * arg1,
 
 		gtk_widget_set_sensitive (obj->priv->filter_expander, FALSE);
 
+		/* There is nothing to search in the bookmarks */
+		search_stop (obj);
+		gtk_widget_set_sensitive (obj->priv->search_expander, FALSE);
+
 		add_signal (obj, gobject,
 			    g_signal_connect (gobject, "bookmark-activated",
 					      G_CALLBACK
@@ -2685,6 +2854,7 @@ on_model_set (GObject * gobject, GParamSpec * arg1,
 			    		      (on_file_store_no_trash), obj));
 
 		gtk_widget_set_sensitive (obj->priv->filter_expander, TRUE);
+		gtk_widget_set_sensitive (obj->priv->search_expander, TRUE);
 	}
 
 	update_sensitivity (obj);
@@ -2959,6 +3129,213 @@ on_filter_mode_changed (PlumaFileBrowserStore * model,
 
 	if (active != gtk_toggle_action_get_active (action))
 		gtk_toggle_action_set_active (action, active);
+
+	search_restart (obj);
+}
+
+static void
+search_show_results (PlumaFileBrowserWidget * obj,
+		     gboolean show)
+{
+	gtk_widget_set_visible (obj->priv->search_sw, show);
+	gtk_widget_set_visible (obj->priv->tree_sw, !show);
+}
+
+static void
+search_set_status (PlumaFileBrowserWidget * obj,
+		   gchar const * status)
+{
+	gtk_label_set_text (GTK_LABEL (obj->priv->search_label), status);
+	gtk_widget_set_visible (obj->priv->search_label, status != NULL);
+}
+
+static void
+search_cancel (PlumaFileBrowserWidget * obj)
+{
+	if (obj->priv->search_cancellable == NULL)
+		return;
+
+	g_cancellable_cancel (obj->priv->search_cancellable);
+	g_object_unref (obj->priv->search_cancellable);
+	obj->priv->search_cancellable = NULL;
+}
+
+static void
+on_search_match (GFile * file,
+		 GFileInfo * info,
+		 gpointer user_data)
+{
+	PlumaFileBrowserWidget *obj = PLUMA_FILE_BROWSER_WIDGET (user_data);
+	GFile *parent;
+	GdkPixbuf *pixbuf = NULL;
+	GIcon *icon;
+	gchar *location;
+	gchar *uri;
+
+	icon = g_file_info_get_icon (info);
+
+	if (icon != NULL)
+		pixbuf = pluma_file_browser_utils_pixbuf_from_icon (icon,
+								    GTK_ICON_SIZE_MENU);
+
+	parent = g_file_get_parent (file);
+	location = g_file_get_relative_path (obj->priv->search_root, parent);
+	g_object_unref (parent);
+
+	uri = g_file_get_uri (file);
+
+	gtk_list_store_insert_with_values (obj->priv->search_store, NULL, -1,
+					   SEARCH_COLUMN_ICON, pixbuf,
+					   SEARCH_COLUMN_NAME, g_file_info_get_display_name (info),
+					   SEARCH_COLUMN_LOCATION, location,
+					   SEARCH_COLUMN_URI, uri,
+					   -1);
+
+	if (pixbuf != NULL)
+		g_object_unref (pixbuf);
+
+	g_free (location);
+	g_free (uri);
+}
+
+static void
+on_search_finished (GObject * source,
+		    GAsyncResult * result,
+		    gpointer user_data)
+{
+	PlumaFileBrowserWidget *obj;
+	gboolean truncated = FALSE;
+	GError *error = NULL;
+
+	if (!pluma_file_browser_search_finish (result, &truncated, &error)) {
+		/* The widget may be gone already */
+		if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+			g_error_free (error);
+			return;
+		}
+	}
+
+	obj = PLUMA_FILE_BROWSER_WIDGET (user_data);
+
+	g_object_unref (obj->priv->search_cancellable);
+	obj->priv->search_cancellable = NULL;
+
+	if (error != NULL) {
+		search_set_status (obj, error->message);
+		g_error_free (error);
+	} else if (gtk_tree_model_iter_n_children (GTK_TREE_MODEL (obj->priv->search_store),
+						   NULL) == 0) {
+		search_set_status (obj, _("No matches"));
+	} else if (truncated) {
+		gchar *status;
+
+		status = g_strdup_printf (_("Only the first %d matches are shown"),
+					  SEARCH_MAX_RESULTS);
+		search_set_status (obj, status);
+		g_free (status);
+	} else {
+		search_set_status (obj, NULL);
+	}
+}
+
+static void
+search_start (PlumaFileBrowserWidget * obj)
+{
+	GtkTreeModel *model;
+	gchar const *text;
+	gchar *uri = NULL;
+
+	search_cancel (obj);
+	gtk_list_store_clear (obj->priv->search_store);
+
+	if (obj->priv->search_root != NULL) {
+		g_object_unref (obj->priv->search_root);
+		obj->priv->search_root = NULL;
+	}
+
+	text = gtk_entry_get_text (GTK_ENTRY (obj->priv->search_entry));
+
+	if (*text == '\0') {
+		search_set_status (obj, NULL);
+		search_show_results (obj, FALSE);
+		return;
+	}
+
+	search_show_results (obj, TRUE);
+
+	model = gtk_tree_view_get_model (GTK_TREE_VIEW (obj->priv->treeview));
+
+	if (PLUMA_IS_FILE_BROWSER_STORE (model))
+		uri = pluma_file_browser_store_get_virtual_root (PLUMA_FILE_BROWSER_STORE (model));
+
+	if (uri == NULL) {
+		search_set_status (obj, _("Open a folder to search in"));
+		return;
+	}
+
+	obj->priv->search_root = g_file_new_for_uri (uri);
+	obj->priv->search_cancellable = g_cancellable_new ();
+	g_free (uri);
+
+	search_set_status (obj, _("Searching..."));
+
+	/* Walks the directories in a thread and streams the matches back, so
+	 * neither a large tree nor a slow mount blocks the panel */
+	pluma_file_browser_search_async (obj->priv->search_root,
+					 text,
+					 pluma_file_browser_store_get_filter_mode (PLUMA_FILE_BROWSER_STORE (model)),
+					 obj->priv->filter_pattern_str,
+					 SEARCH_MAX_RESULTS,
+					 obj->priv->search_cancellable,
+					 on_search_match,
+					 obj,
+					 on_search_finished,
+					 obj);
+}
+
+static void
+search_stop (PlumaFileBrowserWidget * obj)
+{
+	search_cancel (obj);
+
+	if (*gtk_entry_get_text (GTK_ENTRY (obj->priv->search_entry)) != '\0')
+		gtk_entry_set_text (GTK_ENTRY (obj->priv->search_entry), "");
+
+	search_start (obj);
+}
+
+/* The results depend on the folder and the filters, search again when
+ * they change */
+static void
+search_restart (PlumaFileBrowserWidget * obj)
+{
+	if (obj->priv->search_entry == NULL ||
+	    *gtk_entry_get_text (GTK_ENTRY (obj->priv->search_entry)) == '\0')
+		return;
+
+	search_start (obj);
+}
+
+static void
+on_search_row_activated (GtkTreeView * view,
+			 GtkTreePath * path,
+			 GtkTreeViewColumn * column,
+			 PlumaFileBrowserWidget * obj)
+{
+	GtkTreeIter iter;
+	gchar *uri;
+
+	if (!gtk_tree_model_get_iter (GTK_TREE_MODEL (obj->priv->search_store),
+				      &iter, path))
+		return;
+
+	gtk_tree_model_get (GTK_TREE_MODEL (obj->priv->search_store), &iter,
+			    SEARCH_COLUMN_URI, &uri,
+			    -1);
+
+	g_signal_emit (obj, signals[URI_ACTIVATED], 0, uri);
+
+	g_free (uri);
 }
 
 static void
@@ -35,11 +35,30 @@
 /* base dir to lookup configuration files */
 static gchar *modelines_data_dir;
 
-/* Mappings: language name -> Pluma language ID */
+/* the parser is shared by the plugin instances of all the windows */
+static guint modelines_users;
+
+/* Mappings: language name (lower case) -> Pluma language ID.
+ * They are loaded once, the first time a modeline names a language. */
+static gboolean language_mappings_loaded;
 static GHashTable *vim_languages;
 static GHashTable *emacs_languages;
 static GHashTable *kate_languages;
 
+/* The defaults restored when a modeline goes away, kept up to date
+ * from the settings instead of being read each time */
+typedef struct
+{
+	gboolean	insert_spaces;
+	guint		tab_width;
+	GtkWrapMode	wrap_mode;
+	gboolean	display_right_margin;
+	guint		right_margin_position;
+} ModelineDefaults;
+
+static GSettings *modelines_settings;
+static ModelineDefaults defaults;
+
 typedef enum
 {
 	MODELINE_SET_NONE = 0,
@@ -78,16 +97,51 @@ has_option (ModelineOptions *options,
 	return options->set & set;
 }
 
+static void
+load_defaults (GSettings *settings)
+{
+	defaults.insert_spaces = g_settings_get_boolean (settings, PLUMA_SETTINGS_INSERT_SPACES);
+	defaults.tab_width = g_settings_get_uint (settings, PLUMA_SETTINGS_TABS_SIZE);
+	defaults.wrap_mode = g_settings_get_enum (settings, PLUMA_SETTINGS_WRAP_MODE);
+	defaults.display_right_margin = g_settings_get_boolean (settings, PLUMA_SETTINGS_DISPLAY_RIGHT_MARGIN);
+	defaults.right_margin_position = g_settings_get_uint (settings, PLUMA_SETTINGS_RIGHT_MARGIN_POSITION);
+}
+
+static void
+on_settings_changed (GSettings   *settings,
+		     const gchar *key,
+		     gpointer     user_data)
+{
+	load_defaults (settings);
+}
+
 void
 modeline_parser_init (const gchar *data_dir)
 {
-	if (modelines_data_dir == NULL)
-		modelines_data_dir = g_strdup (data_dir);
+	if (modelines_users++ > 0)
+		return;
+
+	modelines_data_dir = g_strdup (data_dir);
+
+	modelines_settings = g_settings_new (PLUMA_SCHEMA_ID);
+	load_defaults (modelines_settings);
+
+	g_signal_connect (modelines_settings,
+			  "changed",
+			  G_CALLBACK (on_settings_changed),
+			  NULL);
 }
 
 void
 modeline_parser_shutdown ()
 {
+	g_return_if_fail (modelines_users > 0);
+
+	if (--modelines_users > 0)
+		return;
+
+	g_clear_object (&modelines_settings);
+
 	if (vim_languages != NULL)
 		g_hash_table_destroy (vim_languages);
 
@@ -100,6 +154,7 @@ modeline_parser_shutdown ()
 	vim_languages = NULL;
 	emacs_languages = NULL;
 	kate_languages = NULL;
+	language_mappings_loaded = FALSE;
 
 	g_free (modelines_data_dir);
 	modelines_data_dir = NULL;
@@ -123,11 +178,12 @@ load_language_mappings_group (GKeyFile *key_file, const gchar *group)
 
 	for (i = 0; i < length; i++)
 	{
-		gchar *name = keys[i];
-		gchar *id = g_key_file_get_string (key_file, group, name, NULL);
-		g_hash_table_insert (table, name, id);
+		gchar *id = g_key_file_get_string (key_file, group, keys[i], NULL);
+
+		/* lookups are done in lower case */
+		g_hash_table_insert (table, g_ascii_strdown (keys[i], -1), id);
 	}
-	g_free (keys);
+	g_strfreev (keys);
 
 	return table;
 }
@@ -167,17 +223,21 @@ load_language_mappings (void)
 
 	g_key_file_free (mappings);
 	g_free (fname);
+
+	/* do not try again for each modeline if the file is missing */
+	language_mappings_loaded = TRUE;
 }
 
 static gchar *
 get_language_id (const gchar *language_name, GHashTable *mapping)
 {
 	gchar *name;
-	gchar *language_id;
+	gchar *language_id = NULL;
 
 	name = g_ascii_strdown (language_name, -1);
 
-	language_id = g_hash_table_lookup (mapping, name);
+	if (mapping != NULL)
+		language_id = g_hash_table_lookup (mapping, name);
 
 	if (language_id != NULL)
 	{
@@ -194,7 +254,7 @@ get_language_id (const gchar *language_name, GHashTable *mapping)
 static gchar *
 get_language_id_vim (const gchar *language_name)
 {
-	if (vim_languages == NULL)
+	if (!language_mappings_loaded)
 		load_language_mappings ();
 
 	return get_language_id (language_name, vim_languages);
@@ -203,7 +263,7 @@ get_language_id_vim (const gchar *language_name)
 static gchar *
 get_language_id_emacs (const gchar *language_name)
 {
-	if (emacs_languages == NULL)
+	if (!language_mappings_loaded)
 		load_language_mappings ();
 
 	return get_language_id (language_name, emacs_languages);
@@ -212,7 +272,7 @@ get_language_id_emacs (const gchar *language_name)
 static gchar *
 get_language_id_kate (const gchar *language_name)
 {
-	if (kate_languages == NULL)
+	if (!language_mappings_loaded)
 		load_language_mappings ();
 
 	return get_language_id (language_name, kate_languages);
@@ -576,6 +636,15 @@ parse_modeline (gchar           *s,
 {
 	gchar prev;
 
+	/* Kate modelines have the widest range of lines */
+	if (line_number > 10 && line_number <= line_count - 10)
+		return;
+
+	/* all the markers have a ':' but the emacs one, "-*-": most lines
+	 * can be skipped with a single pass on them */
+	if (s == NULL || strpbrk (s, ":-") == NULL)
+		return;
+
 	/* look for the beginning of a modeline */
 	for (prev = ' '; (s != NULL) && (*s != '\0'); prev = *(s++))
 	{
@@ -670,6 +739,11 @@ free_modeline_options (ModelineOptions *options)
 	g_slice_free (ModelineOptions, options);
 }
 
+static void
+apply_options (GtkSourceView   *view,
+	       ModelineOptions *options,
+	       gboolean         set_language);
+
 void
 modeline_parser_apply_modeline (GtkSourceView *view)
 {
@@ -677,8 +751,6 @@ modeline_parser_apply_modeline (GtkSourceView *view)
 	GtkTextBuffer *buffer;
 	GtkTextIter iter, liter;
 	gint line_count;
-	/* FIXME: avoid making a new gsettings variable */
-	GSettings *settings = g_settings_new (PLUMA_SCHEMA_ID);
 
 	options.language_id = NULL;
 	options.set = MODELINE_SET_NONE;
@@ -745,15 +817,128 @@ modeline_parser_apply_modeline (GtkSourceView *view)
 		g_free (line);
 	}
 
+	apply_options (view, &options, TRUE);
+
+	g_free (options.language_id);
+}
+
+/* Splits @text in lines the way the document does: a newline at the
+ * very end does not start a new line */
+static gchar **
+split_lines (const gchar *text,
+	     gint        *n_lines)
+{
+	gchar **lines;
+	gint n;
+
+	if (strchr (text, '\n') == NULL && strchr (text, '\r') != NULL)
+		lines = g_strsplit (text, "\r", -1);
+	else
+		lines = g_strsplit (text, "\n", -1);
+
+	n = g_strv_length (lines);
+
+	if (n > 1 && *lines[n - 1] == '\0')
+	{
+		g_free (lines[n - 1]);
+		lines[n - 1] = NULL;
+		n--;
+	}
+
+	*n_lines = n;
+
+	return lines;
+}
+
+/**
+ * modeline_parser_apply_hints:
+ * @view: the view of the document being loaded
+ * @head: the first lines of the text
+ * @tail: the last lines of the text, or %NULL if @head is the whole text
+ *
+ * Same as modeline_parser_apply_modeline(), but on the text given to the
+ * PlumaDocument::load-hints signal instead of the buffer. The language is
+ * not set but returned, for the document to use it in place of the one it
+ * would guess.
+ *
+ * Returns: the id of the language asked by the modelines, or %NULL
+ */
+gchar *
+modeline_parser_apply_hints (GtkSourceView *view,
+			     const gchar   *head,
+			     const gchar   *tail)
+{
+	ModelineOptions options;
+	gchar **lines;
+	gint n_lines;
+	gint line_count;
+	gint i;
+	gchar *language_id = NULL;
+
+	options.language_id = NULL;
+	options.set = MODELINE_SET_NONE;
+
+	lines = split_lines (head, &n_lines);
+
+	/* the real count is not known when there is a tail, but it is more
+	 * than what head and tail can hold */
+	line_count = (tail == NULL) ? n_lines : G_MAXINT / 2;
+
+	for (i = 0; i < n_lines; i++)
+	{
+		if (i < 10 || i >= line_count - 10)
+			parse_modeline (lines[i], i + 1, line_count, &options);
+	}
+
+	g_strfreev (lines);
+
+	if (tail != NULL)
+	{
+		lines = split_lines (tail, &n_lines);
+
+		for (i = MAX (0, n_lines - 10); i < n_lines; i++)
+		{
+			parse_modeline (lines[i],
+					line_count - (n_lines - i) + 1,
+					line_count,
+					&options);
+		}
+
+		g_strfreev (lines);
+	}
+
+	apply_options (view, &options, FALSE);
+
+	if (has_option (&options, MODELINE_SET_LANGUAGE))
+		language_id = options.language_id;
+	else
+		g_free (options.language_id);
+
+	return language_id;
+}
+
+/* Applies the options we got from modelines and restores the defaults
+ * of those we set before */
+static void
+apply_options (GtkSourceView   *view,
+	       ModelineOptions *options,
+	       gboolean         set_language)
+{
+	GtkTextBuffer *buffer;
+	ModelineOptions *previous;
+
+	buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (view));
+
 	/* Try to set language */
-	if (has_option (&options, MODELINE_SET_LANGUAGE) && options.language_id)
+	if (set_language &&
+	    has_option (options, MODELINE_SET_LANGUAGE) && options->language_id)
 	{
 		GtkSourceLanguageManager *manager;
 		GtkSourceLanguage *language;
 
 		manager = pluma_get_language_manager ();
 		language = gtk_source_language_manager_get_language
-				(manager, options.language_id);
+				(manager, options->language_id);
 
 		if (language != NULL)
 		{
@@ -762,91 +947,81 @@ modeline_parser_apply_modeline (GtkSourceView *view)
 		}
 	}
 
-	ModelineOptions *previous = g_object_get_data (G_OBJECT (buffer),
-	                                               MODELINE_OPTIONS_DATA_KEY);
+	previous = g_object_get_data (G_OBJECT (buffer),
+	                              MODELINE_OPTIONS_DATA_KEY);
 
-	/* Apply the options we got from modelines and restore defaults if
-	   we set them before */
-	if (has_option (&options, MODELINE_SET_INSERT_SPACES))
+	if (has_option (options, MODELINE_SET_INSERT_SPACES))
 	{
 		gtk_source_view_set_insert_spaces_instead_of_tabs
-		                                (view, options.insert_spaces);
+		                                (view, options->insert_spaces);
 	}
 	else if (check_previous (view, previous, MODELINE_SET_INSERT_SPACES))
 	{
 		gtk_source_view_set_insert_spaces_instead_of_tabs
-		         (view,
-		         g_settings_get_boolean (settings, PLUMA_SETTINGS_INSERT_SPACES));
+		         (view, defaults.insert_spaces);
 	}
 
-	if (has_option (&options, MODELINE_SET_TAB_WIDTH))
+	if (has_option (options, MODELINE_SET_TAB_WIDTH))
 	{
-		gtk_source_view_set_tab_width (view, options.tab_width);
+		gtk_source_view_set_tab_width (view, options->tab_width);
 	}
 	else if (check_previous (view, previous, MODELINE_SET_TAB_WIDTH))
 	{
-		gtk_source_view_set_tab_width (view,
-		                               g_settings_get_uint (settings, PLUMA_SETTINGS_TABS_SIZE));
+		gtk_source_view_set_tab_width (view, defaults.tab_width);
 	}
 
-	if (has_option (&options, MODELINE_SET_INDENT_WIDTH))
+	if (has_option (options, MODELINE_SET_INDENT_WIDTH))
 	{
-		gtk_source_view_set_indent_width (view, options.indent_width);
+		gtk_source_view_set_indent_width (view, options->indent_width);
 	}
 	else if (check_previous (view, previous, MODELINE_SET_INDENT_WIDTH))
 	{
 		gtk_source_view_set_indent_width (view, -1);
 	}
 
-	if (has_option (&options, MODELINE_SET_WRAP_MODE))
+	if (has_option (options, MODELINE_SET_WRAP_MODE))
 	{
-		gtk_text_view_set_wrap_mode (GTK_TEXT_VIEW (view), options.wrap_mode);
+		gtk_text_view_set_wrap_mode (GTK_TEXT_VIEW (view), options->wrap_mode);
 	}
 	else if (check_previous (view, previous, MODELINE_SET_WRAP_MODE))
 	{
-		gtk_text_view_set_wrap_mode (GTK_TEXT_VIEW (view),
-		                             g_settings_get_enum (settings, PLUMA_SETTINGS_WRAP_MODE));
+		gtk_text_view_set_wrap_mode (GTK_TEXT_VIEW (view), defaults.wrap_mode);
 	}
 
-	if (has_option (&options, MODELINE_SET_RIGHT_MARGIN_POSITION))
+	if (has_option (options, MODELINE_SET_RIGHT_MARGIN_POSITION))
 	{
-		gtk_source_view_set_right_margin_position (view, options.right_margin_position);
+		gtk_source_view_set_right_margin_position (view, options->right_margin_position);
 	}
 	else if (check_previous (view, previous, MODELINE_SET_RIGHT_MARGIN_POSITION))
 	{
-		gtk_source_view_set_right_margin_position (view,
-		                                           g_settings_get_uint (settings, PLUMA_SETTINGS_RIGHT_MARGIN_POSITION));
+		gtk_source_view_set_right_margin_position (view, defaults.right_margin_position);
 	}
 
-	if (has_option (&options, MODELINE_SET_SHOW_RIGHT_MARGIN))
+	if (has_option (options, MODELINE_SET_SHOW_RIGHT_MARGIN))
 	{
-		gtk_source_view_set_show_right_margin (view, options.display_right_margin);
+		gtk_source_view_set_show_right_margin (view, options->display_right_margin);
 	}
 	else if (check_previous (view, previous, MODELINE_SET_SHOW_RIGHT_MARGIN))
 	{
-		gtk_source_view_set_show_right_margin (view,
-		                                       g_settings_get_boolean (settings, PLUMA_SETTINGS_DISPLAY_RIGHT_MARGIN));
+		gtk_source_view_set_show_right_margin (view, defaults.display_right_margin);
 	}
 
 	if (previous)
 	{
-		*previous = options;
-		previous->language_id = g_strdup (options.language_id);
+		*previous = *options;
+		previous->language_id = g_strdup (options->language_id);
 	}
 	else
 	{
 		previous = g_slice_new (ModelineOptions);
-		*previous = options;
-		previous->language_id = g_strdup (options.language_id);
+		*previous = *options;
+		previous->language_id = g_strdup (options->language_id);
 
 		g_object_set_data_full (G_OBJECT (buffer),
 		                        MODELINE_OPTIONS_DATA_KEY,
 		                        previous,
 		                        (GDestroyNotify)free_modeline_options);
 	}
-
-	g_free (options.language_id);
-	g_object_unref (settings);
 }
 
 void
@@ -31,6 +31,9 @@ G_BEGIN_DECLS
 void	modeline_parser_init		(const gchar *data_dir);
 void	modeline_parser_shutdown	(void);
 void	modeline_parser_apply_modeline	(GtkSourceView *view);
+gchar  *modeline_parser_apply_hints	(GtkSourceView *view,
+					 const gchar   *head,
+					 const gchar   *tail);
 void	modeline_parser_deactivate	(GtkSourceView *view);
 
 G_END_DECLS
@@ -44,8 +44,12 @@ struct _PlumaModelinePluginPrivate
 
 typedef struct
 {
+	gulong document_load_hints_handler_id;
 	gulong document_loaded_handler_id;
 	gulong document_saved_handler_id;
+
+	/* the modelines were already applied from the load hints */
+	gboolean hints_applied;
 } DocumentData;
 
 enum {
@@ -157,10 +161,43 @@ pluma_modeline_plugin_get_property (GObject    *object,
 	}
 }
 
+static gchar *
+on_document_load_hints (PlumaDocument *document,
+			const gchar   *head,
+			const gchar   *tail,
+			GtkSourceView *view)
+{
+	DocumentData *data;
+
+	data = g_object_get_data (G_OBJECT (document), DOCUMENT_DATA_KEY);
+	data->hints_applied = TRUE;
+
+	return modeline_parser_apply_hints (view, head, tail);
+}
+
 static void
-on_document_loaded_or_saved (PlumaDocument *document,
-			     const GError  *error,
-			     GtkSourceView *view)
+on_document_loaded (PlumaDocument *document,
+		    const GError  *error,
+		    GtkSourceView *view)
+{
+	DocumentData *data;
+
+	data = g_object_get_data (G_OBJECT (document), DOCUMENT_DATA_KEY);
+
+	/* no need to read the buffer again */
+	if (data->hints_applied)
+	{
+		data->hints_applied = FALSE;
+		return;
+	}
+
+	modeline_parser_apply_modeline (view);
+}
+
+static void
+on_document_saved (PlumaDocument *document,
+		   const GError  *error,
+		   GtkSourceView *view)
 {
 	modeline_parser_apply_modeline (view);
 }
@@ -174,14 +211,19 @@ connect_handlers (PlumaView *view)
         doc = gtk_text_view_get_buffer (GTK_TEXT_VIEW (view));
 
         data = g_slice_new (DocumentData);
+	data->hints_applied = FALSE;
 
+	data->document_load_hints_handler_id =
+		g_signal_connect (doc, "load-hints",
+				  G_CALLBACK (on_document_load_hints),
+				  view);
 	data->document_loaded_handler_id =
 		g_signal_connect (doc, "loaded",
-				  G_CALLBACK (on_document_loaded_or_saved),
+				  G_CALLBACK (on_document_loaded),
 				  view);
 	data->document_saved_handler_id =
 		g_signal_connect (doc, "saved",
-				  G_CALLBACK (on_document_loaded_or_saved),
+				  G_CALLBACK (on_document_saved),
 				  view);
 
 	g_object_set_data_full (G_OBJECT (doc), DOCUMENT_DATA_KEY,
@@ -200,6 +242,7 @@ disconnect_handlers (PlumaView *view)
 
 	if (data)
 	{
+		g_signal_handler_disconnect (doc, data->document_load_hints_handler_id);
 		g_signal_handler_disconnect (doc, data->document_loaded_handler_id);
 		g_signal_handler_disconnect (doc, data->document_saved_handler_id);
 
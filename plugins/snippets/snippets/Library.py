@@ -22,6 +22,8 @@ import sys
 import tempfile
 import re
 import codecs
+import bisect
+import json
 
 from gi.repository import Gdk, Gtk
 
@@ -273,6 +275,9 @@ class LanguageContainer:
         self.language = language
         self.snippets = []
         self.snippets_by_prop = {'tag': {}, 'accelerator': {}, 'drop-targets': {}}
+
+        # Sorted tags, to find the ones with a given prefix by bisection
+        self.tags = []
         self.accel_group = Gtk.AccelGroup()
         self._refs = 0
 
@@ -301,6 +306,9 @@ class LanguageContainer:
             else:
                 snippets[val] = [snippet]
 
+                if prop == 'tag':
+                    bisect.insort(self.tags, val)
+
     def _remove_prop(self, snippet, prop, value=0):
         if value == 0:
             value = snippet[prop]
@@ -325,6 +333,14 @@ class LanguageContainer:
             except:
                 True
 
+            if prop == 'tag' and val in snippets and not snippets[val]:
+                del snippets[val]
+
+                i = bisect.bisect_left(self.tags, val)
+
+                if i < len(self.tags) and self.tags[i] == val:
+                    del self.tags[i]
+
     def append(self, snippet):
         tag = snippet['tag']
         accelerator = snippet['accelerator']
@@ -377,6 +393,18 @@ class LanguageContainer:
             else:
                 return []
 
+    def from_tag_prefix(self, prefix):
+        snippets = self.snippets_by_prop['tag']
+        result = []
+
+        i = bisect.bisect_left(self.tags, prefix)
+
+        while i < len(self.tags) and self.tags[i].startswith(prefix):
+            result.extend(snippets[self.tags[i]])
+            i += 1
+
+        return result
+
     def ref(self):
         self._refs += 1
 
@@ -388,6 +416,116 @@ class LanguageContainer:
 
         return self._refs != 0
 
+# Cache of what was read from the snippet files, so that they do not have to
+# be parsed again while they do not change: the language of every file and,
+# for the system files, their snippets.
+class SnippetsCache:
+    VERSION = 1
+
+    def __init__(self, path):
+        self.path = path
+        self.files = {}
+        self.seen = set()
+        self.tainted = False
+
+        try:
+            with codecs.open(path, 'r', encoding='utf-8') as f:
+                data = json.load(f)
+        except (IOError, OSError, ValueError):
+            return
+
+        if isinstance(data, dict) and data.get('version') == self.VERSION:
+            self.files = data.get('files', {})
+
+    def _stamp(self, path):
+        try:
+            st = os.stat(path)
+        except OSError:
+            return None
+
+        return [st.st_mtime_ns, st.st_size]
+
+    def _lookup(self, path):
+        self.seen.add(path)
+        entry = self.files.get(path)
+
+        if entry and entry['stamp'] == self._stamp(path):
+            return entry
+
+        return None
+
+    def lookup_language(self, path):
+        entry = self._lookup(path)
+
+        if entry:
+            return (True, entry['language'])
+        else:
+            return (False, None)
+
+    def lookup_snippets(self, path):
+        entry = self._lookup(path)
+
+        if entry:
+            return entry['snippets']
+        else:
+            return None
+
+    def store_language(self, path, language):
+        stamp = self._stamp(path)
+
+        if stamp:
+            self.files[path] = {'stamp': stamp, 'language': language, \
+                    'snippets': None}
+            self.tainted = True
+
+    def store_snippets(self, path, language, elements):
+        stamp = self._stamp(path)
+
+        if stamp:
+            records = [[dict(element.attrib), \
+                    [[child.tag, child.text] for child in element]] \
+                    for element in elements]
+
+            self.files[path] = {'stamp': stamp, 'language': language, \
+                    'snippets': records}
+            self.tainted = True
+
+    @staticmethod
+    def elements_from_records(records):
+        for attrib, children in records:
+            element = et.Element('snippet', attrib)
+
+            for tag, text in children:
+                et.SubElement(element, tag).text = text
+
+            yield element
+
+    def save(self):
+        if not self.tainted:
+            return
+
+        # Forget the files that went away
+        files = dict((path, entry) for path, entry in self.files.items() \
+                if path in self.seen)
+
+        try:
+            path = os.path.dirname(self.path)
+
+            if not os.path.isdir(path):
+                os.makedirs(path, 0o755)
+
+            f = tempfile.NamedTemporaryFile('w', dir=path, delete=False, \
+                    encoding='utf-8')
+
+            with f:
+                json.dump({'version': self.VERSION, 'files': files}, f)
+
+            os.replace(f.name, self.path)
+            self.tainted = False
+        except (IOError, OSError):
+            sys.stderr.write("Could not save snippets cache to " + \
+                    self.path + "\n")
+
 class SnippetsSystemFile:
     def __init__(self, path=None):
         self.path = path
@@ -396,6 +534,10 @@ class SnippetsSystemFile:
         self.ok = True
         self.need_id = True
 
+        # Whether the snippets can be taken from the cache instead of
+        # parsing the file. User files keep the XML nodes to edit them.
+        self.cache_snippets = True
+
     def load_error(self, message):
         sys.stderr.write("An error occurred loading " + self.path + ":\n")
         sys.stderr.write(message + "\nSnippets in this file will not be " \
@@ -488,10 +630,34 @@ class SnippetsSystemFile:
 
         f.close()
 
+    def load_cached(self):
+        cache = Library().cache
+
+        if not self.cache_snippets or not cache:
+            return False
+
+        records = cache.lookup_snippets(self.path)
+
+        if records is None:
+            return False
+
+        snippets_debug("Loading library from cache (" + str(self.language) + \
+                "): " + self.path)
+
+        self.loaded = True
+
+        for element in SnippetsCache.elements_from_records(records):
+            Library().add_snippet(self, element)
+
+        return True
+
     def load(self):
         if not self.ok:
             return
 
+        if self.load_cached():
+            return
+
         snippets_debug("Loading library (" + str(self.language) + "): " + \
                 self.path)
 
@@ -509,6 +675,14 @@ class SnippetsSystemFile:
                     del self.loading_elements[:]
                     return
 
+        cache = Library().cache
+
+        if self.cache_snippets and cache:
+            # the raw elements: add_snippet normalizes them in place
+            # saved once by Library.ensure, after all the files are loaded
+            cache.store_snippets(self.path, self.language, \
+                    self.loading_elements)
+
         for element in self.loading_elements:
             snippet = Library().add_snippet(self, element)
 
@@ -521,6 +695,16 @@ class SnippetsSystemFile:
     # It returns the name of the language
     def ensure_language(self):
         if not self.loaded:
+            cache = Library().cache
+            found, language = cache.lookup_language(self.path) if cache \
+                    else (False, None)
+
+            if found:
+                attrib = {'language': language} if language else {}
+                self.set_language(et.Element('snippets', attrib))
+                self.ok = True
+                return
+
             self.ok = False
 
             for element in self.parse_xml(256):
@@ -531,6 +715,9 @@ class SnippetsSystemFile:
 
                     break
 
+            if self.ok and cache:
+                cache.store_language(self.path, self.language)
+
     def unload(self):
         snippets_debug("Unloading library (" + str(self.language) + "): " + \
                 self.path)
@@ -545,6 +732,7 @@ class SnippetsUserFile(SnippetsSystemFile):
         self.need_id = False
         self.modifier = False
         self.root = None
+        self.cache_snippets = False
 
     def _set_root(self, element):
         SnippetsSystemFile._set_root(self, element)
@@ -657,12 +845,18 @@ class Library(Singleton):
     def __init_once__(self):
         self._accelerator_activated_cb = []
         self.loaded = False
+        self.cache = None
         self.check_buffer = Gtk.TextBuffer()
 
-    def set_dirs(self, userdir, systemdirs):
+    def set_dirs(self, userdir, systemdirs, cachefile=None):
         self.userdir = userdir
         self.systemdirs = systemdirs
 
+        if cachefile:
+            self.cache = SnippetsCache(cachefile)
+        else:
+            self.cache = None
+
         self.libraries = {}
         self.containers = {}
         self.overridden = {}
@@ -926,6 +1120,9 @@ class Library(Singleton):
                 for library in self.libraries[lang]:
                     library.ensure()
 
+        if self.cache:
+            self.cache.save()
+
     def ensure_files(self):
         if self.loaded:
             return
@@ -938,6 +1135,9 @@ class Library(Singleton):
             searched = self.find_libraries(d, searched, \
                     self.add_system_library)
 
+        if self.cache:
+            self.cache.save()
+
         self.loaded = True
 
     def valid_accelerator(self, keyval, mod):
@@ -1006,6 +1206,18 @@ class Library(Singleton):
     def from_tag(self, tag, language=None):
         return self._from_prop('tag', tag, language)
 
+    # Get snippets whose tag starts with the given prefix
+    def from_tag_prefix(self, prefix, language=None):
+        self.ensure_files()
+        language = self.normalize_language(language)
+
+        if not language in self.libraries:
+            return []
+
+        self.ensure(language)
+
+        return self.containers[language].from_tag_prefix(prefix)
+
     # Get snippets for a given drop target
     def from_drop_target(self, drop_target, language=None):
         return self._from_prop('drop-targets', drop_target, language)
@@ -56,7 +56,8 @@ class SnippetsPlugin(GObject.Object, Pluma.WindowActivatable):
         library.add_accelerator_callback(self.accelerator_activated)
 
         snippetsdir = os.path.join(GLib.get_user_config_dir(), 'pluma/snippets')
-        library.set_dirs(snippetsdir, self.system_dirs())
+        cachefile = os.path.join(GLib.get_user_cache_dir(), 'pluma/snippets.json')
+        library.set_dirs(snippetsdir, self.system_dirs(), cachefile)
 
         self._helper = WindowHelper(self)
 
@@ -0,0 +1,633 @@
+/*
+ * pluma-sort-engine.c
+ * This file is part of pluma
+ *
+ * Copyright (C) 2012-2021 MATE Developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * The lines are split in chunks which are keyed and sorted in parallel on
+ * a thread pool, the sorted runs are then merged pairwise, every merge of
+ * a pass running on its own thread. Collation keys are computed once per
+ * line, so comparisons are plain strcmp () calls.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include "pluma-sort-engine.h"
+
+/* lines sorted by a single worker before the merge passes */
+#define CHUNK_SIZE 65536
+
+/* how many items are merged between two cancellation checks */
+#define CHECK_INTERVAL 65536
+
+typedef struct
+{
+	gchar   *line;
+	gchar   *key;
+	gdouble  number;
+} SortItem;
+
+typedef struct
+{
+	PlumaSortOptions       options;
+
+	gchar                **lines;
+	guint                  n_lines;
+
+	SortItem              *items;
+	SortItem              *tmp;
+	gchar                **keys;	/* owns the keys, in line order */
+
+	GCancellable          *cancellable;
+
+	PlumaSortProgressFunc  progress_func;
+	gpointer               progress_data;
+	GMainContext          *context;
+
+	gint                   done;	/* atomic */
+	gint                   total;
+	gint                   reported;	/* atomic, in percent */
+} SortJob;
+
+typedef struct
+{
+	SortItem *src;
+	SortItem *dst;
+	guint     lo;
+	guint     mid;
+	guint     hi;
+} SortWork;
+
+typedef struct
+{
+	PlumaSortProgressFunc func;
+	gpointer              data;
+	gdouble               fraction;
+} ProgressReport;
+
+static void
+sort_job_free (SortJob *job)
+{
+	guint i;
+
+	if (job->keys != NULL)
+	{
+		for (i = 0; i < job->n_lines; i++)
+			g_free (job->keys[i]);
+
+		g_free (job->keys);
+	}
+
+	g_free (job->items);
+	g_free (job->tmp);
+	g_strfreev (job->lines);
+
+	g_clear_object (&job->cancellable);
+	g_main_context_unref (job->context);
+
+	g_slice_free (SortJob, job);
+}
+
+static gboolean
+report_progress_idle (ProgressReport *report)
+{
+	report->func (report->fraction, report->data);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+add_progress (SortJob *job,
+	      gint     n)
+{
+	ProgressReport *report;
+	gint done;
+	gint percent;
+	gint reported;
+
+	done = g_atomic_int_add (&job->done, n) + n;
+
+	if (job->progress_func == NULL)
+		return;
+
+	percent = (gint) ((gint64) done * 100 / job->total);
+	reported = g_atomic_int_get (&job->reported);
+
+	/* only one thread reports a given percentage */
+	if (percent <= reported ||
+	    !g_atomic_int_compare_and_exchange (&job->reported, reported, percent))
+		return;
+
+	report = g_new (ProgressReport, 1);
+	report->func = job->progress_func;
+	report->data = job->progress_data;
+	report->fraction = MIN (percent / 100.0, 1.0);
+
+	g_main_context_invoke_full (job->context,
+				    G_PRIORITY_DEFAULT,
+				    (GSourceFunc) report_progress_idle,
+				    report,
+				    g_free);
+}
+
+static inline gboolean
+is_blank (gunichar c)
+{
+	return c == ' ' || c == '\t';
+}
+
+/* Finds the part of @line the options sort on */
+static const gchar *
+find_key (const gchar            *line,
+	  const PlumaSortOptions *options,
+	  const gchar           **key_end)
+{
+	const gchar *p = line;
+	const gchar *end;
+	gint i;
+
+	if (options->field <= 0)
+	{
+		for (i = 0; i < options->column && *p != '\0'; i++)
+			p = g_utf8_next_char (p);
+
+		*key_end = p + strlen (p);
+		return p;
+	}
+
+	if (options->delimiter == 0)
+	{
+		while (is_blank (*p))
+			p++;
+
+		for (i = 1; i < options->field && *p != '\0'; i++)
+		{
+			while (*p != '\0' && !is_blank (*p))
+				p++;
+			while (is_blank (*p))
+				p++;
+		}
+
+		end = p;
+		while (*end != '\0' && !is_blank (*end))
+			end++;
+	}
+	else
+	{
+		for (i = 1; i < options->field && p != NULL; i++)
+		{
+			p = g_utf8_strchr (p, -1, options->delimiter);
+
+			if (p != NULL)
+				p = g_utf8_next_char (p);
+		}
+
+		if (p == NULL)
+			p = line + strlen (line);
+
+		end = g_utf8_strchr (p, -1, options->delimiter);
+
+		if (end == NULL)
+			end = p + strlen (p);
+	}
+
+	*key_end = end;
+	return p;
+}
+
+static void
+compute_key (SortItem               *item,
+	     const PlumaSortOptions *options)
+{
+	const gchar *start;
+	const gchar *end;
+	gchar *text;
+
+	start = find_key (item->line, options, &end);
+
+	if (options->case_sensitive)
+		text = g_strndup (start, end - start);
+	else
+		text = g_utf8_casefold (start, end - start);
+
+	if (options->key_type == PLUMA_SORT_KEY_NUMERIC)
+	{
+		gchar *num_end;
+
+		item->number = g_ascii_strtod (text, &num_end);
+
+		/* like sort -n, lines that do not start with a number
+		 * count as 0 */
+		if (num_end == text)
+			item->number = 0.0;
+	}
+
+	if (options->key_type == PLUMA_SORT_KEY_NATURAL)
+		item->key = g_utf8_collate_key_for_filename (text, -1);
+	else
+		item->key = g_utf8_collate_key (text, -1);
+
+	g_free (text);
+}
+
+static gint
+compare_items (const SortItem         *a,
+	       const SortItem         *b,
+	       const PlumaSortOptions *options)
+{
+	gint ret = 0;
+
+	if (options->key_type == PLUMA_SORT_KEY_NUMERIC)
+	{
+		if (a->number < b->number)
+			ret = -1;
+		else if (a->number > b->number)
+			ret = 1;
+	}
+
+	if (ret == 0)
+		ret = strcmp (a->key, b->key);
+
+	return options->reverse ? -ret : ret;
+}
+
+static gint
+compare_items_func (gconstpointer a,
+		    gconstpointer b,
+		    gpointer      user_data)
+{
+	return compare_items (a, b, user_data);
+}
+
+static void
+sort_chunk (SortWork *work,
+	    SortJob  *job)
+{
+	guint i;
+
+	if (g_cancellable_is_cancelled (job->cancellable))
+		return;
+
+	for (i = work->lo; i < work->hi; i++)
+	{
+		compute_key (&job->items[i], &job->options);
+		job->keys[i] = job->items[i].key;
+	}
+
+	add_progress (job, work->hi - work->lo);
+
+	/* g_qsort_with_data () is a stable merge sort */
+	g_qsort_with_data (job->items + work->lo,
+			   work->hi - work->lo,
+			   sizeof (SortItem),
+			   compare_items_func,
+			   &job->options);
+
+	add_progress (job, work->hi - work->lo);
+}
+
+static void
+merge_runs (SortWork *work,
+	    SortJob  *job)
+{
+	SortItem *src = work->src;
+	SortItem *dst = work->dst + work->lo;
+	guint i = work->lo;
+	guint j = work->mid;
+	guint n = 0;
+
+	while (i < work->mid && j < work->hi)
+	{
+		/* take from the left run on ties to keep the sort stable */
+		if (compare_items (&src[j], &src[i], &job->options) < 0)
+			*dst++ = src[j++];
+		else
+			*dst++ = src[i++];
+
+		if (++n == CHECK_INTERVAL)
+		{
+			if (g_cancellable_is_cancelled (job->cancellable))
+				return;
+
+			add_progress (job, n);
+			n = 0;
+		}
+	}
+
+	memcpy (dst, src + i, (work->mid - i) * sizeof (SortItem));
+	dst += work->mid - i;
+	memcpy (dst, src + j, (work->hi - j) * sizeof (SortItem));
+
+	add_progress (job, n + (work->mid - i) + (work->hi - j));
+}
+
+static void
+run_pool (GFunc     func,
+	  SortJob  *job,
+	  SortWork *works,
+	  guint     n_works)
+{
+	GThreadPool *pool;
+	guint i;
+
+	if (n_works == 1)
+	{
+		func (&works[0], job);
+		return;
+	}
+
+	pool = g_thread_pool_new (func,
+				  job,
+				  MIN (g_get_num_processors (), n_works),
+				  FALSE,
+				  NULL);
+
+	for (i = 0; i < n_works; i++)
+		g_thread_pool_push (pool, &works[i], NULL);
+
+	/* waits for all the pushed work to be done */
+	g_thread_pool_free (pool, FALSE, TRUE);
+}
+
+static gchar **
+collect_lines (SortJob *job)
+{
+	gchar **result;
+	guint i;
+	guint n = 0;
+
+	result = g_new (gchar *, job->n_lines + 1);
+
+	for (i = 0; i < job->n_lines; i++)
+	{
+		SortItem *item = &job->items[i];
+
+		if (job->options.remove_duplicates && n > 0 &&
+		    compare_items (item, &job->items[i - 1], &job->options) == 0)
+		{
+			g_free (item->line);
+			continue;
+		}
+
+		result[n++] = item->line;
+	}
+
+	result[n] = NULL;
+
+	/* the lines now belong to the result */
+	g_free (job->lines);
+	job->lines = NULL;
+
+	return result;
+}
+
+static void
+sort_thread (GTask        *task,
+	     gpointer      source_object,
+	     SortJob      *job,
+	     GCancellable *cancellable)
+{
+	SortWork *works;
+	guint n_runs;
+	guint width;
+	guint i;
+
+	job->items = g_new (SortItem, job->n_lines);
+	job->tmp = g_new (SortItem, job->n_lines);
+	job->keys = g_new0 (gchar *, job->n_lines);
+
+	for (i = 0; i < job->n_lines; i++)
+	{
+		job->items[i].line = job->lines[i];
+		job->items[i].key = NULL;
+		job->items[i].number = 0.0;
+	}
+
+	n_runs = MAX (1, (job->n_lines + CHUNK_SIZE - 1) / CHUNK_SIZE);
+	works = g_new0 (SortWork, n_runs);
+
+	for (i = 0; i < n_runs; i++)
+	{
+		works[i].lo = i * CHUNK_SIZE;
+		works[i].hi = MIN ((i + 1) * CHUNK_SIZE, job->n_lines);
+	}
+
+	run_pool ((GFunc) sort_chunk, job, works, n_runs);
+
+	/* merge pairs of adjacent runs until a single one is left */
+	for (width = CHUNK_SIZE; width < job->n_lines; width *= 2)
+	{
+		SortItem *swap;
+		guint n_works = 0;
+		guint lo;
+
+		if (g_cancellable_is_cancelled (cancellable))
+			break;
+
+		for (lo = 0; lo < job->n_lines; lo += 2 * width)
+		{
+			SortWork *work = &works[n_works++];
+
+			work->src = job->items;
+			work->dst = job->tmp;
+			work->lo = lo;
+			work->mid = MIN (lo + width, job->n_lines);
+			work->hi = MIN (lo + 2 * width, job->n_lines);
+		}
+
+		run_pool ((GFunc) merge_runs, job, works, n_works);
+
+		swap = job->items;
+		job->items = job->tmp;
+		job->tmp = swap;
+	}
+
+	g_free (works);
+
+	if (g_task_return_error_if_cancelled (task))
+		return;
+
+	g_task_return_pointer (task, collect_lines (job), (GDestroyNotify) g_strfreev);
+}
+
+/**
+ * pluma_sort_lines_async:
+ * @lines: (transfer full): the %NULL terminated lines to sort
+ * @options: how to compare the lines
+ * @cancellable: (allow-none): a #GCancellable
+ * @progress_func: (allow-none): called as the sort advances
+ * @progress_data: data for @progress_func
+ * @callback: called when the sort is done
+ * @user_data: data for @callback
+ *
+ * Sorts @lines on worker threads. The sort is stable: lines comparing
+ * equal keep their relative order.
+ */
+void
+pluma_sort_lines_async (gchar                  **lines,
+			const PlumaSortOptions  *options,
+			GCancellable            *cancellable,
+			PlumaSortProgressFunc    progress_func,
+			gpointer                 progress_data,
+			GAsyncReadyCallback      callback,
+			gpointer                 user_data)
+{
+	GTask *task;
+	SortJob *job;
+	guint levels = 0;
+	guint width;
+
+	g_return_if_fail (lines != NULL);
+	g_return_if_fail (options != NULL);
+
+	job = g_slice_new0 (SortJob);
+	job->options = *options;
+	job->lines = lines;
+	job->n_lines = g_strv_length (lines);
+	job->cancellable = cancellable != NULL ? g_object_ref (cancellable) : NULL;
+	job->progress_func = progress_func;
+	job->progress_data = progress_data;
+	job->context = g_main_context_ref_thread_default ();
+
+	/* keys and chunk sort, then one pass per merge level */
+	for (width = CHUNK_SIZE; width < job->n_lines; width *= 2)
+		levels++;
+
+	job->total = MAX (1, job->n_lines * (2 + levels));
+
+	task = g_task_new (NULL, cancellable, callback, user_data);
+	g_task_set_source_tag (task, pluma_sort_lines_async);
+	g_task_set_task_data (task, job, (GDestroyNotify) sort_job_free);
+
+	g_task_run_in_thread (task, (GTaskThreadFunc) sort_thread);
+
+	g_object_unref (task);
+}
+
+/**
+ * pluma_sort_lines_finish:
+ * @result: a #GAsyncResult
+ * @error: return location for a #GError
+ *
+ * Returns: (transfer full): the sorted lines, or %NULL on error
+ */
+gchar **
+pluma_sort_lines_finish (GAsyncResult  *result,
+			 GError       **error)
+{
+	g_return_val_if_fail (g_task_is_valid (result, NULL), NULL);
+
+	return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+/**
+ * pluma_sort_get_lines:
+ * @buffer: a #GtkTextBuffer
+ * @start: the start of the range
+ * @end: the end of the range
+ *
+ * Returns: (transfer full): the lines of the range, without their
+ * terminators, whatever they are
+ */
+gchar **
+pluma_sort_get_lines (GtkTextBuffer     *buffer,
+		      const GtkTextIter *start,
+		      const GtkTextIter *end)
+{
+	GPtrArray *lines;
+	GtkTextIter line_start;
+
+	lines = g_ptr_array_new ();
+	line_start = *start;
+
+	do
+	{
+		GtkTextIter line_end = line_start;
+
+		if (!gtk_text_iter_ends_line (&line_end))
+			gtk_text_iter_forward_to_line_end (&line_end);
+
+		if (gtk_text_iter_compare (&line_end, end) > 0)
+			line_end = *end;
+
+		g_ptr_array_add (lines,
+				 gtk_text_buffer_get_slice (buffer,
+							    &line_start,
+							    &line_end,
+							    TRUE));
+	}
+	while (gtk_text_iter_forward_line (&line_start) &&
+	       gtk_text_iter_compare (&line_start, end) <= 0);
+
+	g_ptr_array_add (lines, NULL);
+
+	return (gchar **) g_ptr_array_free (lines, FALSE);
+}
+
+static const gchar *
+get_newline_string (PlumaDocument *doc)
+{
+	switch (pluma_document_get_newline_type (doc))
+	{
+		case PLUMA_DOCUMENT_NEWLINE_TYPE_CR:
+			return "\r";
+
+		case PLUMA_DOCUMENT_NEWLINE_TYPE_CR_LF:
+			return "\r\n";
+
+		case PLUMA_DOCUMENT_NEWLINE_TYPE_LF:
+		default:
+			return "\n";
+	}
+}
+
+/**
+ * pluma_sort_replace_lines:
+ * @doc: a #PlumaDocument
+ * @start: the start of the range
+ * @end: the end of the range
+ * @lines: the sorted lines
+ *
+ * Replaces the range with @lines, joined with the document newline
+ * type, as a single user action.
+ */
+void
+pluma_sort_replace_lines (PlumaDocument  *doc,
+			  GtkTextIter    *start,
+			  GtkTextIter    *end,
+			  gchar         **lines)
+{
+	GtkTextBuffer *buffer = GTK_TEXT_BUFFER (doc);
+	gchar *text;
+
+	text = g_strjoinv (get_newline_string (doc), lines);
+
+	gtk_text_buffer_begin_user_action (buffer);
+
+	gtk_text_buffer_delete (buffer, start, end);
+	gtk_text_buffer_insert (buffer, start, text, -1);
+
+	gtk_text_buffer_end_user_action (buffer);
+
+	g_free (text);
+}
@@ -0,0 +1,78 @@
+/*
+ * pluma-sort-engine.h
+ * This file is part of pluma
+ *
+ * Copyright (C) 2012-2021 MATE Developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __PLUMA_SORT_ENGINE_H__
+#define __PLUMA_SORT_ENGINE_H__
+
+#include <gio/gio.h>
+#include <pluma/pluma-document.h>
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+	PLUMA_SORT_KEY_TEXT,
+	PLUMA_SORT_KEY_NATURAL,	/* digits compare by value, e.g. versions */
+	PLUMA_SORT_KEY_NUMERIC
+} PlumaSortKeyType;
+
+typedef struct
+{
+	PlumaSortKeyType key_type;
+	gboolean         case_sensitive;
+	gboolean         reverse;
+	gboolean         remove_duplicates;
+
+	/* The key starts at character @column of the line, or, when @field
+	 * is not 0, it is the @field-th field (counting from 1) separated
+	 * by @delimiter; a 0 delimiter means runs of blanks. */
+	gint             column;
+	gint             field;
+	gunichar         delimiter;
+} PlumaSortOptions;
+
+/* Called in the thread default main context of the caller */
+typedef void (* PlumaSortProgressFunc) (gdouble  fraction,
+					gpointer user_data);
+
+void	  pluma_sort_lines_async	(gchar                  **lines,
+					 const PlumaSortOptions  *options,
+					 GCancellable            *cancellable,
+					 PlumaSortProgressFunc    progress_func,
+					 gpointer                 progress_data,
+					 GAsyncReadyCallback      callback,
+					 gpointer                 user_data);
+
+gchar	**pluma_sort_lines_finish	(GAsyncResult            *result,
+					 GError                 **error);
+
+gchar	**pluma_sort_get_lines		(GtkTextBuffer           *buffer,
+					 const GtkTextIter       *start,
+					 const GtkTextIter       *end);
+
+void	  pluma_sort_replace_lines	(PlumaDocument           *doc,
+					 GtkTextIter             *start,
+					 GtkTextIter             *end,
+					 gchar                  **lines);
+
+G_END_DECLS
+
+#endif /* __PLUMA_SORT_ENGINE_H__ */
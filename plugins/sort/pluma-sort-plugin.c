@@ -26,6 +26,7 @@
 #endif
 
 #include "pluma-sort-plugin.h"
+#include "pluma-sort-engine.h"
 
 #include <string.h>
 #include <glib/gi18n-lib.h>
@@ -58,8 +59,17 @@ struct _PlumaSortPluginPrivate
 	GtkWidget *reverse_order_checkbutton;
 	GtkWidget *ignore_case_checkbutton;
 	GtkWidget *remove_dups_checkbutton;
+	GtkWidget *key_type_combobox;
+	GtkWidget *field_spinbutton;
+	GtkWidget *delimiter_entry;
+	GtkWidget *progressbar;
 
-	GtkTextIter start, end; /* selection */
+	/* selection, marks since the buffer may change while sorting */
+	PlumaDocument *doc;
+	GtkTextMark *start_mark;
+	GtkTextMark *end_mark;
+
+	GCancellable *cancellable;
 };
 
 G_DEFINE_DYNAMIC_TYPE_EXTENDED (PlumaSortPlugin,
@@ -83,44 +93,187 @@ static const GtkActionEntry action_entries[] =
 };
 
 static void
-do_sort (PlumaSortPlugin *plugin)
+set_options_sensitive (PlumaSortPluginPrivate *priv,
+		       gboolean                sensitive)
+{
+	gtk_widget_set_sensitive (priv->reverse_order_checkbutton, sensitive);
+	gtk_widget_set_sensitive (priv->ignore_case_checkbutton, sensitive);
+	gtk_widget_set_sensitive (priv->remove_dups_checkbutton, sensitive);
+	gtk_widget_set_sensitive (priv->col_num_spinbutton, sensitive);
+	gtk_widget_set_sensitive (priv->key_type_combobox, sensitive);
+	gtk_widget_set_sensitive (priv->field_spinbutton, sensitive);
+	gtk_widget_set_sensitive (priv->delimiter_entry, sensitive);
+
+	gtk_dialog_set_response_sensitive (GTK_DIALOG (priv->dialog),
+					   GTK_RESPONSE_OK,
+					   sensitive);
+}
+
+static void
+clear_selection (PlumaSortPluginPrivate *priv)
+{
+	if (priv->doc == NULL)
+		return;
+
+	gtk_text_buffer_delete_mark (GTK_TEXT_BUFFER (priv->doc), priv->start_mark);
+	gtk_text_buffer_delete_mark (GTK_TEXT_BUFFER (priv->doc), priv->end_mark);
+	priv->start_mark = NULL;
+	priv->end_mark = NULL;
+
+	g_clear_object (&priv->doc);
+}
+
+/* Sorting works on whole lines */
+static void
+get_sort_range (PlumaSortPluginPrivate *priv,
+		GtkTextIter            *start,
+		GtkTextIter            *end)
+{
+	GtkTextBuffer *buffer = GTK_TEXT_BUFFER (priv->doc);
+
+	gtk_text_buffer_get_iter_at_mark (buffer, start, priv->start_mark);
+	gtk_text_buffer_get_iter_at_mark (buffer, end, priv->end_mark);
+
+	gtk_text_iter_set_line_offset (start, 0);
+
+	/* a selection ending at the start of a line does not include it */
+	if (gtk_text_iter_starts_line (end) &&
+	    gtk_text_iter_compare (end, start) > 0)
+		gtk_text_iter_backward_line (end);
+
+	if (!gtk_text_iter_ends_line (end))
+		gtk_text_iter_forward_to_line_end (end);
+}
+
+static void
+sort_progress_cb (gdouble          fraction,
+		  PlumaSortPlugin *plugin)
+{
+	if (plugin->priv->dialog == NULL)
+		return;
+
+	gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (plugin->priv->progressbar),
+				       fraction);
+}
+
+static void
+sort_ready_cb (GObject         *source,
+	       GAsyncResult    *result,
+	       PlumaSortPlugin *plugin)
 {
 	PlumaSortPluginPrivate *priv;
-	PlumaDocument *doc;
-	GtkSourceSortFlags sort_flags = 0;
-	gint starting_column;
+	GtkTextIter start, end;
+	gchar **lines;
+	GError *error = NULL;
 
 	pluma_debug (DEBUG_PLUGINS);
 
 	priv = plugin->priv;
 
-	doc = pluma_window_get_active_document (priv->window);
-	g_return_if_fail (doc != NULL);
+	lines = pluma_sort_lines_finish (result, &error);
 
-	if (gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (priv->ignore_case_checkbutton)))
+	/* the dialog was closed, drop the result */
+	if (priv->dialog == NULL)
 	{
-		sort_flags |= GTK_SOURCE_SORT_FLAGS_CASE_SENSITIVE;
+		g_clear_error (&error);
+		g_strfreev (lines);
+		g_object_unref (plugin);
+		return;
 	}
 
-	if (gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (priv->reverse_order_checkbutton)))
-	{
-		sort_flags |= GTK_SOURCE_SORT_FLAGS_REVERSE_ORDER;
-	}
+	g_clear_object (&priv->cancellable);
 
-	if (gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (priv->remove_dups_checkbutton)))
+	if (lines == NULL)
 	{
-		sort_flags |= GTK_SOURCE_SORT_FLAGS_REMOVE_DUPLICATES;
+		/* give the dialog back to the user */
+		gtk_widget_hide (priv->progressbar);
+		set_options_sensitive (priv, TRUE);
+
+		pluma_warning (GTK_WINDOW (priv->dialog),
+			       _("Could not sort the lines: %s"),
+			       error->message);
+
+		g_error_free (error);
+		g_object_unref (plugin);
+		return;
 	}
 
-	starting_column = gtk_spin_button_get_value_as_int (GTK_SPIN_BUTTON (priv->col_num_spinbutton)) - 1;
+	get_sort_range (priv, &start, &end);
 
-	gtk_source_buffer_sort_lines (GTK_SOURCE_BUFFER (doc),
-	                              &priv->start,
-	                              &priv->end,
-	                              sort_flags,
-	                              starting_column);
+	pluma_sort_replace_lines (priv->doc, &start, &end, lines);
+	g_strfreev (lines);
 
 	pluma_debug_message (DEBUG_PLUGINS, "Done.");
+
+	gtk_widget_destroy (priv->dialog);
+	g_object_unref (plugin);
+}
+
+static void
+do_sort (PlumaSortPlugin *plugin)
+{
+	PlumaSortPluginPrivate *priv;
+	PlumaSortOptions options;
+	GtkTextIter start, end;
+	const gchar *delimiter;
+	gchar **lines;
+
+	pluma_debug (DEBUG_PLUGINS);
+
+	priv = plugin->priv;
+
+	g_return_if_fail (priv->doc != NULL);
+
+	options.case_sensitive = !gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (priv->ignore_case_checkbutton));
+	options.reverse = gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (priv->reverse_order_checkbutton));
+	options.remove_duplicates = gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (priv->remove_dups_checkbutton));
+	options.key_type = gtk_combo_box_get_active (GTK_COMBO_BOX (priv->key_type_combobox));
+	options.column = gtk_spin_button_get_value_as_int (GTK_SPIN_BUTTON (priv->col_num_spinbutton)) - 1;
+	options.field = gtk_spin_button_get_value_as_int (GTK_SPIN_BUTTON (priv->field_spinbutton));
+
+	delimiter = gtk_entry_get_text (GTK_ENTRY (priv->delimiter_entry));
+	options.delimiter = g_utf8_get_char_validated (delimiter, -1);
+
+	if (options.delimiter == (gunichar) -1 || options.delimiter == (gunichar) -2)
+		options.delimiter = 0;
+
+	get_sort_range (priv, &start, &end);
+
+	/* split on the buffer lines so \r\n and \r terminated documents
+	 * sort too, the result is joined with the document newline type */
+	lines = pluma_sort_get_lines (GTK_TEXT_BUFFER (priv->doc), &start, &end);
+
+	set_options_sensitive (priv, FALSE);
+	gtk_widget_show (priv->progressbar);
+
+	priv->cancellable = g_cancellable_new ();
+
+	pluma_sort_lines_async (lines,
+				&options,
+				priv->cancellable,
+				(PlumaSortProgressFunc) sort_progress_cb,
+				plugin,
+				(GAsyncReadyCallback) sort_ready_cb,
+				g_object_ref (plugin));
+}
+
+static void
+sort_dialog_destroy_cb (GtkWidget       *dialog,
+			PlumaSortPlugin *plugin)
+{
+	PlumaSortPluginPrivate *priv = plugin->priv;
+
+	pluma_debug (DEBUG_PLUGINS);
+
+	if (priv->cancellable != NULL)
+	{
+		g_cancellable_cancel (priv->cancellable);
+		g_clear_object (&priv->cancellable);
+	}
+
+	clear_selection (priv);
+
+	priv->dialog = NULL;
 }
 
 static void
@@ -133,8 +286,8 @@ sort_dialog_response_handler (GtkDialog       *dialog,
 	switch (res_id)
 	{
 		case GTK_RESPONSE_OK:
+			/* the dialog is destroyed when the sort is done */
 			do_sort (plugin);
-			gtk_widget_destroy (GTK_WIDGET(dialog));
 			break;
 
 		case GTK_RESPONSE_HELP:
@@ -144,6 +297,8 @@ sort_dialog_response_handler (GtkDialog       *dialog,
 			break;
 
 		case GTK_RESPONSE_CANCEL:
+		case GTK_RESPONSE_DELETE_EVENT:
+			/* also cancels a running sort */
 			gtk_widget_destroy (GTK_WIDGET(dialog));
 			break;
 	}
@@ -157,6 +312,7 @@ get_current_selection (PlumaSortPlugin *plugin)
 {
 	PlumaSortPluginPrivate *priv;
 	PlumaDocument *doc;
+	GtkTextIter start, end;
 
 	pluma_debug (DEBUG_PLUGINS);
 
@@ -164,14 +320,26 @@ get_current_selection (PlumaSortPlugin *plugin)
 	doc = pluma_window_get_active_document (priv->window);
 
 	if (!gtk_text_buffer_get_selection_bounds (GTK_TEXT_BUFFER (doc),
-						   &priv->start,
-						   &priv->end))
+						   &start,
+						   &end))
 	{
 		/* No selection, get the whole document. */
 		gtk_text_buffer_get_bounds (GTK_TEXT_BUFFER (doc),
-					    &priv->start,
-					    &priv->end);
+					    &start,
+					    &end);
 	}
+
+	clear_selection (priv);
+
+	priv->doc = g_object_ref (doc);
+	priv->start_mark = gtk_text_buffer_create_mark (GTK_TEXT_BUFFER (doc),
+							NULL,
+							&start,
+							TRUE);
+	priv->end_mark = gtk_text_buffer_create_mark (GTK_TEXT_BUFFER (doc),
+						      NULL,
+						      &end,
+						      FALSE);
 }
 
 static void
@@ -197,6 +365,10 @@ create_sort_dialog (PlumaSortPlugin *plugin)
 					  "col_num_spinbutton", &priv->col_num_spinbutton,
 					  "ignore_case_checkbutton", &priv->ignore_case_checkbutton,
 					  "remove_dups_checkbutton", &priv->remove_dups_checkbutton,
+					  "key_type_combobox", &priv->key_type_combobox,
+					  "field_spinbutton", &priv->field_spinbutton,
+					  "delimiter_entry", &priv->delimiter_entry,
+					  "sort_progressbar", &priv->progressbar,
 					  NULL);
 	g_free (data_dir);
 	g_free (ui_file);
@@ -216,8 +388,8 @@ create_sort_dialog (PlumaSortPlugin *plugin)
 
 	g_signal_connect (priv->dialog,
 			  "destroy",
-			  G_CALLBACK (gtk_widget_destroyed),
-			  &priv->dialog);
+			  G_CALLBACK (sort_dialog_destroy_cb),
+			  plugin);
 
 	g_signal_connect (priv->dialog,
 			  "response",
@@ -385,6 +557,9 @@ pluma_sort_plugin_dispose (GObject *object)
 
 	pluma_debug_message (DEBUG_PLUGINS, "PlumaSortPlugin disposing");
 
+	if (plugin->priv->dialog != NULL)
+		gtk_widget_destroy (plugin->priv->dialog);
+
 	g_clear_object (&plugin->priv->window);
 	g_clear_object (&plugin->priv->ui_action_group);
 
@@ -1128,6 +1128,11 @@ set_auto_spell_from_metadata (PlumaSpellPlugin *plugin,
 		g_free (active_str);
 	}
 
+	/* Checking the whole of a huge document would freeze the editor,
+	 * the user can still turn it on by hand */
+	if (pluma_document_get_large_file_mode (doc))
+		active = FALSE;
+
 	window = PLUMA_WINDOW (plugin->priv->window);
 
 	set_auto_spell (window, doc, active);
@@ -1171,6 +1176,14 @@ on_document_loaded (PlumaDocument *doc,
 	}
 }
 
+static void
+on_large_file_mode_changed (PlumaDocument    *doc,
+			    GParamSpec       *pspec,
+			    PlumaSpellPlugin *plugin)
+{
+	set_auto_spell_from_metadata (plugin, doc, plugin->priv->action_group);
+}
+
 static void
 on_document_saved (PlumaDocument *doc,
 		   const GError  *error,
@@ -1198,7 +1211,10 @@ on_document_saved (PlumaDocument *doc,
 		key = NULL;
 	}
 
-	if (get_autocheck_type (plugin) == AUTOCHECK_DOCUMENT)
+	/* In large file mode the checker being off says nothing about
+	 * what the user wants for this document */
+	if (get_autocheck_type (plugin) == AUTOCHECK_DOCUMENT &&
+	    !pluma_document_get_large_file_mode (doc))
 	{
 
 		pluma_document_set_metadata (doc,
@@ -1243,6 +1259,10 @@ tab_added_cb (PlumaWindow *window,
 	g_signal_connect (doc, "saved",
 			  G_CALLBACK (on_document_saved),
 			  plugin);
+
+	g_signal_connect (doc, "notify::large-file-mode",
+			  G_CALLBACK (on_large_file_mode_changed),
+			  plugin);
 }
 
 static void
@@ -1256,6 +1276,7 @@ tab_removed_cb (PlumaWindow *window,
 
 	g_signal_handlers_disconnect_by_func (doc, on_document_loaded, plugin);
 	g_signal_handlers_disconnect_by_func (doc, on_document_saved, plugin);
+	g_signal_handlers_disconnect_by_func (doc, on_large_file_mode_changed, plugin);
 }
 
 static void
@@ -1336,6 +1357,10 @@ pluma_spell_plugin_activate (PlumaWindowActivatable *activatable)
 		g_signal_handlers_disconnect_by_func (doc,
 		                                      on_document_saved,
 		                                      plugin);
+
+		g_signal_handlers_disconnect_by_func (doc,
+		                                      on_large_file_mode_changed,
+		                                      plugin);
 	}
 
 	data->tab_added_id =
@@ -429,6 +429,9 @@ selected_group_changed (GtkComboBox             *combo,
 		panel->priv->selected_tag_group = find_tag_group (group_name);
 		g_return_if_fail (panel->priv->selected_tag_group != NULL);
 
+		/* groups coming from the cache get their tags on first use */
+		load_tag_group (panel->priv->selected_tag_group);
+
 		pluma_debug_message (DEBUG_PLUGINS,
 				     "New selected group: %s",
 				     panel->priv->selected_tag_group->name);
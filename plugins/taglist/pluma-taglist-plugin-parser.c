@@ -35,16 +35,26 @@
 #include <config.h>
 #endif
 
+#include <errno.h>
 #include <string.h>
 #include <libxml/parser.h>
 #include <glib.h>
 #include <glib/gi18n.h>
+#include <glib/gstdio.h>
 
 #include <pluma/pluma-debug.h>
 
 #include "pluma-taglist-plugin-parser.h"
 
 #define USER_PLUMA_TAGLIST_PLUGIN_LOCATION "pluma/taglist/"
+#define TAGLIST_CACHE_FILE "pluma/taglist.cache"
+
+/* version, locale, stamps of the tags files (path, mtime, size) and the
+ * tag groups (name, tags (name, begin, end)) */
+#define TAGLIST_CACHE_VERSION 1
+#define TAGLIST_CACHE_STAMPS_TYPE "a(sxt)"
+#define TAGLIST_CACHE_TAGS_TYPE "a(smsms)"
+#define TAGLIST_CACHE_TYPE "(us" TAGLIST_CACHE_STAMPS_TYPE "a(s" TAGLIST_CACHE_TAGS_TYPE "))"
 
 TagList* taglist = NULL;
 static gint taglist_ref_count = 0;
@@ -527,6 +537,10 @@ free_tag_group (TagGroup *tag_group)
 	}
 
 	g_list_free (tag_group->tags);
+
+	if (tag_group->cached_tags != NULL)
+		g_variant_unref (tag_group->cached_tags);
+
 	g_free (tag_group);
 
 	pluma_debug_message (DEBUG_PLUGINS, "END");
@@ -596,9 +610,243 @@ static TagList* parse_taglist_dir(const gchar* dir)
 	return taglist;
 }
 
+void load_tag_group(TagGroup* tag_group)
+{
+	GVariantIter iter;
+	const gchar *name;
+	const gchar *begin;
+	const gchar *end;
+
+	g_return_if_fail (tag_group != NULL);
+
+	if (tag_group->cached_tags == NULL)
+		return;
+
+	pluma_debug_message (DEBUG_PLUGINS, "Tag group: %s", tag_group->name);
+
+	g_variant_iter_init (&iter, tag_group->cached_tags);
+
+	while (g_variant_iter_next (&iter, "(&sm&sm&s)", &name, &begin, &end))
+	{
+		Tag *tag;
+
+		/* the strings are released with free () as the ones from libxml */
+		tag = g_new0 (Tag, 1);
+		tag->name = xmlStrdup ((const xmlChar *) name);
+		tag->begin = begin != NULL ? xmlStrdup ((const xmlChar *) begin) : NULL;
+		tag->end = end != NULL ? xmlStrdup ((const xmlChar *) end) : NULL;
+
+		tag_group->tags = g_list_prepend (tag_group->tags, tag);
+	}
+
+	tag_group->tags = g_list_reverse (tag_group->tags);
+
+	g_variant_unref (tag_group->cached_tags);
+	tag_group->cached_tags = NULL;
+}
+
+static gchar *
+get_cache_filename (void)
+{
+	return g_build_filename (g_get_user_cache_dir (), TAGLIST_CACHE_FILE, NULL);
+}
+
+/* The groups picked by lookup_best_lang and their translated names depend
+ * on the locale, so it is part of the cache key */
+static gchar *
+get_cache_locale (void)
+{
+	return g_strjoinv (":", (gchar **) g_get_language_names ());
+}
+
+static void
+add_dir_stamps (GVariantBuilder *builder,
+		const gchar     *dir)
+{
+	GDir *d;
+	const gchar *dirent;
+
+	d = g_dir_open (dir, 0, NULL);
+
+	if (d == NULL)
+		return;
+
+	while ((dirent = g_dir_read_name (d)))
+	{
+		if (g_str_has_suffix (dirent, ".tags") || g_str_has_suffix (dirent, ".tags.gz"))
+		{
+			gchar *tags_file;
+			GStatBuf st;
+
+			tags_file = g_build_filename (dir, dirent, NULL);
+
+			if (g_stat (tags_file, &st) == 0)
+			{
+				g_variant_builder_add (builder, "(sxt)",
+						       tags_file,
+						       (gint64) st.st_mtime,
+						       (guint64) st.st_size);
+			}
+
+			g_free (tags_file);
+		}
+	}
+
+	g_dir_close (d);
+}
+
+static TagList *
+load_taglist_cache (GVariant *stamps)
+{
+	gchar *filename;
+	gchar *locale;
+	GMappedFile *mapped;
+	GBytes *bytes;
+	GVariant *cache;
+	GVariant *cached_stamps;
+	GVariant *groups;
+	const gchar *cached_locale;
+	guint32 version;
+	GVariantIter iter;
+	GVariant *group;
+	TagList *tag_list = NULL;
+
+	filename = get_cache_filename ();
+	mapped = g_mapped_file_new (filename, FALSE, NULL);
+	g_free (filename);
+
+	if (mapped == NULL)
+		return NULL;
+
+	bytes = g_mapped_file_get_bytes (mapped);
+	g_mapped_file_unref (mapped);
+
+	/* not trusted: a corrupted file just yields default values */
+	cache = g_variant_new_from_bytes (G_VARIANT_TYPE (TAGLIST_CACHE_TYPE),
+					  bytes,
+					  FALSE);
+	g_variant_ref_sink (cache);
+	g_bytes_unref (bytes);
+
+	g_variant_get (cache,
+		       "(u&s@" TAGLIST_CACHE_STAMPS_TYPE "@a(s" TAGLIST_CACHE_TAGS_TYPE "))",
+		       &version,
+		       &cached_locale,
+		       &cached_stamps,
+		       &groups);
+
+	locale = get_cache_locale ();
+
+	if (version == TAGLIST_CACHE_VERSION &&
+	    strcmp (cached_locale, locale) == 0 &&
+	    g_variant_equal (cached_stamps, stamps))
+	{
+		tag_list = g_new0 (TagList, 1);
+
+		g_variant_iter_init (&iter, groups);
+
+		/* Only the group names are read here, the tags are decoded
+		 * when the group is first shown */
+		while ((group = g_variant_iter_next_value (&iter)) != NULL)
+		{
+			TagGroup *tag_group;
+			const gchar *name;
+
+			tag_group = g_new0 (TagGroup, 1);
+
+			g_variant_get_child (group, 0, "&s", &name);
+			tag_group->name = xmlStrdup ((const xmlChar *) name);
+			tag_group->cached_tags = g_variant_get_child_value (group, 1);
+
+			tag_list->tag_groups = g_list_prepend (tag_list->tag_groups,
+							       tag_group);
+
+			g_variant_unref (group);
+		}
+
+		tag_list->tag_groups = g_list_reverse (tag_list->tag_groups);
+	}
+
+	pluma_debug_message (DEBUG_PLUGINS, "Cache %s", tag_list != NULL ? "valid" : "stale");
+
+	g_free (locale);
+	g_variant_unref (cached_stamps);
+	g_variant_unref (groups);
+	g_variant_unref (cache);
+
+	return tag_list;
+}
+
+static void
+save_taglist_cache (GVariant *stamps)
+{
+	GVariantBuilder groups;
+	GVariant *cache;
+	gchar *locale;
+	gchar *filename;
+	gchar *dirname;
+	GList *l;
+	GError *error = NULL;
+
+	g_variant_builder_init (&groups, G_VARIANT_TYPE ("a(s" TAGLIST_CACHE_TAGS_TYPE ")"));
+
+	for (l = taglist != NULL ? taglist->tag_groups : NULL; l != NULL; l = g_list_next (l))
+	{
+		TagGroup *tag_group = (TagGroup *) l->data;
+		GVariantBuilder tags;
+		GList *t;
+
+		g_variant_builder_init (&tags, G_VARIANT_TYPE (TAGLIST_CACHE_TAGS_TYPE));
+
+		for (t = tag_group->tags; t != NULL; t = g_list_next (t))
+		{
+			Tag *tag = (Tag *) t->data;
+
+			g_variant_builder_add (&tags, "(smsms)",
+					       (const gchar *) tag->name,
+					       (const gchar *) tag->begin,
+					       (const gchar *) tag->end);
+		}
+
+		g_variant_builder_add (&groups, "(s" TAGLIST_CACHE_TAGS_TYPE ")",
+				       (const gchar *) tag_group->name,
+				       &tags);
+	}
+
+	locale = get_cache_locale ();
+	cache = g_variant_new ("(us@" TAGLIST_CACHE_STAMPS_TYPE "a(s" TAGLIST_CACHE_TAGS_TYPE "))",
+			       (guint32) TAGLIST_CACHE_VERSION,
+			       locale,
+			       stamps,
+			       &groups);
+	g_variant_ref_sink (cache);
+	g_free (locale);
+
+	filename = get_cache_filename ();
+	dirname = g_path_get_dirname (filename);
+
+	if (g_mkdir_with_parents (dirname, 0755) != 0 ||
+	    !g_file_set_contents (filename,
+				  g_variant_get_data (cache),
+				  g_variant_get_size (cache),
+				  &error))
+	{
+		pluma_debug_message (DEBUG_PLUGINS, "Cannot save the cache: %s",
+				     error != NULL ? error->message : g_strerror (errno));
+
+		g_clear_error (&error);
+	}
+
+	g_free (dirname);
+	g_free (filename);
+	g_variant_unref (cache);
+}
+
 TagList* create_taglist(const gchar* data_dir)
 {
-	gchar* pdir;
+	gchar* pdir = NULL;
+	GVariantBuilder builder;
+	GVariant *stamps;
 
 	pluma_debug_message(DEBUG_PLUGINS, "ref_count: %d", taglist_ref_count);
 
@@ -611,18 +859,38 @@ TagList* create_taglist(const gchar* data_dir)
 
 	const gchar* home;
 
-	/* load user's taglists */
-
 	home = g_get_home_dir ();
 	if (home != NULL)
 	{
 		pdir = g_build_filename(home, ".config", USER_PLUMA_TAGLIST_PLUGIN_LOCATION, NULL);
-		parse_taglist_dir(pdir);
-		g_free (pdir);
 	}
 
-	/* load system's taglists */
-	parse_taglist_dir(data_dir);
+	/* the cache is valid as long as the same tags files are unchanged */
+	g_variant_builder_init (&builder, G_VARIANT_TYPE (TAGLIST_CACHE_STAMPS_TYPE));
+
+	if (pdir != NULL)
+		add_dir_stamps (&builder, pdir);
+
+	add_dir_stamps (&builder, data_dir);
+
+	stamps = g_variant_ref_sink (g_variant_builder_end (&builder));
+
+	taglist = load_taglist_cache (stamps);
+
+	if (taglist == NULL)
+	{
+		/* load user's taglists */
+		if (pdir != NULL)
+			parse_taglist_dir(pdir);
+
+		/* load system's taglists */
+		parse_taglist_dir(data_dir);
+
+		save_taglist_cache (stamps);
+	}
+
+	g_variant_unref (stamps);
+	g_free (pdir);
 
 	++taglist_ref_count;
 	g_return_val_if_fail(taglist_ref_count == 1, taglist);
@@ -47,6 +47,9 @@ struct _TagGroup {
 	xmlChar* name;
 
 	GList* tags;
+
+	/* Tags read from the cache, decoded into @tags by load_tag_group() */
+	GVariant* cached_tags;
 };
 
 struct _Tag {
@@ -62,5 +65,7 @@ TagList* create_taglist(const gchar* data_dir);
 
 void free_taglist(void);
 
+void load_tag_group(TagGroup* tag_group);
+
 #endif /* __PLUMA_TAGLIST_PLUGIN_PARSER_H__ */
 
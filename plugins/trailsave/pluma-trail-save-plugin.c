@@ -27,6 +27,7 @@
 #include <pluma/pluma-debug.h>
 
 #include "pluma-trail-save-plugin.h"
+#include "pluma-trail-save-strip.h"
 
 static void pluma_window_activatable_iface_init (PlumaWindowActivatableInterface *iface);
 
@@ -48,80 +49,120 @@ G_DEFINE_DYNAMIC_TYPE_EXTENDED (PlumaTrailSavePlugin,
                                 G_IMPLEMENT_INTERFACE_DYNAMIC (PLUMA_TYPE_WINDOW_ACTIVATABLE,
                                                                pluma_window_activatable_iface_init))
 
+#define DIRTY_TAG_KEY "pluma-trail-save-dirty-tag"
+#define BLOCKED_KEY "pluma-trail-save-blocked"
+
+static GtkTextTag *
+get_dirty_tag (PlumaDocument *document)
+{
+	return GTK_TEXT_TAG (g_object_get_data (G_OBJECT (document), DIRTY_TAG_KEY));
+}
+
+/* Mark the lines spanned by [start, end) as modified since the last save */
 static void
-strip_trailing_spaces (GtkTextBuffer *text_buffer)
+mark_lines_dirty (GtkTextBuffer *text_buffer,
+		  GtkTextTag    *dirty_tag,
+		  GtkTextIter   *start,
+		  GtkTextIter   *end)
+{
+	gtk_text_iter_set_line_offset (start, 0);
+
+	if (!gtk_text_iter_ends_line (end))
+		gtk_text_iter_forward_to_line_end (end);
+
+	if (!gtk_text_iter_equal (start, end))
+		gtk_text_buffer_apply_tag (text_buffer, dirty_tag, start, end);
+}
+
+static void
+on_insert_text (GtkTextBuffer *text_buffer,
+		GtkTextIter   *location,
+		const gchar   *text,
+		gint           len,
+		gpointer       user_data)
+{
+	GtkTextIter start, end;
+
+	/* this runs after the default handler, location is at the end of
+	 * the inserted text */
+	start = *location;
+	end = *location;
+	gtk_text_iter_backward_chars (&start, g_utf8_strlen (text, len));
+
+	mark_lines_dirty (text_buffer,
+			  get_dirty_tag (PLUMA_DOCUMENT (text_buffer)),
+			  &start,
+			  &end);
+}
+
+static void
+on_delete_range (GtkTextBuffer *text_buffer,
+		 GtkTextIter   *start,
+		 GtkTextIter   *end,
+		 gpointer       user_data)
 {
-	gint line_count, line_num;
 	GtkTextIter line_start, line_end;
-	gchar *slice;
-	gchar byte;
-	gint byte_index;
-	gint strip_start_index, strip_end_index;
-	gboolean should_strip;
-	GtkTextIter strip_start, strip_end;
 
-	g_assert (text_buffer != NULL);
+	line_start = *start;
+	line_end = *start;
 
-	line_count = gtk_text_buffer_get_line_count (text_buffer);
+	mark_lines_dirty (text_buffer,
+			  get_dirty_tag (PLUMA_DOCUMENT (text_buffer)),
+			  &line_start,
+			  &line_end);
+}
 
-	for (line_num = 0; line_num < line_count; ++line_num)
-	{
-		/* Get line text */
-		gtk_text_buffer_get_iter_at_line (text_buffer, &line_start, line_num);
-
-		if (line_num == line_count - 1)
-		{
-			gtk_text_buffer_get_end_iter (text_buffer, &line_end);
-		}
-		else
-		{
-			gtk_text_buffer_get_iter_at_line (text_buffer, &line_end, line_num + 1);
-		}
-
-		slice = gtk_text_buffer_get_slice (text_buffer, &line_start, &line_end, TRUE);
-
-		if (slice == NULL)
-		{
-			continue;
-		}
-
-		/* Find indices of bytes that should be stripped */
-		should_strip = FALSE;
-
-		for (byte_index = 0; slice [byte_index] != 0; ++byte_index)
-		{
-			byte = slice [byte_index];
-
-			if ((byte == ' ') || (byte == '\t'))
-			{
-				if (!should_strip)
-				{
-					strip_start_index = byte_index;
-					should_strip = TRUE;
-				}
-
-				strip_end_index = byte_index + 1;
-			}
-			else if ((byte == '\r') || (byte == '\n'))
-			{
-				break;
-			}
-			else
-			{
-				should_strip = FALSE;
-			}
-		}
-
-		g_free (slice);
-
-		/* Strip trailing spaces */
-		if (should_strip)
-		{
-			gtk_text_buffer_get_iter_at_line_index (text_buffer, &strip_start, line_num, strip_start_index);
-			gtk_text_buffer_get_iter_at_line_index (text_buffer, &strip_end, line_num, strip_end_index);
-			gtk_text_buffer_delete (text_buffer, &strip_start, &strip_end);
-		}
-	}
+/* Loaded text is not a modification. The document may already be
+ * loading when we attach to it, so remember whether we blocked */
+static void
+block_tracking (PlumaDocument        *document,
+		PlumaTrailSavePlugin *plugin)
+{
+	if (g_object_get_data (G_OBJECT (document), BLOCKED_KEY) != NULL)
+		return;
+
+	g_signal_handlers_block_by_func (document, on_insert_text, plugin);
+	g_signal_handlers_block_by_func (document, on_delete_range, plugin);
+	g_object_set_data (G_OBJECT (document), BLOCKED_KEY, GINT_TO_POINTER (TRUE));
+}
+
+static void
+unblock_tracking (PlumaDocument        *document,
+		  PlumaTrailSavePlugin *plugin)
+{
+	if (g_object_get_data (G_OBJECT (document), BLOCKED_KEY) == NULL)
+		return;
+
+	g_signal_handlers_unblock_by_func (document, on_insert_text, plugin);
+	g_signal_handlers_unblock_by_func (document, on_delete_range, plugin);
+	g_object_set_data (G_OBJECT (document), BLOCKED_KEY, NULL);
+}
+
+static void
+on_load (PlumaDocument       *document,
+	 const gchar         *uri,
+	 const PlumaEncoding *encoding,
+	 gint                 line_pos,
+	 gboolean             create,
+	 PlumaTrailSavePlugin *plugin)
+{
+	block_tracking (document, plugin);
+}
+
+static void
+on_loaded (PlumaDocument        *document,
+	   const GError         *error,
+	   PlumaTrailSavePlugin *plugin)
+{
+	GtkTextIter start, end;
+
+	unblock_tracking (document, plugin);
+
+	gtk_text_buffer_get_bounds (GTK_TEXT_BUFFER (document), &start, &end);
+	gtk_text_buffer_remove_tag (GTK_TEXT_BUFFER (document),
+				    get_dirty_tag (document),
+				    &start,
+				    &end);
 }
 
 static void
@@ -133,7 +174,65 @@ on_save (PlumaDocument         *document,
 {
 	GtkTextBuffer *text_buffer = GTK_TEXT_BUFFER (document);
 
-	strip_trailing_spaces (text_buffer);
+	pluma_trail_save_strip (text_buffer, get_dirty_tag (document));
+}
+
+static void
+attach_document (PlumaTrailSavePlugin *plugin,
+		 PlumaDocument        *document)
+{
+	GtkTextBuffer *text_buffer = GTK_TEXT_BUFFER (document);
+	GtkTextTag *dirty_tag;
+	PlumaTab *tab;
+	PlumaTabState state;
+
+	/* The tag has no visual properties, it just keeps track of the
+	 * lines modified since the last save as the buffer changes */
+	dirty_tag = gtk_text_buffer_create_tag (text_buffer, NULL, NULL);
+	g_object_set_data (G_OBJECT (document), DIRTY_TAG_KEY, dirty_tag);
+
+	/* We don't know what happened to a modified document before we
+	 * were activated, so consider it all dirty */
+	if (gtk_text_buffer_get_modified (text_buffer))
+	{
+		GtkTextIter start, end;
+
+		gtk_text_buffer_get_bounds (text_buffer, &start, &end);
+		gtk_text_buffer_apply_tag (text_buffer, dirty_tag, &start, &end);
+	}
+
+	g_signal_connect_after (document, "insert-text", G_CALLBACK (on_insert_text), plugin);
+	g_signal_connect_after (document, "delete-range", G_CALLBACK (on_delete_range), plugin);
+	g_signal_connect (document, "load", G_CALLBACK (on_load), plugin);
+	g_signal_connect (document, "loaded", G_CALLBACK (on_loaded), plugin);
+	g_signal_connect (document, "save", G_CALLBACK (on_save), plugin);
+
+	/* Documents opened from a URI emit "load" before the tab is added */
+	tab = pluma_tab_get_from_document (document);
+	state = tab != NULL ? pluma_tab_get_state (tab) : PLUMA_TAB_STATE_NORMAL;
+
+	if (state == PLUMA_TAB_STATE_LOADING || state == PLUMA_TAB_STATE_REVERTING)
+		block_tracking (document, plugin);
+}
+
+static void
+detach_document (PlumaTrailSavePlugin *plugin,
+		 PlumaDocument        *document)
+{
+	GtkTextBuffer *text_buffer = GTK_TEXT_BUFFER (document);
+	GtkTextTag *dirty_tag;
+
+	g_signal_handlers_disconnect_by_data (document, plugin);
+	g_object_set_data (G_OBJECT (document), BLOCKED_KEY, NULL);
+
+	dirty_tag = get_dirty_tag (document);
+
+	if (dirty_tag != NULL)
+	{
+		gtk_text_tag_table_remove (gtk_text_buffer_get_tag_table (text_buffer),
+					   dirty_tag);
+		g_object_set_data (G_OBJECT (document), DIRTY_TAG_KEY, NULL);
+	}
 }
 
 static void
@@ -141,10 +240,7 @@ on_tab_added (PlumaWindow *window,
 	      PlumaTab    *tab,
 	      PlumaTrailSavePlugin *plugin)
 {
-	PlumaDocument *document;
-
-	document = pluma_tab_get_document (tab);
-	g_signal_connect (document, "save", G_CALLBACK (on_save), plugin);
+	attach_document (plugin, pluma_tab_get_document (tab));
 }
 
 static void
@@ -152,10 +248,7 @@ on_tab_removed (PlumaWindow *window,
 		PlumaTab    *tab,
 		PlumaTrailSavePlugin *plugin)
 {
-	PlumaDocument *document;
-
-	document = pluma_tab_get_document (tab);
-	g_signal_handlers_disconnect_by_data (document, plugin);
+	detach_document (plugin, pluma_tab_get_document (tab));
 }
 
 static void
@@ -182,7 +275,7 @@ pluma_trail_save_plugin_activate (PlumaWindowActivatable *activatable)
 	     documents_iter = documents_iter->next)
 	{
 		document = (PlumaDocument *) documents_iter->data;
-		g_signal_connect (document, "save", G_CALLBACK (on_save), plugin);
+		attach_document (plugin, document);
 	}
 
 	g_list_free (documents);
@@ -211,7 +304,7 @@ pluma_trail_save_plugin_deactivate (PlumaWindowActivatable *activatable)
 	     documents_iter = documents_iter->next)
 	{
 		document = (PlumaDocument *) documents_iter->data;
-		g_signal_handlers_disconnect_by_data (document, plugin);
+		detach_document (plugin, document);
 	}
 
 	g_list_free (documents);
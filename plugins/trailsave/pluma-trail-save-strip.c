@@ -0,0 +1,141 @@
+/*
+ * pluma-trail-save-strip.c
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "pluma-trail-save-strip.h"
+
+typedef struct
+{
+	gint start;
+	gint end;
+} StripRange;
+
+static void
+strip_line (GtkTextIter *line_start,
+	    GtkTextIter *line_end,
+	    GArray      *ranges)
+{
+	GtkTextIter strip_start;
+
+	if (!gtk_text_iter_ends_line (line_end))
+		gtk_text_iter_forward_to_line_end (line_end);
+
+	strip_start = *line_end;
+
+	while (gtk_text_iter_compare (&strip_start, line_start) > 0)
+	{
+		gunichar c;
+
+		gtk_text_iter_backward_char (&strip_start);
+		c = gtk_text_iter_get_char (&strip_start);
+
+		if ((c != ' ') && (c != '\t'))
+		{
+			gtk_text_iter_forward_char (&strip_start);
+			break;
+		}
+	}
+
+	if (!gtk_text_iter_equal (&strip_start, line_end))
+	{
+		StripRange range;
+
+		range.start = gtk_text_iter_get_offset (&strip_start);
+		range.end = gtk_text_iter_get_offset (line_end);
+
+		g_array_append_val (ranges, range);
+	}
+}
+
+static gboolean
+forward_to_dirty_region (GtkTextIter *iter,
+			 GtkTextTag  *dirty_tag)
+{
+	while (!gtk_text_iter_has_tag (iter, dirty_tag))
+	{
+		if (!gtk_text_iter_forward_to_tag_toggle (iter, dirty_tag))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+/* Strips the trailing white space of the lines spanned by @dirty_tag, as
+ * a single user action, and clears the tag */
+void
+pluma_trail_save_strip (GtkTextBuffer *text_buffer,
+			GtkTextTag    *dirty_tag)
+{
+	GtkTextIter iter, region_end, line_end;
+	GtkTextIter start, end;
+	GArray *ranges;
+	gint i;
+
+	g_assert (text_buffer != NULL);
+
+	ranges = g_array_new (FALSE, FALSE, sizeof (StripRange));
+
+	/* Walk the dirty regions with a single iterator, collecting the
+	 * trailing white space of every line they span */
+	gtk_text_buffer_get_start_iter (text_buffer, &iter);
+
+	while (forward_to_dirty_region (&iter, dirty_tag))
+	{
+		region_end = iter;
+		gtk_text_iter_forward_to_tag_toggle (&region_end, dirty_tag);
+
+		gtk_text_iter_set_line_offset (&iter, 0);
+
+		do
+		{
+			line_end = iter;
+			strip_line (&iter, &line_end, ranges);
+
+			iter = line_end;
+			if (!gtk_text_iter_forward_line (&iter))
+				goto done;
+		}
+		while (gtk_text_iter_compare (&iter, &region_end) < 0);
+	}
+
+done:
+	/* Delete back to front so that the collected offsets stay valid */
+	if (ranges->len > 0)
+	{
+		gtk_text_buffer_begin_user_action (text_buffer);
+
+		for (i = ranges->len - 1; i >= 0; --i)
+		{
+			StripRange *range = &g_array_index (ranges, StripRange, i);
+
+			gtk_text_buffer_get_iter_at_offset (text_buffer, &start, range->start);
+			gtk_text_buffer_get_iter_at_offset (text_buffer, &end, range->end);
+			gtk_text_buffer_delete (text_buffer, &start, &end);
+		}
+
+		gtk_text_buffer_end_user_action (text_buffer);
+	}
+
+	g_array_free (ranges, TRUE);
+
+	gtk_text_buffer_get_bounds (text_buffer, &start, &end);
+	gtk_text_buffer_remove_tag (text_buffer, dirty_tag, &start, &end);
+}
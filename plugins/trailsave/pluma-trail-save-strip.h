@@ -0,0 +1,31 @@
+/*
+ * pluma-trail-save-strip.h
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __PLUMA_TRAIL_SAVE_STRIP_H__
+#define __PLUMA_TRAIL_SAVE_STRIP_H__
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+void	pluma_trail_save_strip	(GtkTextBuffer *text_buffer,
+				 GtkTextTag    *dirty_tag);
+
+G_END_DECLS
+
+#endif /* __PLUMA_TRAIL_SAVE_STRIP_H__ */
@@ -36,8 +36,17 @@
 #endif
 
 #include <stdio.h>
+#include <string.h>
+#include <gio/gio.h>
+
 #include "pluma-debug.h"
 
+#ifdef G_OS_UNIX
+#include <unistd.h>
+#include <signal.h>
+#include <glib-unix.h>
+#endif
+
 #define ENABLE_PROFILING
 
 #ifdef ENABLE_PROFILING
@@ -47,6 +56,27 @@ static gdouble last = 0.0;
 
 static PlumaDebugSection debug = PLUMA_NO_DEBUG;
 
+/* Must be a power of two so that the ring index wraps cleanly */
+#define TRACE_RING_SIZE (1 << 16)
+
+typedef struct
+{
+	const gchar       *name;
+	PlumaDebugSection  section;
+	gchar              phase;	/* 'X' complete span, 'C' counter */
+	gint               tid;
+	gint64             ts;
+	gint64             value;	/* duration for spans */
+} TraceEvent;
+
+static TraceEvent *trace_ring = NULL;
+static gint        trace_next = 0;
+static gint        trace_next_tid = 0;
+static gchar      *trace_filename = NULL;
+static GPrivate    trace_tid;
+
+static void trace_init (void);
+
 void
 pluma_debug_init (void)
 {
@@ -90,6 +120,8 @@ pluma_debug_init (void)
 
 out:
 
+	trace_init ();
+
 #ifdef ENABLE_PROFILING
 	if (debug != PLUMA_NO_DEBUG)
 		timer = g_timer_new ();
@@ -157,3 +189,242 @@ void pluma_debug (PlumaDebugSection  section,
 		fflush (stdout);
 	}
 }
+
+static const gchar *
+section_name (PlumaDebugSection section)
+{
+	static const gchar *names[] = {
+		"view", "search", "print", "prefs", "plugins", "tab",
+		"document", "commands", "app", "session", "utils",
+		"metadata", "window", "loader", "saver"
+	};
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS (names); i++)
+	{
+		if (section & (1 << i))
+			return names[i];
+	}
+
+	return "pluma";
+}
+
+#ifdef G_OS_UNIX
+static gboolean
+trace_sigusr1 (gpointer data)
+{
+	GError *error = NULL;
+
+	if (!pluma_trace_dump (trace_filename, &error))
+	{
+		g_warning ("Could not write trace: %s", error->message);
+		g_error_free (error);
+	}
+
+	return G_SOURCE_CONTINUE;
+}
+#endif
+
+static void
+trace_init (void)
+{
+	const gchar *filename;
+
+	filename = g_getenv ("PLUMA_TRACE");
+
+	if (filename == NULL || *filename == '\0')
+		return;
+
+	trace_filename = g_strdup (filename);
+	trace_ring = g_new0 (TraceEvent, TRACE_RING_SIZE);
+
+#ifdef G_OS_UNIX
+	g_unix_signal_add (SIGUSR1, trace_sigusr1, NULL);
+#endif
+}
+
+static gint
+get_tid (void)
+{
+	gint tid;
+
+	tid = GPOINTER_TO_INT (g_private_get (&trace_tid));
+
+	if (G_UNLIKELY (tid == 0))
+	{
+		tid = g_atomic_int_add (&trace_next_tid, 1) + 1;
+		g_private_set (&trace_tid, GINT_TO_POINTER (tid));
+	}
+
+	return tid;
+}
+
+static void
+trace_record (PlumaDebugSection  section,
+	      const gchar       *name,
+	      gchar              phase,
+	      gint64             ts,
+	      gint64             value)
+{
+	TraceEvent *event;
+	guint slot;
+
+	slot = (guint) g_atomic_int_add (&trace_next, 1) & (TRACE_RING_SIZE - 1);
+	event = &trace_ring[slot];
+
+	event->name = name;
+	event->section = section;
+	event->phase = phase;
+	event->tid = get_tid ();
+	event->ts = ts;
+	event->value = value;
+}
+
+gboolean
+pluma_trace_is_enabled (void)
+{
+	return trace_ring != NULL;
+}
+
+/**
+ * pluma_trace_begin:
+ *
+ * Returns: the start time of a span, or 0 if tracing is disabled.
+ */
+gint64
+pluma_trace_begin (void)
+{
+	if (G_LIKELY (trace_ring == NULL))
+		return 0;
+
+	return g_get_monotonic_time ();
+}
+
+void
+pluma_trace_end (PlumaDebugSection  section,
+		 const gchar       *name,
+		 gint64             begin)
+{
+	/* tracing was not enabled when the span began */
+	if (G_LIKELY (begin == 0))
+		return;
+
+	trace_record (section, name, 'X', begin, g_get_monotonic_time () - begin);
+}
+
+void
+pluma_trace_counter (PlumaDebugSection  section,
+		     const gchar       *name,
+		     gint64             value)
+{
+	if (G_LIKELY (trace_ring == NULL))
+		return;
+
+	trace_record (section, name, 'C', g_get_monotonic_time (), value);
+}
+
+/**
+ * pluma_trace_dump:
+ * @filename: (allow-none): where to write the trace, %NULL for the
+ * file named by the PLUMA_TRACE environment variable.
+ * @error: return location for a #GError
+ *
+ * Writes the content of the trace ring buffer as a Chrome/Perfetto
+ * JSON trace, it can be opened in ui.perfetto.dev or chrome://tracing.
+ *
+ * Returns: %TRUE on success.
+ */
+gboolean
+pluma_trace_dump (const gchar  *filename,
+		  GError      **error)
+{
+	GString *json;
+	guint next;
+	guint first;
+	guint count;
+	guint i;
+	gint pid = 0;
+	gboolean written = FALSE;
+	gboolean ret;
+
+	if (trace_ring == NULL)
+	{
+		g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_INITIALIZED,
+				     "Tracing is not enabled, set PLUMA_TRACE");
+		return FALSE;
+	}
+
+	if (filename == NULL)
+		filename = trace_filename;
+
+#ifdef G_OS_UNIX
+	pid = getpid ();
+#endif
+
+	next = (guint) g_atomic_int_get (&trace_next);
+	count = MIN (next, TRACE_RING_SIZE);
+	first = next - count;
+
+	json = g_string_sized_new (count * 96 + 64);
+	g_string_append (json, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+	for (i = 0; i < count; i++)
+	{
+		const TraceEvent *event;
+
+		event = &trace_ring[(first + i) & (TRACE_RING_SIZE - 1)];
+
+		/* slot reserved but not written yet */
+		if (event->name == NULL)
+			continue;
+
+		g_string_append_printf (json,
+					"%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\","
+					"\"pid\":%d,\"tid\":%d,\"ts\":%" G_GINT64_FORMAT,
+					written ? "," : "",
+					event->name,
+					section_name (event->section),
+					event->phase,
+					pid,
+					event->tid,
+					event->ts);
+
+		if (event->phase == 'X')
+			g_string_append_printf (json, ",\"dur\":%" G_GINT64_FORMAT "}",
+						event->value);
+		else
+			g_string_append_printf (json, ",\"args\":{\"value\":%" G_GINT64_FORMAT "}}",
+						event->value);
+
+		written = TRUE;
+	}
+
+	g_string_append (json, "\n]}\n");
+
+	ret = g_file_set_contents (filename, json->str, json->len, error);
+
+	g_string_free (json, TRUE);
+
+	return ret;
+}
+
+void
+pluma_trace_shutdown (void)
+{
+	GError *error = NULL;
+
+	if (trace_ring == NULL)
+		return;
+
+	if (!pluma_trace_dump (NULL, &error))
+	{
+		g_warning ("Could not write trace: %s", error->message);
+		g_error_free (error);
+	}
+
+	g_free (trace_ring);
+	trace_ring = NULL;
+
+	g_free (trace_filename);
+	trace_filename = NULL;
+}
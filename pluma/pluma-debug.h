@@ -91,5 +91,36 @@ void pluma_debug_message (PlumaDebugSection  section,
 			  const gchar       *function,
 			  const gchar       *format, ...) G_GNUC_PRINTF(5, 6);
 
+/*
+ * Tracing: set the PLUMA_TRACE environment variable to a file name to
+ * record spans and counters in an in-memory ring buffer. The buffer is
+ * written to that file as Chrome/Perfetto trace JSON when pluma exits,
+ * when it receives SIGUSR1, or when pluma_trace_dump() is called.
+ *
+ * Unlike pluma_debug_message() this has no cost besides a branch when
+ * tracing is disabled. The names given to the functions below must be
+ * static strings, they are stored as is in the ring buffer.
+ *
+ *	gint64 begin = pluma_trace_begin ();
+ *	...
+ *	pluma_trace_end (PLUMA_DEBUG_LOADER, "load-chunk", begin);
+ */
+gint64   pluma_trace_begin    (void);
+
+void     pluma_trace_end      (PlumaDebugSection  section,
+			       const gchar       *name,
+			       gint64             begin);
+
+void     pluma_trace_counter  (PlumaDebugSection  section,
+			       const gchar       *name,
+			       gint64             value);
+
+gboolean pluma_trace_is_enabled (void);
+
+gboolean pluma_trace_dump     (const gchar       *filename,
+			       GError           **error);
+
+void     pluma_trace_shutdown (void);
+
 
 #endif /* __PLUMA_DEBUG_H__ */
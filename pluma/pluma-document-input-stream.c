@@ -296,8 +296,6 @@ read_line (PlumaDocumentInputStream *stream,
 
 	gtk_text_iter_forward_line (&next);
 
-	buf = gtk_text_iter_get_slice (&start, &end);
-
 	/* the bytes of a line includes also the newline, so with the
 	   offsets we remove the newline and we add the new newline size */
 	bytes = gtk_text_iter_get_bytes_in_line (&start) - stream->priv->bytes_partial;
@@ -320,11 +318,24 @@ read_line (PlumaDocumentInputStream *stream,
 
 	if (bytes_to_write > space_left)
 	{
+		GtkTextIter limit;
 		gchar *ptr;
 		gint char_offset;
 		gint written;
 		gsize to_write;
 
+		/* Do not copy the whole rest of the line when only space_left
+		   bytes fit, or saving a very long line gets quadratic: every
+		   character takes at least one byte, so space_left characters
+		   are always enough */
+		limit = start;
+		gtk_text_iter_forward_chars (&limit, MIN (space_left, G_MAXINT));
+
+		if (gtk_text_iter_compare (&limit, &end) > 0)
+			limit = end;
+
+		buf = gtk_text_iter_get_slice (&start, &limit);
+
 		/* Here the line does not fit in the buffer, we thus write
 		   the amount of bytes we can still fit, storing the position
 		   for the next read with the mark. Do not try to write the
@@ -361,6 +372,8 @@ read_line (PlumaDocumentInputStream *stream,
 	}
 	else
 	{
+		buf = gtk_text_iter_get_slice (&start, &end);
+
 		/* First just copy the bytes without the newline */
 		memcpy (outbuf, buf, bytes);
 
@@ -80,6 +80,10 @@ enum
 };
 
 #define READ_CHUNK_SIZE 8192
+
+/* bytes kept from the start and the end of the text, see
+ * pluma_document_loader_get_head() */
+#define HINT_SIZE 4096
 #define REMOTE_QUERY_ATTRIBUTES G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE "," \
                                 G_FILE_ATTRIBUTE_STANDARD_TYPE "," \
                                 G_FILE_ATTRIBUTE_TIME_MODIFIED "," \
@@ -114,6 +118,11 @@ struct _PlumaDocumentLoaderPrivate
 
     gchar                        buffer[READ_CHUNK_SIZE];
 
+    /* First and last bytes of the converted text */
+    GString                     *head;
+    GString                     *tail;
+    goffset                      text_length;
+
     GError                      *error;
 };
 
@@ -185,6 +194,9 @@ pluma_document_loader_finalize (GObject *object)
 
     g_free (priv->uri);
 
+    g_string_free (priv->head, TRUE);
+    g_string_free (priv->tail, TRUE);
+
     G_OBJECT_CLASS (pluma_document_loader_parent_class)->finalize (object);
 }
 
@@ -309,6 +321,8 @@ pluma_document_loader_init (PlumaDocumentLoader *loader)
     loader->priv->converter = NULL;
     loader->priv->error = NULL;
     loader->priv->enc_settings = g_settings_new (PLUMA_SCHEMA_ID);
+    loader->priv->head = g_string_sized_new (HINT_SIZE);
+    loader->priv->tail = g_string_sized_new (HINT_SIZE);
 }
 
 PlumaDocumentLoader *
@@ -454,15 +468,47 @@ write_complete (AsyncData *async)
 /* prototype, because they call each other... isn't C lovely */
 static void    read_file_chunk        (AsyncData *async);
 
+static void
+collect_hint_text (PlumaDocumentLoader *loader,
+                   const gchar         *text,
+                   gsize                len)
+{
+    GString *head = loader->priv->head;
+    GString *tail = loader->priv->tail;
+
+    if (head->len < HINT_SIZE)
+        g_string_append_len (head, text, MIN (len, HINT_SIZE - head->len));
+
+    if (len >= HINT_SIZE)
+    {
+        g_string_truncate (tail, 0);
+        g_string_append_len (tail, text + len - HINT_SIZE, HINT_SIZE);
+    }
+    else
+    {
+        g_string_append_len (tail, text, len);
+
+        if (tail->len > HINT_SIZE)
+            g_string_erase (tail, 0, tail->len - HINT_SIZE);
+    }
+
+    loader->priv->text_length += len;
+}
+
 static void
 write_file_chunk (AsyncData *async)
 {
     PlumaDocumentLoader *loader;
     gssize bytes_written;
     GError *error = NULL;
+    gint64 trace;
 
     loader = async->loader;
 
+    trace = pluma_trace_begin ();
+
+    collect_hint_text (loader, loader->priv->buffer, async->read);
+
     /* we use sync methods on doc stream since it is in memory. Using async
        would be racy and we can endup with invalidated iters */
     bytes_written = g_output_stream_write (G_OUTPUT_STREAM (loader->priv->output),
@@ -479,6 +525,9 @@ write_file_chunk (AsyncData *async)
         return;
     }
 
+    pluma_trace_end (PLUMA_DEBUG_LOADER, "load-chunk", trace);
+    pluma_trace_counter (PLUMA_DEBUG_LOADER, "bytes-read", loader->priv->bytes_read);
+
     /* note that this signal blocks the read... check if it isn't
      * a performance problem
      */
@@ -910,6 +959,89 @@ pluma_document_loader_get_bytes_read (PlumaDocumentLoader *loader)
     return loader->priv->bytes_read;
 }
 
+gsize
+pluma_document_loader_get_longest_line (PlumaDocumentLoader *loader)
+{
+    g_return_val_if_fail (PLUMA_IS_DOCUMENT_LOADER (loader), 0);
+
+    if (loader->priv->output == NULL)
+        return 0;
+
+    return pluma_document_output_stream_get_longest_line (PLUMA_DOCUMENT_OUTPUT_STREAM (loader->priv->output));
+}
+
+/* The hints are cut at a byte count: a line longer than HINT_SIZE ends
+ * them inside a character, which must not reach the signal */
+static gchar *
+dup_valid_utf8 (const gchar *str,
+                gsize        len)
+{
+    const gchar *end;
+
+    g_utf8_validate (str, len, &end);
+
+    return g_strndup (str, end - str);
+}
+
+/* The text as read (only converted to UTF-8), before it goes through
+ * the document. A line cut by HINT_SIZE is left out. */
+gchar *
+pluma_document_loader_get_head (PlumaDocumentLoader *loader)
+{
+    GString *head;
+    gsize len;
+
+    g_return_val_if_fail (PLUMA_IS_DOCUMENT_LOADER (loader), NULL);
+
+    head = loader->priv->head;
+    len = head->len;
+
+    if (loader->priv->text_length > (goffset) head->len)
+    {
+        while (len > 0 && head->str[len - 1] != '\n' && head->str[len - 1] != '\r')
+            len--;
+
+        if (len == 0)
+            len = head->len;
+    }
+
+    return dup_valid_utf8 (head->str, len);
+}
+
+/* NULL when the head already holds the whole text */
+gchar *
+pluma_document_loader_get_tail (PlumaDocumentLoader *loader)
+{
+    GString *tail;
+    gsize start;
+
+    g_return_val_if_fail (PLUMA_IS_DOCUMENT_LOADER (loader), NULL);
+
+    if (loader->priv->text_length <= (goffset) loader->priv->head->len)
+        return NULL;
+
+    tail = loader->priv->tail;
+    start = 0;
+
+    if (loader->priv->text_length > (goffset) tail->len)
+    {
+        while (start < tail->len && tail->str[start] != '\n' && tail->str[start] != '\r')
+            start++;
+
+        if (start == tail->len)
+        {
+            /* no line break: skip the rest of a character cut by the
+             * start of the tail */
+            start = 0;
+
+            while (start < tail->len && (tail->str[start] & 0xc0) == 0x80)
+                start++;
+        }
+    }
+
+    return dup_valid_utf8 (tail->str + start, tail->len - start);
+}
+
 const PlumaEncoding *
 pluma_document_loader_get_encoding (PlumaDocumentLoader *loader)
 {
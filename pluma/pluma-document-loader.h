@@ -108,6 +108,14 @@ PlumaDocumentNewlineType     pluma_document_loader_get_newline_type (PlumaDocume
 
 goffset                      pluma_document_loader_get_bytes_read (PlumaDocumentLoader *loader);
 
+/* Length in bytes of the longest line read so far */
+gsize                        pluma_document_loader_get_longest_line (PlumaDocumentLoader *loader);
+
+/* First and last lines of the text read so far, see PlumaDocument::load-hints */
+gchar                       *pluma_document_loader_get_head (PlumaDocumentLoader *loader);
+
+gchar                       *pluma_document_loader_get_tail (PlumaDocumentLoader *loader);
+
 /* You can get from the info: content_type, time_modified, standard_size, access_can_write
    and also the metadata*/
 GFileInfo                   *pluma_document_loader_get_info (PlumaDocumentLoader *loader);
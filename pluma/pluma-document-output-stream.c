@@ -28,6 +28,7 @@
 #include <glib/gi18n.h>
 #include <gio/gio.h>
 #include "pluma-document-output-stream.h"
+#include "pluma-debug.h"
 
 /* NOTE: never use async methods on this stream, the stream is just
  * a wrapper around GtkTextBuffer api so that we can use GIO Stream
@@ -45,6 +46,10 @@ struct _PlumaDocumentOutputStreamPrivate
 	gchar *buffer;
 	gsize buflen;
 
+	/* in bytes, used to detect files with huge lines */
+	gsize line_length;
+	gsize longest_line;
+
 	guint is_initialized : 1;
 	guint is_closed : 1;
 };
@@ -239,6 +244,40 @@ pluma_document_output_stream_detect_newline_type (PlumaDocumentOutputStream *str
 	return type;
 }
 
+gsize
+pluma_document_output_stream_get_longest_line (PlumaDocumentOutputStream *stream)
+{
+	g_return_val_if_fail (PLUMA_IS_DOCUMENT_OUTPUT_STREAM (stream), 0);
+
+	return MAX (stream->priv->longest_line, stream->priv->line_length);
+}
+
+static void
+update_longest_line (PlumaDocumentOutputStream *stream,
+		     const gchar               *text,
+		     gsize                      len)
+{
+	const gchar *p;
+	const gchar *end = text + len;
+	gsize line_length = stream->priv->line_length;
+
+	for (p = text; p < end; p++)
+	{
+		if (*p == '\n' || *p == '\r')
+		{
+			stream->priv->longest_line = MAX (stream->priv->longest_line,
+							  line_length);
+			line_length = 0;
+		}
+		else
+		{
+			line_length++;
+		}
+	}
+
+	stream->priv->line_length = line_length;
+}
+
 /* If the last char is a newline, remove it from the buffer (otherwise
    GtkTextView shows it as an empty line). See bug #324942. */
 static void
@@ -291,6 +330,7 @@ pluma_document_output_stream_write (GOutputStream            *stream,
 	gboolean freetext = FALSE;
 	const gchar *end;
 	gboolean valid;
+	gint64 trace;
 
 	if (g_cancellable_set_error_if_cancelled (cancellable, error))
 		return -1;
@@ -364,9 +404,15 @@ pluma_document_output_stream_write (GOutputStream            *stream,
 		}
 	}
 
+	update_longest_line (ostream, text, len);
+
+	trace = pluma_trace_begin ();
+
 	gtk_text_buffer_insert (GTK_TEXT_BUFFER (ostream->priv->doc),
 				&ostream->priv->pos, text, len);
 
+	pluma_trace_end (PLUMA_DEBUG_DOCUMENT, "buffer-insert", trace);
+
 	if (freetext)
 		g_free (text);
 
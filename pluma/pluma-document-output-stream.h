@@ -60,6 +60,8 @@ GOutputStream		*pluma_document_output_stream_new		(PlumaDocument *doc);
 
 PlumaDocumentNewlineType pluma_document_output_stream_detect_newline_type (PlumaDocumentOutputStream *stream);
 
+gsize			 pluma_document_output_stream_get_longest_line	(PlumaDocumentOutputStream *stream);
+
 G_END_DECLS
 
 #endif /* __PLUMA_DOCUMENT_OUTPUT_STREAM_H__ */
@@ -637,12 +637,15 @@ read_file_chunk (AsyncData *async)
     PlumaDocumentSaver *saver;
     PlumaDocumentInputStream *dstream;
     GError *error = NULL;
+    gint64 trace;
 
     pluma_debug (DEBUG_SAVER);
 
     saver = async->saver;
     async->written = 0;
 
+    trace = pluma_trace_begin ();
+
     /* we use sync methods on doc stream since it is in memory. Using async
        would be racy and we can endup with invalidated iters */
     async->read = g_input_stream_read (saver->priv->input,
@@ -657,6 +660,8 @@ read_file_chunk (AsyncData *async)
         return;
     }
 
+    pluma_trace_end (PLUMA_DEBUG_SAVER, "save-chunk", trace);
+
     /* Check if we finished reading and writing */
     if (async->read == 0)
     {
@@ -45,6 +45,7 @@
 #include "pluma-document.h"
 #include "pluma-debug.h"
 #include "pluma-utils.h"
+#include "pluma-literal-search.h"
 #include "pluma-language-manager.h"
 #include "pluma-style-scheme-manager.h"
 #include "pluma-document-loader.h"
@@ -76,6 +77,13 @@ PROFILE (static GTimer *timer = NULL)
 #define PLUMA_MAX_PATH_LEN  2048
 #endif
 
+/* Documents bigger than this are switched to large file mode */
+#define LARGE_FILE_SIZE		(32 * 1024 * 1024)
+
+/* Documents with a line longer than this (in bytes) are switched to large
+ * file mode, and their views to long line mode */
+#define LONG_LINE_LENGTH	(16 * 1024)
+
 /* undo https://gitlab.gnome.org/GNOME/gtksourceview/-/commit/b3dffc39 */
 #undef GTK_SOURCE_CHECK_VERSION
 #define GTK_SOURCE_CHECK_VERSION(major, minor, micro) \
@@ -93,6 +101,8 @@ static void	pluma_document_save_real	(PlumaDocument          *doc,
 						 const gchar            *uri,
 						 const PlumaEncoding    *encoding,
 						 PlumaDocumentSaveFlags  flags);
+static void	invalidate_search_highlight	(PlumaDocument *doc);
+static void	stop_watching_location		(PlumaDocument *doc);
 static void	to_search_region_range 		(PlumaDocument *doc,
 						 GtkTextIter   *start,
 						 GtkTextIter   *end);
@@ -122,11 +132,23 @@ struct _PlumaDocumentPrivate
 	gint64       mtime;
 	gint64       time_of_last_save_or_load;
 
+	/* Watch for changes of the file by other programs: a monitor for
+	 * local files, polling (at most every CHECK_INTERVAL) for the
+	 * others */
+	GFileMonitor *monitor;
+	GCancellable *check_cancellable;
+	gint64        last_check;
+	gboolean      check_again;
+	gboolean      externally_modified;
+
 	guint        search_flags;
 	gchar       *search_text;
 	gchar       *last_replace_text;
 	gint	     num_of_lines_search_text;
 
+	/* compiled search_text, when it is not a regex */
+	PlumaLiteralSearch *literal_search;
+
 	PlumaDocumentNewlineType newline_type;
 
 	/* Temp data while loading */
@@ -139,15 +161,26 @@ struct _PlumaDocumentPrivate
 	/* Saving stuff */
 	PlumaDocumentSaver *saver;
 
-	/* Search highlighting support variables */
+	/* Search highlighting support variables: to_search_region holds
+	 * what still has to be searched, highlighted_region the ranges where
+	 * the found_tag has been applied. highlight_generation is bumped
+	 * every time something is added to to_search_region. */
 	PlumaTextRegion *to_search_region;
+	PlumaTextRegion *highlighted_region;
 	GtkTextTag      *found_tag;
+	guint            highlight_generation;
 
 	/* Mount operation factory */
 	PlumaMountOperationFactory  mount_operation_factory;
 	gpointer		    mount_operation_userdata;
 
+	gsize	     longest_line;
+
+	/* Language given by a "load-hints" handler, while loading */
+	GtkSourceLanguage *language_hint;
+
 	gint readonly : 1;
+	guint large_file_mode : 1;
 	gint last_save_was_manually : 1;
 	gint language_set_by_user : 1;
 	gint stop_cursor_moved_emission : 1;
@@ -165,13 +198,16 @@ enum {
 	PROP_ENCODING,
 	PROP_CAN_SEARCH_AGAIN,
 	PROP_ENABLE_SEARCH_HIGHLIGHTING,
-	PROP_NEWLINE_TYPE
+	PROP_NEWLINE_TYPE,
+	PROP_LARGE_FILE_MODE,
+	PROP_EXTERNALLY_MODIFIED
 };
 
 enum {
 	CURSOR_MOVED,
 	LOAD,
 	LOADING,
+	LOAD_HINTS,
 	LOADED,
 	SAVE,
 	SAVING,
@@ -291,6 +327,8 @@ pluma_document_dispose (GObject *object)
 
 	g_clear_object (&doc->priv->editor_settings);
 
+	stop_watching_location (doc);
+
 	doc->priv->dispose_has_run = TRUE;
 
 	G_OBJECT_CLASS (pluma_document_parent_class)->dispose (object);
@@ -313,11 +351,13 @@ pluma_document_finalize (GObject *object)
 	g_free (doc->priv->content_type);
 	g_free (doc->priv->search_text);
 	g_free (doc->priv->last_replace_text);
+	pluma_literal_search_free (doc->priv->literal_search);
 
 	if (doc->priv->to_search_region != NULL)
 	{
 		/* we can't delete marks if we're finalizing the buffer */
 		pluma_text_region_destroy (doc->priv->to_search_region, FALSE);
+		pluma_text_region_destroy (doc->priv->highlighted_region, FALSE);
 	}
 
 	G_OBJECT_CLASS (pluma_document_parent_class)->finalize (object);
@@ -360,6 +400,12 @@ pluma_document_get_property (GObject    *object,
 		case PROP_NEWLINE_TYPE:
 			g_value_set_enum (value, doc->priv->newline_type);
 			break;
+		case PROP_LARGE_FILE_MODE:
+			g_value_set_boolean (value, doc->priv->large_file_mode);
+			break;
+		case PROP_EXTERNALLY_MODIFIED:
+			g_value_set_boolean (value, doc->priv->externally_modified);
+			break;
 		default:
 			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 			break;
@@ -435,6 +481,19 @@ pluma_document_changed (GtkTextBuffer *buffer)
 	GTK_TEXT_BUFFER_CLASS (pluma_document_parent_class)->changed (buffer);
 }
 
+static gboolean
+load_hints_accumulator (GSignalInvocationHint *ihint,
+			GValue                *return_accu,
+			const GValue          *handler_return,
+			gpointer               data)
+{
+	/* keep the first language, but let all the handlers run */
+	if (g_value_get_string (return_accu) == NULL)
+		g_value_set_string (return_accu, g_value_get_string (handler_return));
+
+	return TRUE;
+}
+
 static void
 pluma_document_class_init (PlumaDocumentClass *klass)
 {
@@ -532,6 +591,37 @@ pluma_document_class_init (PlumaDocumentClass *klass)
 	                                                    G_PARAM_STATIC_NAME |
 	                                                    G_PARAM_STATIC_BLURB));
 
+	/**
+	 * PlumaDocument:large-file-mode:
+	 *
+	 * Whether the document is so big, or has lines so long, that the
+	 * costly features (syntax and search highlighting, bracket matching,
+	 * spell checking...) are turned off. Plugins doing work proportional
+	 * to the size of the document should do the same.
+	 */
+	g_object_class_install_property (object_class, PROP_LARGE_FILE_MODE,
+					 g_param_spec_boolean ("large-file-mode",
+							       "Large File Mode",
+							       "Whether the costly features are disabled for this document",
+							       FALSE,
+							       G_PARAM_READABLE |
+							       G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * PlumaDocument:externally-modified:
+	 *
+	 * Whether the file was modified by another program since it was
+	 * loaded or saved. It is updated in the background, see
+	 * _pluma_document_check_externally_modified().
+	 */
+	g_object_class_install_property (object_class, PROP_EXTERNALLY_MODIFIED,
+					 g_param_spec_boolean ("externally-modified",
+							       "Externally Modified",
+							       "Whether the file was modified by another program",
+							       FALSE,
+							       G_PARAM_READABLE |
+							       G_PARAM_STATIC_STRINGS));
+
 	/* This signal is used to update the cursor position is the statusbar,
 	 * it's emitted either when the insert mark is moved explicitely or
 	 * when the buffer changes (insert/delete).
@@ -584,6 +674,33 @@ pluma_document_class_init (PlumaDocumentClass *klass)
 			      G_TYPE_UINT64,
 			      G_TYPE_UINT64);
 
+	/**
+	 * PlumaDocument::load-hints:
+	 * @document: the #PlumaDocument.
+	 * @head: the first lines of the text.
+	 * @tail: (allow-none): the last lines of the text, %NULL if @head
+	 *        holds all of it.
+	 *
+	 * The "load-hints" signal is emitted when the text of the document
+	 * has been read, before its language is chosen and before "loaded".
+	 * Handlers can look at the text there (e.g. for modelines) without
+	 * reading the buffer back, and set the document up before the
+	 * highlighting starts.
+	 *
+	 * Returns: the id of the language to use for @document, or %NULL.
+	 * The first handler returning one wins.
+	 */
+	document_signals[LOAD_HINTS] =
+		g_signal_new ("load-hints",
+			      G_OBJECT_CLASS_TYPE (object_class),
+			      G_SIGNAL_RUN_LAST,
+			      0,
+			      load_hints_accumulator, NULL, NULL,
+			      G_TYPE_STRING,
+			      2,
+			      G_TYPE_STRING,
+			      G_TYPE_STRING);
+
 	document_signals[LOADED] =
    		g_signal_new ("loaded",
 			      G_OBJECT_CLASS_TYPE (object_class),
@@ -747,7 +864,8 @@ set_language (PlumaDocument     *doc,
 		gboolean syntax_hl;
 
 		syntax_hl = g_settings_get_boolean (doc->priv->editor_settings,
-						    PLUMA_SETTINGS_SYNTAX_HIGHLIGHTING);
+						    PLUMA_SETTINGS_SYNTAX_HIGHLIGHTING) &&
+			    !doc->priv->large_file_mode;
 
 		gtk_source_buffer_set_highlight_syntax (GTK_SOURCE_BUFFER (doc),
 							syntax_hl);
@@ -872,6 +990,14 @@ guess_language (PlumaDocument *doc,
 	gchar *data;
 	GtkSourceLanguage *language = NULL;
 
+	if (doc->priv->language_hint != NULL)
+	{
+		pluma_debug_message (DEBUG_DOCUMENT, "Language from load hints: %s",
+				     gtk_source_language_get_id (doc->priv->language_hint));
+
+		return doc->priv->language_hint;
+	}
+
 	data = pluma_document_get_metadata (doc, PLUMA_METADATA_ATTRIBUTE_LANGUAGE);
 
 	if (data != NULL)
@@ -1296,27 +1422,41 @@ pluma_document_get_readonly (PlumaDocument *doc)
 	return doc->priv->readonly;
 }
 
-gboolean
-_pluma_document_check_externally_modified (PlumaDocument *doc)
+/* how often files without a monitor (e.g. remote) are checked, in us */
+#define CHECK_INTERVAL (5 * G_USEC_PER_SEC)
+
+static void
+set_externally_modified (PlumaDocument *doc,
+			 gboolean       externally_modified)
+{
+	if (doc->priv->externally_modified == externally_modified)
+		return;
+
+	doc->priv->externally_modified = externally_modified;
+
+	g_object_notify (G_OBJECT (doc), "externally-modified");
+}
+
+static void check_location (PlumaDocument *doc);
+
+static void
+location_info_queried (GFile         *location,
+		       GAsyncResult  *result,
+		       PlumaDocument *doc)
 {
-	GFile *gfile;
 	GFileInfo *info;
+	GError *error = NULL;
 
-	g_return_val_if_fail (PLUMA_IS_DOCUMENT (doc), FALSE);
+	info = g_file_query_info_finish (location, result, &error);
 
-	if (doc->priv->uri == NULL)
+	/* the document may be gone already */
+	if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
 	{
-		return FALSE;
+		g_error_free (error);
+		return;
 	}
 
-	gfile = g_file_new_for_uri (doc->priv->uri);
-	info = g_file_query_info (gfile,
-	                          G_FILE_ATTRIBUTE_TIME_MODIFIED "," \
-	                          G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC "," \
-	                          G_FILE_ATTRIBUTE_ACCESS_CAN_WRITE,
-	                          G_FILE_QUERY_INFO_NONE,
-	                          NULL, NULL);
-	g_object_unref (gfile);
+	g_clear_object (&doc->priv->check_cancellable);
 
 	if (info != NULL)
 	{
@@ -1344,13 +1484,150 @@ _pluma_document_check_externally_modified (PlumaDocument *doc)
 				                                         G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
 				timeval += (guint64) usec;
 			}
-			g_object_unref (info);
 
-			return (((gint64) timeval) > doc->priv->mtime);
+			if (((gint64) timeval) > doc->priv->mtime)
+				set_externally_modified (doc, TRUE);
 		}
+
+		g_object_unref (info);
+	}
+	else
+	{
+		/* e.g. the file was removed: nothing to reload */
+		g_error_free (error);
 	}
 
-	return FALSE;
+	/* the file changed again while we were looking at it */
+	if (doc->priv->check_again)
+	{
+		doc->priv->check_again = FALSE;
+		check_location (doc);
+	}
+}
+
+static void
+check_location (PlumaDocument *doc)
+{
+	GFile *location;
+
+	if (doc->priv->uri == NULL)
+		return;
+
+	if (doc->priv->check_cancellable != NULL)
+	{
+		doc->priv->check_again = TRUE;
+		return;
+	}
+
+	doc->priv->last_check = g_get_monotonic_time ();
+	doc->priv->check_cancellable = g_cancellable_new ();
+
+	location = g_file_new_for_uri (doc->priv->uri);
+
+	g_file_query_info_async (location,
+				 G_FILE_ATTRIBUTE_TIME_MODIFIED "," \
+				 G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC "," \
+				 G_FILE_ATTRIBUTE_ACCESS_CAN_WRITE,
+				 G_FILE_QUERY_INFO_NONE,
+				 G_PRIORITY_DEFAULT,
+				 doc->priv->check_cancellable,
+				 (GAsyncReadyCallback) location_info_queried,
+				 doc);
+
+	g_object_unref (location);
+}
+
+static void
+location_changed (GFileMonitor      *monitor,
+		  GFile             *file,
+		  GFile             *other_file,
+		  GFileMonitorEvent  event_type,
+		  PlumaDocument     *doc)
+{
+	switch (event_type)
+	{
+		case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+		case G_FILE_MONITOR_EVENT_ATTRIBUTE_CHANGED:
+		case G_FILE_MONITOR_EVENT_CREATED:
+			check_location (doc);
+			break;
+		default:
+			/* CHANGED comes for each write, wait for the hint */
+			break;
+	}
+}
+
+static void
+stop_watching_location (PlumaDocument *doc)
+{
+	if (doc->priv->check_cancellable != NULL)
+	{
+		g_cancellable_cancel (doc->priv->check_cancellable);
+		g_clear_object (&doc->priv->check_cancellable);
+	}
+
+	if (doc->priv->monitor != NULL)
+	{
+		g_signal_handlers_disconnect_by_func (doc->priv->monitor,
+						      location_changed,
+						      doc);
+		g_file_monitor_cancel (doc->priv->monitor);
+		g_clear_object (&doc->priv->monitor);
+	}
+
+	doc->priv->check_again = FALSE;
+}
+
+/* Called when the file has just been loaded or saved: it is in sync */
+static void
+watch_location (PlumaDocument *doc)
+{
+	stop_watching_location (doc);
+
+	set_externally_modified (doc, FALSE);
+	doc->priv->last_check = g_get_monotonic_time ();
+
+	if (doc->priv->uri != NULL && pluma_document_is_local (doc))
+	{
+		GFile *location;
+
+		location = g_file_new_for_uri (doc->priv->uri);
+		doc->priv->monitor = g_file_monitor_file (location,
+							  G_FILE_MONITOR_NONE,
+							  NULL,
+							  NULL);
+		g_object_unref (location);
+
+		if (doc->priv->monitor != NULL)
+		{
+			g_signal_connect (doc->priv->monitor,
+					  "changed",
+					  G_CALLBACK (location_changed),
+					  doc);
+		}
+	}
+}
+
+/* Does no I/O: returns what the monitor (or the last poll) found. When
+ * there is no monitor and the last poll is old, a new one is started,
+ * its result comes with a notification of "externally-modified". */
+gboolean
+_pluma_document_check_externally_modified (PlumaDocument *doc)
+{
+	g_return_val_if_fail (PLUMA_IS_DOCUMENT (doc), FALSE);
+
+	if (doc->priv->uri == NULL)
+	{
+		return FALSE;
+	}
+
+	if (doc->priv->monitor == NULL &&
+	    g_get_monotonic_time () - doc->priv->last_check >= CHECK_INTERVAL)
+	{
+		check_location (doc);
+	}
+
+	return doc->priv->externally_modified;
 }
 
 static void
@@ -1364,6 +1641,49 @@ reset_temp_loading_data (PlumaDocument       *doc)
 	doc->priv->requested_line_pos = 0;
 }
 
+static GtkSourceLanguage *
+emit_load_hints (PlumaDocument       *doc,
+		 PlumaDocumentLoader *loader)
+{
+	gchar *head;
+	gchar *tail;
+	gchar *language_id = NULL;
+	GtkSourceLanguage *language = NULL;
+
+	head = pluma_document_loader_get_head (loader);
+	tail = pluma_document_loader_get_tail (loader);
+
+	g_signal_emit (doc,
+		       document_signals[LOAD_HINTS],
+		       0,
+		       head,
+		       tail,
+		       &language_id);
+
+	if (language_id != NULL)
+	{
+		language = gtk_source_language_manager_get_language (pluma_get_language_manager (),
+								     language_id);
+		g_free (language_id);
+	}
+
+	g_free (head);
+	g_free (tail);
+
+	return language;
+}
+
+static void
+check_large_file (PlumaDocument       *doc,
+		  PlumaDocumentLoader *loader,
+		  goffset              size)
+{
+	/* also on reload and revert, the file may have become small */
+	_pluma_document_set_large_file_mode (doc,
+					     size >= LARGE_FILE_SIZE ||
+					     pluma_document_loader_get_longest_line (loader) >= LONG_LINE_LENGTH);
+}
+
 static void
 document_loader_loaded (PlumaDocumentLoader *loader,
 			const GError        *error,
@@ -1408,6 +1728,12 @@ document_loader_loaded (PlumaDocumentLoader *loader,
 		}
 
 		doc->priv->mtime = (gint64) mtime;
+		watch_location (doc);
+
+		doc->priv->longest_line = pluma_document_loader_get_longest_line (loader);
+
+		check_large_file (doc, loader,
+				  pluma_document_loader_get_bytes_read (loader));
 
 		set_readonly (doc, read_only);
 
@@ -1417,8 +1743,21 @@ document_loader_loaded (PlumaDocumentLoader *loader,
 			      pluma_document_loader_get_encoding (loader),
 			      (doc->priv->requested_encoding != NULL));
 
+		/* the handlers may pick the language: it is applied by
+		 * set_content_type, instead of the guessed one */
+		doc->priv->language_hint = emit_load_hints (doc, loader);
+
 		set_content_type (doc, content_type);
 
+		if (doc->priv->language_hint != NULL &&
+		    !doc->priv->language_set_by_user)
+		{
+			/* the content type did not change */
+			set_language (doc, doc->priv->language_hint, FALSE);
+		}
+
+		doc->priv->language_hint = NULL;
+
 		pluma_document_set_newline_type (doc,
 		                                 pluma_document_loader_get_newline_type (loader));
 
@@ -1514,6 +1853,10 @@ document_loader_loading (PlumaDocumentLoader *loader,
 
 		read = pluma_document_loader_get_bytes_read (loader);
 
+		/* switch as early as possible, so that the features are not
+		 * started on the text already inserted */
+		check_large_file (doc, loader, size);
+
 		g_signal_emit (doc,
 			       document_signals[LOADING],
 			       0,
@@ -1637,6 +1980,7 @@ document_saver_saving (PlumaDocumentSaver *saver,
 
 			set_content_type (doc, content_type);
 			doc->priv->mtime = (gint64) mtime;
+			watch_location (doc);
 
 			doc->priv->time_of_last_save_or_load = g_get_real_time ();
 
@@ -1957,18 +2301,7 @@ pluma_document_set_search_text (PlumaDocument *doc,
 	}
 
 	if (update_to_search_region)
-	{
-		GtkTextIter begin;
-		GtkTextIter end;
-
-		gtk_text_buffer_get_bounds (GTK_TEXT_BUFFER (doc),
-					    &begin,
-					    &end);
-
-		to_search_region_range (doc,
-					&begin,
-					&end);
-	}
+		invalidate_search_highlight (doc);
 
 	if (notify)
 		g_object_notify (G_OBJECT (doc), "can-search-again");
@@ -2029,6 +2362,28 @@ pluma_document_get_can_search_again (PlumaDocument *doc)
 	        (*doc->priv->search_text != '\0'));
 }
 
+/* Returns the literal search for the current search text, or NULL if
+ * it has to be searched as a regex */
+static PlumaLiteralSearch *
+get_literal_search (PlumaDocument *doc)
+{
+	if (PLUMA_SEARCH_IS_MATCH_REGEX (doc->priv->search_flags) ||
+	    doc->priv->search_text == NULL ||
+	    *doc->priv->search_text == '\0')
+		return NULL;
+
+	if (!pluma_literal_search_matches (doc->priv->literal_search,
+					   doc->priv->search_text,
+					   doc->priv->search_flags))
+	{
+		pluma_literal_search_free (doc->priv->literal_search);
+		doc->priv->literal_search = pluma_literal_search_new (doc->priv->search_text,
+								      doc->priv->search_flags);
+	}
+
+	return doc->priv->literal_search;
+}
+
 /**
  * pluma_document_search_forward:
  * @doc:
@@ -2049,6 +2404,7 @@ pluma_document_search_forward (PlumaDocument     *doc,
 	gboolean found = FALSE;
 	GtkTextIter m_start;
 	GtkTextIter m_end;
+	PlumaLiteralSearch *literal;
 
 	g_return_val_if_fail (PLUMA_IS_DOCUMENT (doc), FALSE);
 	g_return_val_if_fail ((start == NULL) ||
@@ -2076,9 +2432,21 @@ pluma_document_search_forward (PlumaDocument     *doc,
 		search_flags = search_flags | GTK_TEXT_SEARCH_CASE_INSENSITIVE;
 	}
 
+	literal = get_literal_search (doc);
+
 	while (!found)
 	{
-		if(!PLUMA_SEARCH_IS_MATCH_REGEX(doc->priv->search_flags))
+		if (literal != NULL)
+		{
+			/* entire words are checked by the literal search */
+			found = pluma_literal_search_forward (literal,
+							      &iter,
+							      end,
+							      &m_start,
+							      &m_end);
+			break;
+		}
+		else if(!PLUMA_SEARCH_IS_MATCH_REGEX(doc->priv->search_flags))
 		{
 			found = gtk_text_iter_forward_search (&iter,
 							      doc->priv->search_text,
@@ -2138,6 +2506,7 @@ pluma_document_search_backward (PlumaDocument     *doc,
 	gboolean found = FALSE;
 	GtkTextIter m_start;
 	GtkTextIter m_end;
+	PlumaLiteralSearch *literal;
 
 	g_return_val_if_fail (PLUMA_IS_DOCUMENT (doc), FALSE);
 	g_return_val_if_fail ((start == NULL) ||
@@ -2165,9 +2534,21 @@ pluma_document_search_backward (PlumaDocument     *doc,
 		search_flags = search_flags | GTK_TEXT_SEARCH_CASE_INSENSITIVE;
 	}
 
+	literal = get_literal_search (doc);
+
 	while (!found)
 	{
-		if(!PLUMA_SEARCH_IS_MATCH_REGEX(doc->priv->search_flags))
+		if (literal != NULL)
+		{
+			/* entire words are checked by the literal search */
+			found = pluma_literal_search_backward (literal,
+							       &iter,
+							       start,
+							       &m_start,
+							       &m_end);
+			break;
+		}
+		else if(!PLUMA_SEARCH_IS_MATCH_REGEX(doc->priv->search_flags))
 		{
 			found = gtk_text_iter_backward_search (&iter,
 							       doc->priv->search_text,
@@ -2228,6 +2609,7 @@ pluma_document_replace_all (PlumaDocument       *doc,
 	GtkTextBuffer *buffer;
 	gboolean brackets_highlighting;
 	gboolean search_highliting;
+	PlumaLiteralSearch *literal = NULL;
 
 	g_return_val_if_fail (PLUMA_IS_DOCUMENT (doc), 0);
 	g_return_val_if_fail (replace != NULL, 0);
@@ -2244,6 +2626,9 @@ pluma_document_replace_all (PlumaDocument       *doc,
 	{
 		replace_text = pluma_utils_unescape_search_text (replace);
 		replace_text_len = strlen (replace_text);
+
+		if (*search_text != '\0')
+			literal = pluma_literal_search_new (search_text, flags);
 	}
 
 	gtk_text_buffer_get_start_iter (buffer, &iter);
@@ -2274,7 +2659,15 @@ pluma_document_replace_all (PlumaDocument       *doc,
 
 	do
 	{
-		if(!PLUMA_SEARCH_IS_MATCH_REGEX(flags))
+		if (literal != NULL)
+		{
+			found = pluma_literal_search_forward (literal,
+							      &iter,
+							      NULL,
+							      &m_start,
+							      &m_end);
+		}
+		else if(!PLUMA_SEARCH_IS_MATCH_REGEX(flags))
 		{
 			found = gtk_text_iter_forward_search (&iter,
 							      search_text,
@@ -2340,6 +2733,8 @@ pluma_document_replace_all (PlumaDocument       *doc,
 							   brackets_highlighting);
 	pluma_document_set_enable_search_highlighting (doc, search_highliting);
 
+	pluma_literal_search_free (literal);
+
 	g_free (search_text);
 	if(replace_text != NULL)
 		g_free (replace_text);
@@ -2347,6 +2742,408 @@ pluma_document_replace_all (PlumaDocument       *doc,
 	return cont;
 }
 
+/* Number of characters rewritten at once by the bulk transforms */
+#define TRANSFORM_CHUNK_SIZE (16 * 1024)
+
+static void
+begin_bulk_edit (PlumaDocument *doc)
+{
+	gtk_text_buffer_begin_user_action (GTK_TEXT_BUFFER (doc));
+
+	/* no cursor-moved for each chunk */
+	doc->priv->stop_cursor_moved_emission = TRUE;
+}
+
+static void
+end_bulk_edit (PlumaDocument *doc)
+{
+	gtk_text_buffer_end_user_action (GTK_TEXT_BUFFER (doc));
+
+	doc->priv->stop_cursor_moved_emission = FALSE;
+	emit_cursor_moved (doc);
+}
+
+/* Replaces @old_text, found at @offset, with @new_text, touching only
+ * the part that differs so that marks and tags around stay in place.
+ * Returns how many characters were added (or removed, if negative). */
+static gint
+replace_changed_text (GtkTextBuffer *buffer,
+		      gint           offset,
+		      const gchar   *old_text,
+		      const gchar   *new_text)
+{
+	const gchar *old_start = old_text;
+	const gchar *new_start = new_text;
+	const gchar *old_end;
+	const gchar *new_end;
+	GtkTextIter start;
+	GtkTextIter end;
+	gint old_chars;
+	gint new_chars;
+
+	/* common prefix */
+	while (*old_start != '\0' && *new_start != '\0')
+	{
+		gint len = g_utf8_skip[*(const guchar *)old_start];
+
+		if (g_utf8_skip[*(const guchar *)new_start] != len ||
+		    memcmp (old_start, new_start, len) != 0)
+			break;
+
+		old_start += len;
+		new_start += len;
+		++offset;
+	}
+
+	/* common suffix */
+	old_end = old_start + strlen (old_start);
+	new_end = new_start + strlen (new_start);
+
+	while (old_end > old_start && new_end > new_start)
+	{
+		const gchar *old_prev = g_utf8_prev_char (old_end);
+		const gchar *new_prev = g_utf8_prev_char (new_end);
+
+		if (old_end - old_prev != new_end - new_prev ||
+		    memcmp (old_prev, new_prev, old_end - old_prev) != 0)
+			break;
+
+		old_end = old_prev;
+		new_end = new_prev;
+	}
+
+	if (old_start == old_end && new_start == new_end)
+		return 0;
+
+	old_chars = g_utf8_strlen (old_start, old_end - old_start);
+	new_chars = g_utf8_strlen (new_start, new_end - new_start);
+
+	gtk_text_buffer_get_iter_at_offset (buffer, &start, offset);
+	end = start;
+	gtk_text_iter_forward_chars (&end, old_chars);
+
+	gtk_text_buffer_delete (buffer, &start, &end);
+	gtk_text_buffer_insert (buffer, &start, new_start, new_end - new_start);
+
+	return new_chars - old_chars;
+}
+
+static gchar *
+change_case_text (const gchar             *text,
+		  GtkSourceChangeCaseType  case_type,
+		  gboolean                *in_word)
+{
+	GString *str;
+	const gchar *p;
+
+	switch (case_type)
+	{
+		case GTK_SOURCE_CHANGE_CASE_LOWER:
+			return g_utf8_strdown (text, -1);
+		case GTK_SOURCE_CHANGE_CASE_UPPER:
+			return g_utf8_strup (text, -1);
+		default:
+			break;
+	}
+
+	str = g_string_sized_new (strlen (text));
+
+	for (p = text; *p != '\0'; p = g_utf8_next_char (p))
+	{
+		gunichar c = g_utf8_get_char (p);
+
+		if (case_type == GTK_SOURCE_CHANGE_CASE_TOGGLE)
+		{
+			if (g_unichar_islower (c))
+				c = g_unichar_toupper (c);
+			else if (g_unichar_isupper (c) || g_unichar_istitle (c))
+				c = g_unichar_tolower (c);
+		}
+		else if (g_unichar_isalnum (c) || (c == '\'' && *in_word))
+		{
+			c = *in_word ? g_unichar_tolower (c) : g_unichar_totitle (c);
+			*in_word = TRUE;
+		}
+		else
+		{
+			*in_word = FALSE;
+		}
+
+		g_string_append_unichar (str, c);
+	}
+
+	return g_string_free (str, FALSE);
+}
+
+/**
+ * pluma_document_change_case:
+ * @doc: a #PlumaDocument
+ * @case_type: how to change the case
+ * @start: start of the text
+ * @end: end of the text
+ *
+ * Changes the case of the text between @start and @end. The text is
+ * rewritten a chunk at a time, so that large ranges do not need a copy
+ * of the whole text, and only the characters that actually change are
+ * replaced. The change is a single undo step. @start and @end are
+ * revalidated to point to the transformed text.
+ **/
+void
+pluma_document_change_case (PlumaDocument           *doc,
+			    GtkSourceChangeCaseType  case_type,
+			    GtkTextIter             *start,
+			    GtkTextIter             *end)
+{
+	GtkTextBuffer *buffer;
+	gint offset;
+	gint start_offset;
+	gint end_offset;
+	gboolean in_word = FALSE;
+
+	pluma_debug (DEBUG_DOCUMENT);
+
+	g_return_if_fail (PLUMA_IS_DOCUMENT (doc));
+	g_return_if_fail (start != NULL && end != NULL);
+
+	buffer = GTK_TEXT_BUFFER (doc);
+
+	gtk_text_iter_order (start, end);
+	start_offset = gtk_text_iter_get_offset (start);
+	end_offset = gtk_text_iter_get_offset (end);
+
+	begin_bulk_edit (doc);
+
+	for (offset = start_offset; offset < end_offset; )
+	{
+		GtkTextIter chunk_start;
+		GtkTextIter chunk_end;
+		gint chunk_size;
+		gint delta;
+		gchar *old_text;
+		gchar *new_text;
+
+		chunk_size = MIN (TRANSFORM_CHUNK_SIZE, end_offset - offset);
+
+		gtk_text_buffer_get_iter_at_offset (buffer, &chunk_start, offset);
+		chunk_end = chunk_start;
+		gtk_text_iter_forward_chars (&chunk_end, chunk_size);
+
+		/* some mappings depend on the rest of the word, like the
+		 * final sigma: never cut a word in two */
+		while (chunk_size < end_offset - offset &&
+		       !g_unichar_isspace (gtk_text_iter_get_char (&chunk_end)))
+		{
+			gtk_text_iter_forward_char (&chunk_end);
+			++chunk_size;
+		}
+
+		old_text = gtk_text_buffer_get_slice (buffer, &chunk_start, &chunk_end, TRUE);
+		new_text = change_case_text (old_text, case_type, &in_word);
+
+		/* the case mapping may change the number of characters */
+		delta = replace_changed_text (buffer, offset, old_text, new_text);
+		offset += chunk_size + delta;
+		end_offset += delta;
+
+		g_free (old_text);
+		g_free (new_text);
+	}
+
+	end_bulk_edit (doc);
+
+	gtk_text_buffer_get_iter_at_offset (buffer, start, start_offset);
+	gtk_text_buffer_get_iter_at_offset (buffer, end, end_offset);
+}
+
+/**
+ * pluma_document_delete_lines:
+ * @doc: a #PlumaDocument
+ * @start: a position in the first line
+ * @end: a position in the last line
+ * @default_editable: whether the text is editable by default, as in
+ * gtk_text_buffer_delete_interactive()
+ *
+ * Deletes the lines from the one of @start to the one of @end, in a
+ * single step. If @end is at the start of a line and after @start, that
+ * line is kept. When the last line of @doc goes away, the newline
+ * before it is deleted instead of the one after. Non-editable text is
+ * left in place. @start and @end are revalidated to the place of the
+ * deleted text.
+ *
+ * Returns: whether some text was deleted
+ **/
+gboolean
+pluma_document_delete_lines (PlumaDocument *doc,
+			     GtkTextIter   *start,
+			     GtkTextIter   *end,
+			     gboolean       default_editable)
+{
+	GtkTextBuffer *buffer;
+	gboolean last_line = FALSE;
+	gboolean ret;
+
+	pluma_debug (DEBUG_DOCUMENT);
+
+	g_return_val_if_fail (PLUMA_IS_DOCUMENT (doc), FALSE);
+	g_return_val_if_fail (start != NULL && end != NULL, FALSE);
+
+	buffer = GTK_TEXT_BUFFER (doc);
+
+	gtk_text_iter_order (start, end);
+	gtk_text_iter_set_line_offset (start, 0);
+
+	if (!gtk_text_iter_starts_line (end) || gtk_text_iter_equal (start, end))
+	{
+		/* the end is also at the end of the buffer when the next
+		 * line is the empty last one, which is kept */
+		last_line = gtk_text_iter_get_line (end) ==
+			    gtk_text_buffer_get_line_count (buffer) - 1;
+
+		gtk_text_iter_forward_line (end);
+	}
+
+	if (last_line &&
+	    gtk_text_iter_backward_line (start) &&
+	    !gtk_text_iter_ends_line (start))
+	{
+		gtk_text_iter_forward_to_line_end (start);
+	}
+
+	begin_bulk_edit (doc);
+	ret = gtk_text_buffer_delete_interactive (buffer, start, end, default_editable);
+	end_bulk_edit (doc);
+
+	return ret;
+}
+
+/* Calls @func on the start of each line from @start to @end, from the
+ * last one so that the offsets of the next lines do not move */
+static void
+foreach_line_start (PlumaDocument *doc,
+		    GtkTextIter   *start,
+		    GtkTextIter   *end,
+		    void         (*func) (GtkTextBuffer *buffer,
+					  GtkTextIter   *iter,
+					  const gchar   *indent),
+		    const gchar   *indent)
+{
+	GtkTextBuffer *buffer = GTK_TEXT_BUFFER (doc);
+	gint start_line;
+	gint end_line;
+	gint line;
+
+	gtk_text_iter_order (start, end);
+	start_line = gtk_text_iter_get_line (start);
+	end_line = gtk_text_iter_get_line (end);
+
+	/* a selection of whole lines ends at the start of the next one */
+	if (end_line > start_line && gtk_text_iter_starts_line (end))
+		--end_line;
+
+	begin_bulk_edit (doc);
+
+	for (line = end_line; line >= start_line; --line)
+	{
+		GtkTextIter iter;
+
+		gtk_text_buffer_get_iter_at_line (buffer, &iter, line);
+		func (buffer, &iter, indent);
+	}
+
+	end_bulk_edit (doc);
+
+	gtk_text_buffer_get_iter_at_line (buffer, start, start_line);
+	gtk_text_buffer_get_iter_at_line (buffer, end, end_line);
+
+	if (!gtk_text_iter_ends_line (end))
+		gtk_text_iter_forward_to_line_end (end);
+}
+
+static void
+indent_line (GtkTextBuffer *buffer,
+	     GtkTextIter   *iter,
+	     const gchar   *indent)
+{
+	/* do not leave trailing spaces on empty lines */
+	if (!gtk_text_iter_ends_line (iter))
+		gtk_text_buffer_insert (buffer, iter, indent, -1);
+}
+
+static void
+unindent_line (GtkTextBuffer *buffer,
+	       GtkTextIter   *iter,
+	       const gchar   *indent)
+{
+	GtkTextIter end = *iter;
+	gint spaces = strlen (indent);
+
+	if (gtk_text_iter_get_char (&end) == '\t')
+	{
+		gtk_text_iter_forward_char (&end);
+	}
+	else
+	{
+		while (spaces-- > 0 && gtk_text_iter_get_char (&end) == ' ')
+			gtk_text_iter_forward_char (&end);
+	}
+
+	if (!gtk_text_iter_equal (iter, &end))
+		gtk_text_buffer_delete (buffer, iter, &end);
+}
+
+/**
+ * pluma_document_indent_lines:
+ * @doc: a #PlumaDocument
+ * @start: a position in the first line
+ * @end: a position in the last line
+ * @indent: the text to add, e.g. a tab
+ *
+ * Adds @indent at the start of the lines from the one of @start to the
+ * one of @end, in a single undo step. @start and @end are revalidated
+ * to the start of the first line and the end of the last one.
+ **/
+void
+pluma_document_indent_lines (PlumaDocument *doc,
+			     GtkTextIter   *start,
+			     GtkTextIter   *end,
+			     const gchar   *indent)
+{
+	pluma_debug (DEBUG_DOCUMENT);
+
+	g_return_if_fail (PLUMA_IS_DOCUMENT (doc));
+	g_return_if_fail (start != NULL && end != NULL);
+	g_return_if_fail (indent != NULL);
+
+	foreach_line_start (doc, start, end, indent_line, indent);
+}
+
+/**
+ * pluma_document_unindent_lines:
+ * @doc: a #PlumaDocument
+ * @start: a position in the first line
+ * @end: a position in the last line
+ * @indent: the indentation unit, e.g. a tab
+ *
+ * Removes one level of indentation from the lines from the one of
+ * @start to the one of @end, in a single undo step: a leading tab, or
+ * else as many leading spaces as there are bytes in @indent. @start and
+ * @end are revalidated as in pluma_document_indent_lines().
+ **/
+void
+pluma_document_unindent_lines (PlumaDocument *doc,
+			       GtkTextIter   *start,
+			       GtkTextIter   *end,
+			       const gchar   *indent)
+{
+	pluma_debug (DEBUG_DOCUMENT);
+
+	g_return_if_fail (PLUMA_IS_DOCUMENT (doc));
+	g_return_if_fail (start != NULL && end != NULL);
+	g_return_if_fail (indent != NULL);
+
+	foreach_line_start (doc, start, end, unindent_line, indent);
+}
+
 /**
  * pluma_document_set_language:
  * @doc:
@@ -2504,6 +3301,11 @@ search_region (PlumaDocument *doc,
 	GtkTextIter m_end;
 	GtkTextSearchFlags search_flags = 0;
 	gboolean found = TRUE;
+	gboolean tagged = FALSE;
+	gint64 trace;
+	PlumaLiteralSearch *literal;
+	GtkTextIter window_start;
+	GtkTextIter window_end;
 
 	GtkTextBuffer *buffer;
 
@@ -2536,8 +3338,28 @@ search_region (PlumaDocument *doc,
 
 	g_return_if_fail (doc->priv->num_of_lines_search_text > 0);
 
-	gtk_text_iter_backward_lines (start, doc->priv->num_of_lines_search_text);
-	gtk_text_iter_forward_lines (end, doc->priv->num_of_lines_search_text);
+	/* the views ask for [line start, next line start) */
+	if (gtk_text_iter_starts_line (start) &&
+	    (gtk_text_iter_starts_line (end) || gtk_text_iter_ends_line (end)))
+	{
+		gtk_text_iter_backward_lines (start, doc->priv->num_of_lines_search_text);
+		gtk_text_iter_forward_lines (end, doc->priv->num_of_lines_search_text);
+	}
+	else
+	{
+		gint margin;
+
+		/* the view only asked for the text on screen of a long
+		 * line: growing the window to whole lines would search all
+		 * of it, the length of a match is enough (twice that when
+		 * ignoring the case, folding can change it) */
+		margin = g_utf8_strlen (doc->priv->search_text, -1);
+		if (!PLUMA_SEARCH_IS_CASE_SENSITIVE (doc->priv->search_flags))
+			margin *= 2;
+
+		gtk_text_iter_backward_chars (start, margin);
+		gtk_text_iter_forward_chars (end, margin);
+	}
 
 	if (gtk_text_iter_has_tag (start, doc->priv->found_tag) &&
 	    !gtk_text_iter_starts_tag (start, doc->priv->found_tag))
@@ -2560,7 +3382,13 @@ search_region (PlumaDocument *doc,
 	if (*doc->priv->search_text == '\0')
 		return;
 
+	trace = pluma_trace_begin ();
+
+	literal = get_literal_search (doc);
+
 	iter = *start;
+	window_start = *start;
+	window_end = *end;
 
 	search_flags = GTK_TEXT_SEARCH_VISIBLE_ONLY | GTK_TEXT_SEARCH_TEXT_ONLY;
 
@@ -2574,12 +3402,19 @@ search_region (PlumaDocument *doc,
 		if ((end != NULL) && gtk_text_iter_is_end (end))
 			end = NULL;
 
-		found = gtk_text_iter_forward_search (&iter,
-							doc->priv->search_text,
-							search_flags,
-                        	                	&m_start,
-                        	                	&m_end,
-                                	               	end);
+		if (literal != NULL)
+			found = pluma_literal_search_forward (literal,
+							      &iter,
+							      end,
+							      &m_start,
+							      &m_end);
+		else
+			found = gtk_text_iter_forward_search (&iter,
+								doc->priv->search_text,
+								search_flags,
+								&m_start,
+								&m_end,
+								end);
 
 		iter = m_end;
 
@@ -2600,9 +3435,19 @@ search_region (PlumaDocument *doc,
 						   doc->priv->found_tag,
 						   &m_start,
 						   &m_end);
+			tagged = TRUE;
 		}
 
 	} while (found);
+
+	/* remember where the tag lives, so that it can be removed without
+	 * walking the whole buffer when the search changes */
+	if (tagged)
+		pluma_text_region_add (doc->priv->highlighted_region,
+				       &window_start,
+				       &window_end);
+
+	pluma_trace_end (PLUMA_DEBUG_SEARCH, "search-highlight", trace);
 }
 
 static void
@@ -2625,6 +3470,7 @@ to_search_region_range (PlumaDocument *doc,
 
 	/* Add the region to the refresh region */
 	pluma_text_region_add (doc->priv->to_search_region, start, end);
+	doc->priv->highlight_generation++;
 
 	/* Notify views of the updated highlight region */
 	gtk_text_iter_backward_lines (start, doc->priv->num_of_lines_search_text);
@@ -2633,6 +3479,60 @@ to_search_region_range (PlumaDocument *doc,
 	g_signal_emit (doc, document_signals [SEARCH_HIGHLIGHT_UPDATED], 0, start, end);
 }
 
+/* Removes the found_tag from the ranges where it has been applied; only
+ * the parts of the document that have been shown are ever tagged, so
+ * this does not need to walk the whole buffer */
+static void
+remove_found_tag (PlumaDocument *doc)
+{
+	PlumaTextRegion *region;
+	gint n, i;
+
+	if (doc->priv->highlighted_region == NULL)
+		return;
+
+	region = doc->priv->highlighted_region;
+	n = pluma_text_region_subregions (region);
+
+	for (i = 0; i < n; i++)
+	{
+		GtkTextIter start;
+		GtkTextIter end;
+
+		pluma_text_region_nth_subregion (region, i, &start, &end);
+
+		gtk_text_buffer_remove_tag (GTK_TEXT_BUFFER (doc),
+					    doc->priv->found_tag,
+					    &start,
+					    &end);
+	}
+
+	pluma_text_region_destroy (region, TRUE);
+	doc->priv->highlighted_region = pluma_text_region_new (GTK_TEXT_BUFFER (doc));
+}
+
+/* The search text or flags changed: drop the highlights of the previous
+ * search and let the views search again what they show */
+static void
+invalidate_search_highlight (PlumaDocument *doc)
+{
+	GtkTextIter begin;
+	GtkTextIter end;
+
+	if (doc->priv->to_search_region == NULL)
+		return;
+
+	remove_found_tag (doc);
+
+	gtk_text_buffer_get_bounds (GTK_TEXT_BUFFER (doc),
+				    &begin,
+				    &end);
+
+	to_search_region_range (doc,
+				&begin,
+				&end);
+}
+
 void
 _pluma_document_search_region (PlumaDocument     *doc,
 			       const GtkTextIter *start,
@@ -2743,44 +3643,32 @@ pluma_document_set_enable_search_highlighting (PlumaDocument *doc,
 	if (doc->priv->to_search_region != NULL)
 	{
 		/* Disable search highlighting */
-		if (doc->priv->found_tag != NULL)
-		{
-			/* If needed remove the found_tag */
-			GtkTextIter begin;
-			GtkTextIter end;
-
-			gtk_text_buffer_get_bounds (GTK_TEXT_BUFFER (doc),
-						    &begin,
-						    &end);
-
-			gtk_text_buffer_remove_tag (GTK_TEXT_BUFFER (doc),
-				    		    doc->priv->found_tag,
-				    		    &begin,
-				    		    &end);
-		}
+		remove_found_tag (doc);
 
 		pluma_text_region_destroy (doc->priv->to_search_region,
 					   TRUE);
+		pluma_text_region_destroy (doc->priv->highlighted_region,
+					   TRUE);
 		doc->priv->to_search_region = NULL;
+		doc->priv->highlighted_region = NULL;
 	}
 	else
 	{
 		doc->priv->to_search_region = pluma_text_region_new (GTK_TEXT_BUFFER (doc));
+		doc->priv->highlighted_region = pluma_text_region_new (GTK_TEXT_BUFFER (doc));
+
+		/* If search_text is not empty, highligth all its occurrences */
 		if (pluma_document_get_can_search_again (doc))
-		{
-			/* If search_text is not empty, highligth all its occurrences */
-			GtkTextIter begin;
-			GtkTextIter end;
+			invalidate_search_highlight (doc);
+	}
+}
 
-			gtk_text_buffer_get_bounds (GTK_TEXT_BUFFER (doc),
-						    &begin,
-						    &end);
+guint
+_pluma_document_get_highlight_generation (PlumaDocument *doc)
+{
+	g_return_val_if_fail (PLUMA_IS_DOCUMENT (doc), 0);
 
-			to_search_region_range (doc,
-						&begin,
-						&end);
-		}
-	}
+	return doc->priv->highlight_generation;
 }
 
 gboolean
@@ -2791,6 +3679,75 @@ pluma_document_get_enable_search_highlighting (PlumaDocument *doc)
 	return (doc->priv->to_search_region != NULL);
 }
 
+/**
+ * pluma_document_get_large_file_mode:
+ * @doc: a #PlumaDocument
+ *
+ * Returns whether @doc is in large file mode, see
+ * #PlumaDocument:large-file-mode.
+ *
+ * Returns: %TRUE if the costly features are disabled for @doc
+ */
+gboolean
+pluma_document_get_large_file_mode (PlumaDocument *doc)
+{
+	g_return_val_if_fail (PLUMA_IS_DOCUMENT (doc), FALSE);
+
+	return doc->priv->large_file_mode;
+}
+
+gboolean
+_pluma_document_has_long_lines (PlumaDocument *doc)
+{
+	g_return_val_if_fail (PLUMA_IS_DOCUMENT (doc), FALSE);
+
+	return doc->priv->longest_line >= LONG_LINE_LENGTH;
+}
+
+void
+_pluma_document_set_large_file_mode (PlumaDocument *doc,
+				     gboolean       large_file_mode)
+{
+	GtkSourceBuffer *buffer;
+
+	g_return_if_fail (PLUMA_IS_DOCUMENT (doc));
+
+	large_file_mode = (large_file_mode != FALSE);
+
+	if (doc->priv->large_file_mode == large_file_mode)
+		return;
+
+	pluma_debug_message (DEBUG_DOCUMENT, "large file mode: %d", large_file_mode);
+
+	doc->priv->large_file_mode = large_file_mode;
+
+	buffer = GTK_SOURCE_BUFFER (doc);
+
+	if (large_file_mode)
+	{
+		gtk_source_buffer_set_highlight_syntax (buffer, FALSE);
+		gtk_source_buffer_set_highlight_matching_brackets (buffer, FALSE);
+		pluma_document_set_enable_search_highlighting (doc, FALSE);
+	}
+	else
+	{
+		GSettings *settings = doc->priv->editor_settings;
+
+		gtk_source_buffer_set_highlight_syntax (buffer,
+							gtk_source_buffer_get_language (buffer) != NULL &&
+							g_settings_get_boolean (settings,
+										PLUMA_SETTINGS_SYNTAX_HIGHLIGHTING));
+		gtk_source_buffer_set_highlight_matching_brackets (buffer,
+								   g_settings_get_boolean (settings,
+											   PLUMA_SETTINGS_BRACKET_MATCHING));
+		pluma_document_set_enable_search_highlighting (doc,
+							       g_settings_get_boolean (settings,
+										       PLUMA_SETTINGS_SEARCH_HIGHLIGHTING));
+	}
+
+	g_object_notify (G_OBJECT (doc), "large-file-mode");
+}
+
 void
 pluma_document_set_newline_type (PlumaDocument           *doc,
 				 PlumaDocumentNewlineType newline_type)
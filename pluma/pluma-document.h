@@ -264,6 +264,26 @@ gint		 pluma_document_replace_all 	(PlumaDocument       *doc,
 						 const gchar         *replace,
 					    	 guint                flags);
 
+void		 pluma_document_change_case	(PlumaDocument           *doc,
+						 GtkSourceChangeCaseType  case_type,
+						 GtkTextIter             *start,
+						 GtkTextIter             *end);
+
+gboolean	 pluma_document_delete_lines	(PlumaDocument       *doc,
+						 GtkTextIter         *start,
+						 GtkTextIter         *end,
+						 gboolean             default_editable);
+
+void		 pluma_document_indent_lines	(PlumaDocument       *doc,
+						 GtkTextIter         *start,
+						 GtkTextIter         *end,
+						 const gchar         *indent);
+
+void		 pluma_document_unindent_lines	(PlumaDocument       *doc,
+						 GtkTextIter         *start,
+						 GtkTextIter         *end,
+						 const gchar         *indent);
+
 void 		 pluma_document_set_language 	(PlumaDocument       *doc,
 						 GtkSourceLanguage   *lang);
 GtkSourceLanguage
@@ -285,6 +305,9 @@ void		 pluma_document_set_newline_type (PlumaDocument           *doc,
 PlumaDocumentNewlineType
 		 pluma_document_get_newline_type (PlumaDocument *doc);
 
+gboolean	 pluma_document_get_large_file_mode
+						(PlumaDocument       *doc);
+
 gchar		*pluma_document_get_metadata	(PlumaDocument *doc,
 						 const gchar   *key);
 
@@ -298,6 +321,15 @@ void		 pluma_document_set_metadata	(PlumaDocument *doc,
 void		 _pluma_document_set_readonly 	(PlumaDocument       *doc,
 						 gboolean             readonly);
 
+void		 _pluma_document_set_large_file_mode
+						(PlumaDocument       *doc,
+						 gboolean             large_file_mode);
+
+/* Whether the document had a line long enough for long line mode when
+ * it was loaded */
+gboolean	 _pluma_document_has_long_lines
+						(PlumaDocument       *doc);
+
 glong		 _pluma_document_get_seconds_since_last_save_or_load
 						(PlumaDocument       *doc);
 
@@ -309,6 +341,10 @@ void		_pluma_document_search_region   (PlumaDocument       *doc,
 						 const GtkTextIter   *start,
 						 const GtkTextIter   *end);
 
+/* Changes whenever new text has to be searched for highlighting */
+guint		_pluma_document_get_highlight_generation
+						(PlumaDocument       *doc);
+
 /* Search macros */
 #define PLUMA_SEARCH_IS_DONT_SET_FLAGS(sflags) ((sflags & PLUMA_SEARCH_DONT_SET_FLAGS) != 0)
 #define PLUMA_SEARCH_SET_DONT_SET_FLAGS(sflags,state) ((state == TRUE) ? \
@@ -46,6 +46,9 @@ struct _PlumaDocumentsPanelPrivate
 	GtkWidget    *treeview;
 	GtkTreeModel *model;
 
+	/* PlumaTab -> TabRow */
+	GHashTable   *rows;
+
 	guint         adding_tab : 1;
 	guint         is_reodering : 1;
 };
@@ -119,22 +122,21 @@ tab_get_name (PlumaTab *tab)
 	return tab_name;
 }
 
-static void
-get_iter_from_tab (PlumaDocumentsPanel *panel, PlumaTab *tab, GtkTreeIter *iter)
+/* The row of each tab, so that updates do not have to look for it.
+ * GtkListStore iters stay valid until their row is removed. */
+typedef struct
 {
-	gint num;
-	GtkWidget *nb;
-	GtkTreePath *path;
+	GtkTreeIter iter;
 
-	nb = _pluma_window_get_notebook (panel->priv->window);
-	num = gtk_notebook_page_num (GTK_NOTEBOOK (nb),
-				     GTK_WIDGET (tab));
+	/* name and icon changed while the panel was not shown */
+	gboolean    dirty;
+} TabRow;
 
-	path = gtk_tree_path_new_from_indices (num, -1);
-	gtk_tree_model_get_iter (panel->priv->model,
-		                 iter,
-		                 path);
-	gtk_tree_path_free (path);
+static TabRow *
+get_row_from_tab (PlumaDocumentsPanel *panel,
+		  PlumaTab            *tab)
+{
+	return g_hash_table_lookup (panel->priv->rows, tab);
 }
 
 static void
@@ -146,69 +148,120 @@ window_active_tab_changed (PlumaWindow         *window,
 
 	if (!_pluma_window_is_removing_tabs (window))
 	{
-		GtkTreeIter iter;
+		TabRow *row;
 		GtkTreeSelection *selection;
 
-		get_iter_from_tab (panel, tab, &iter);
+		row = get_row_from_tab (panel, tab);
 
-		if (gtk_list_store_iter_is_valid (GTK_LIST_STORE (panel->priv->model),
-						  &iter))
+		if (row != NULL)
 		{
 			selection = gtk_tree_view_get_selection (
 					GTK_TREE_VIEW (panel->priv->treeview));
 
-			gtk_tree_selection_select_iter (selection, &iter);
+			gtk_tree_selection_select_iter (selection, &row->iter);
 		}
 	}
 }
 
 static void
-refresh_list (PlumaDocumentsPanel *panel)
+update_row (PlumaDocumentsPanel *panel,
+	    PlumaTab            *tab,
+	    TabRow              *row)
 {
-	/* TODO: refresh the list only if the panel is visible */
+	GdkPixbuf *pixbuf;
+	gchar *name;
+
+	/* nobody sees the row, do it when the panel is shown */
+	if (!gtk_widget_get_mapped (GTK_WIDGET (panel)))
+	{
+		row->dirty = TRUE;
+		return;
+	}
+
+	name = tab_get_name (tab);
+	pixbuf = _pluma_tab_get_icon (tab);
+
+	gtk_list_store_set (GTK_LIST_STORE (panel->priv->model),
+			    &row->iter,
+			    PIXBUF_COLUMN, pixbuf,
+			    NAME_COLUMN, name,
+			    -1);
+
+	g_free (name);
+	if (pixbuf != NULL)
+		g_object_unref (pixbuf);
+
+	row->dirty = FALSE;
+}
+
+static void
+panel_map (GtkWidget           *widget,
+	   PlumaDocumentsPanel *panel)
+{
+	GHashTableIter iter;
+	gpointer tab;
+	gpointer row;
+
+	g_hash_table_iter_init (&iter, panel->priv->rows);
+
+	while (g_hash_table_iter_next (&iter, &tab, &row))
+	{
+		if (((TabRow *) row)->dirty)
+			update_row (panel, PLUMA_TAB (tab), row);
+	}
+}
+
+static void
+add_row (PlumaDocumentsPanel *panel,
+	 PlumaTab            *tab,
+	 gint                 position)
+{
+	TabRow *row;
+
+	row = g_slice_new (TabRow);
+	row->dirty = FALSE;
 
+	panel->priv->adding_tab = TRUE;
+
+	gtk_list_store_insert_with_values (GTK_LIST_STORE (panel->priv->model),
+					   &row->iter,
+					   position,
+					   TAB_COLUMN, tab,
+					   -1);
+
+	panel->priv->adding_tab = FALSE;
+
+	g_hash_table_insert (panel->priv->rows, tab, row);
+
+	update_row (panel, tab, row);
+}
+
+static void
+tab_row_free (TabRow *row)
+{
+	g_slice_free (TabRow, row);
+}
+
+static void
+refresh_list (PlumaDocumentsPanel *panel)
+{
 	GList *tabs;
 	GList *l;
 	GtkWidget *nb;
-	GtkListStore *list_store;
 	PlumaTab *active_tab;
 
-	/* g_debug ("refresh_list"); */
-
-	list_store = GTK_LIST_STORE (panel->priv->model);
-
-	gtk_list_store_clear (list_store);
+	g_hash_table_remove_all (panel->priv->rows);
+	gtk_list_store_clear (GTK_LIST_STORE (panel->priv->model));
 
 	active_tab = pluma_window_get_active_tab (panel->priv->window);
 
 	nb = _pluma_window_get_notebook (panel->priv->window);
 
 	tabs = gtk_container_get_children (GTK_CONTAINER (nb));
-	l = tabs;
 
-	panel->priv->adding_tab = TRUE;
-
-	while (l != NULL)
+	for (l = tabs; l != NULL; l = g_list_next (l))
 	{
-		GdkPixbuf *pixbuf;
-		gchar *name;
-		GtkTreeIter iter;
-
-		name = tab_get_name (PLUMA_TAB (l->data));
-		pixbuf = _pluma_tab_get_icon (PLUMA_TAB (l->data));
-
-		/* Add a new row to the model */
-		gtk_list_store_append (list_store, &iter);
-		gtk_list_store_set (list_store,
-				    &iter,
-				    PIXBUF_COLUMN, pixbuf,
-				    NAME_COLUMN, name,
-				    TAB_COLUMN, l->data,
-				    -1);
-
-		g_free (name);
-		if (pixbuf != NULL)
-			g_object_unref (pixbuf);
+		add_row (panel, PLUMA_TAB (l->data), -1);
 
 		if (l->data == active_tab)
 		{
@@ -217,14 +270,11 @@ refresh_list (PlumaDocumentsPanel *panel)
 			selection = gtk_tree_view_get_selection (
 					GTK_TREE_VIEW (panel->priv->treeview));
 
-			gtk_tree_selection_select_iter (selection, &iter);
+			gtk_tree_selection_select_iter (selection,
+							&get_row_from_tab (panel, active_tab)->iter);
 		}
-
-		l = g_list_next (l);
 	}
 
-	panel->priv->adding_tab = FALSE;
-
 	g_list_free (tabs);
 }
 
@@ -233,25 +283,12 @@ sync_name_and_icon (PlumaTab            *tab,
 		    GParamSpec          *pspec,
 		    PlumaDocumentsPanel *panel)
 {
-	GdkPixbuf *pixbuf;
-	gchar *name;
-	GtkTreeIter iter;
+	TabRow *row;
 
-	get_iter_from_tab (panel, tab, &iter);
+	row = get_row_from_tab (panel, tab);
+	g_return_if_fail (row != NULL);
 
-	name = tab_get_name (tab);
-	pixbuf = _pluma_tab_get_icon (tab);
-
-	gtk_list_store_set (GTK_LIST_STORE (panel->priv->model),
-			    &iter,
-			    PIXBUF_COLUMN, pixbuf,
-			    NAME_COLUMN, name,
-			    TAB_COLUMN, tab,
-			    -1);
-
-	g_free (name);
-	if (pixbuf != NULL)
-		g_object_unref (pixbuf);
+	update_row (panel, tab, row);
 }
 
 static void
@@ -259,14 +296,27 @@ window_tab_removed (PlumaWindow         *window,
 		    PlumaTab            *tab,
 		    PlumaDocumentsPanel *panel)
 {
+	TabRow *row;
+
 	g_signal_handlers_disconnect_by_func (tab,
 					      G_CALLBACK (sync_name_and_icon),
 					      panel);
 
 	if (_pluma_window_is_removing_tabs (window))
+	{
+		g_hash_table_remove_all (panel->priv->rows);
 		gtk_list_store_clear (GTK_LIST_STORE (panel->priv->model));
-	else
-		refresh_list (panel);
+		return;
+	}
+
+	row = get_row_from_tab (panel, tab);
+
+	if (row != NULL)
+	{
+		gtk_list_store_remove (GTK_LIST_STORE (panel->priv->model),
+				       &row->iter);
+		g_hash_table_remove (panel->priv->rows, tab);
+	}
 }
 
 static void
@@ -274,10 +324,8 @@ window_tab_added (PlumaWindow         *window,
 		  PlumaTab            *tab,
 		  PlumaDocumentsPanel *panel)
 {
-	GtkTreeIter iter;
-	GtkTreeIter sibling;
-	GdkPixbuf *pixbuf;
-	gchar *name;
+	GtkWidget *nb;
+	PlumaTab *active_tab;
 
 	g_signal_connect (tab,
 			 "notify::name",
@@ -289,62 +337,74 @@ window_tab_added (PlumaWindow         *window,
 			  G_CALLBACK (sync_name_and_icon),
 			  panel);
 
-	get_iter_from_tab (panel, tab, &sibling);
-
-	panel->priv->adding_tab = TRUE;
-
-	if (gtk_list_store_iter_is_valid (GTK_LIST_STORE (panel->priv->model),
-					  &sibling))
-	{
-		gtk_list_store_insert_after (GTK_LIST_STORE (panel->priv->model),
-					     &iter,
-					     &sibling);
-	}
-	else
-	{
-		PlumaTab *active_tab;
+	nb = _pluma_window_get_notebook (window);
 
-		gtk_list_store_append (GTK_LIST_STORE (panel->priv->model),
-				       &iter);
+	add_row (panel,
+		 tab,
+		 gtk_notebook_page_num (GTK_NOTEBOOK (nb), GTK_WIDGET (tab)));
 
-		active_tab = pluma_window_get_active_tab (panel->priv->window);
+	active_tab = pluma_window_get_active_tab (panel->priv->window);
 
-		if (tab == active_tab)
-		{
-			GtkTreeSelection *selection;
+	if (tab == active_tab)
+	{
+		GtkTreeSelection *selection;
 
-			selection = gtk_tree_view_get_selection (
-						GTK_TREE_VIEW (panel->priv->treeview));
+		selection = gtk_tree_view_get_selection (
+					GTK_TREE_VIEW (panel->priv->treeview));
 
-			gtk_tree_selection_select_iter (selection, &iter);
-		}
+		gtk_tree_selection_select_iter (selection,
+						&get_row_from_tab (panel, tab)->iter);
 	}
-
-	name = tab_get_name (tab);
-	pixbuf = _pluma_tab_get_icon (tab);
-
-	gtk_list_store_set (GTK_LIST_STORE (panel->priv->model),
-			    &iter,
-		            PIXBUF_COLUMN, pixbuf,
-		            NAME_COLUMN, name,
-		            TAB_COLUMN, tab,
-		            -1);
-
-	g_free (name);
-	if (pixbuf != NULL)
-		g_object_unref (pixbuf);
-
-	panel->priv->adding_tab = FALSE;
 }
 
 static void
 window_tabs_reordered (PlumaWindow         *window,
 		       PlumaDocumentsPanel *panel)
 {
+	GtkWidget *nb;
+	gint *new_order;
+	gint n_pages;
+	gint i;
+
 	if (panel->priv->is_reodering)
 		return;
 
-	refresh_list (panel);
+	nb = _pluma_window_get_notebook (panel->priv->window);
+	n_pages = gtk_notebook_get_n_pages (GTK_NOTEBOOK (nb));
+
+	if (n_pages != gtk_tree_model_iter_n_children (panel->priv->model, NULL))
+	{
+		refresh_list (panel);
+		return;
+	}
+
+	/* move the rows, keeping their content */
+	new_order = g_new (gint, n_pages);
+
+	for (i = 0; i < n_pages; i++)
+	{
+		GtkWidget *tab;
+		TabRow *row;
+		GtkTreePath *path;
+
+		tab = gtk_notebook_get_nth_page (GTK_NOTEBOOK (nb), i);
+		row = get_row_from_tab (panel, PLUMA_TAB (tab));
+
+		if (row == NULL)
+		{
+			g_free (new_order);
+			refresh_list (panel);
+			return;
+		}
+
+		path = gtk_tree_model_get_path (panel->priv->model, &row->iter);
+		new_order[i] = gtk_tree_path_get_indices (path)[0];
+		gtk_tree_path_free (path);
+	}
+
+	gtk_list_store_reorder (GTK_LIST_STORE (panel->priv->model), new_order);
+
+	g_free (new_order);
 }
 
 static void
@@ -444,10 +504,12 @@ pluma_documents_panel_get_property (GObject    *object,
 static void
 pluma_documents_panel_finalize (GObject *object)
 {
-	/* PlumaDocumentsPanel *tab = PLUMA_DOCUMENTS_PANEL (object); */
+	PlumaDocumentsPanel *panel = PLUMA_DOCUMENTS_PANEL (object);
 
 	/* TODO: disconnect signal with window */
 
+	g_hash_table_destroy (panel->priv->rows);
+
 	G_OBJECT_CLASS (pluma_documents_panel_parent_class)->finalize (object);
 }
 
@@ -655,6 +717,28 @@ treeview_row_inserted (GtkTreeModel        *tree_model,
 	panel->priv->is_reodering = FALSE;
 }
 
+/* Dragging a row inserts a copy of it before removing the original:
+ * follow the tab to its new row */
+static void
+treeview_row_changed (GtkTreeModel        *tree_model,
+		      GtkTreePath         *path,
+		      GtkTreeIter         *iter,
+		      PlumaDocumentsPanel *panel)
+{
+	gpointer tab;
+	TabRow *row;
+
+	gtk_tree_model_get (tree_model, iter, TAB_COLUMN, &tab, -1);
+
+	if (tab == NULL)
+		return;
+
+	row = get_row_from_tab (panel, PLUMA_TAB (tab));
+
+	if (row != NULL && row->iter.user_data != iter->user_data)
+		row->iter = *iter;
+}
+
 static void
 pluma_documents_panel_init (PlumaDocumentsPanel *panel)
 {
@@ -668,6 +752,11 @@ pluma_documents_panel_init (PlumaDocumentsPanel *panel)
 	panel->priv->adding_tab = FALSE;
 	panel->priv->is_reodering = FALSE;
 
+	panel->priv->rows = g_hash_table_new_full (g_direct_hash,
+						   g_direct_equal,
+						   NULL,
+						   (GDestroyNotify) tab_row_free);
+
 	gtk_orientable_set_orientation (GTK_ORIENTABLE (panel),
 	                                GTK_ORIENTATION_VERTICAL);
 
@@ -739,6 +828,15 @@ pluma_documents_panel_init (PlumaDocumentsPanel *panel)
 			  "row-inserted",
 			  G_CALLBACK (treeview_row_inserted),
 			  panel);
+	g_signal_connect (panel->priv->model,
+			  "row-changed",
+			  G_CALLBACK (treeview_row_changed),
+			  panel);
+
+	g_signal_connect (panel,
+			  "map",
+			  G_CALLBACK (panel_map),
+			  panel);
 }
 
 GtkWidget *
@@ -1210,3 +1210,34 @@ pluma_externally_modified_message_area_new (const gchar *uri,
 	return message_area;
 }
 
+
+GtkWidget *
+pluma_large_file_message_area_new (void)
+{
+	GtkWidget *message_area;
+
+	message_area = gtk_info_bar_new ();
+
+	gtk_info_bar_add_button (GTK_INFO_BAR (message_area),
+				 _("Enable _Highlighting"),
+				 PLUMA_LARGE_FILE_RESPONSE_HIGHLIGHTING);
+	gtk_info_bar_add_button (GTK_INFO_BAR (message_area),
+				 _("Enable _Wrapping"),
+				 PLUMA_LARGE_FILE_RESPONSE_WRAPPING);
+	gtk_info_bar_add_button (GTK_INFO_BAR (message_area),
+				 _("Enable _All"),
+				 GTK_RESPONSE_YES);
+	gtk_info_bar_set_show_close_button (GTK_INFO_BAR (message_area), TRUE);
+
+	gtk_info_bar_set_message_type (GTK_INFO_BAR (message_area),
+				       GTK_MESSAGE_INFO);
+
+	set_message_area_text_and_icon (message_area,
+					"dialog-information",
+					_("This file is very large or has very long lines."),
+					_("Syntax highlighting, line wrapping, spell checking and "
+					  "other costly features have been disabled to keep pluma "
+					  "responsive."));
+
+	return message_area;
+}
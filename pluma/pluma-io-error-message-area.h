@@ -36,6 +36,14 @@
 
 G_BEGIN_DECLS
 
+/* Responses of the large file message area, besides GTK_RESPONSE_YES
+ * (enable everything) and GTK_RESPONSE_CLOSE */
+typedef enum
+{
+	PLUMA_LARGE_FILE_RESPONSE_HIGHLIGHTING = 1,
+	PLUMA_LARGE_FILE_RESPONSE_WRAPPING
+} PlumaLargeFileResponse;
+
 GtkWidget	*pluma_io_loading_error_message_area_new		 (const gchar         *uri,
 									  const PlumaEncoding *encoding,
 									  const GError        *error);
@@ -64,6 +72,8 @@ GtkWidget	*pluma_unrecoverable_saving_error_message_area_new	 (const gchar
 GtkWidget	*pluma_externally_modified_message_area_new		 (const gchar         *uri,
 									  gboolean             document_modified);
 
+GtkWidget	*pluma_large_file_message_area_new			 (void);
+
 G_END_DECLS
 
 #endif  /* __PLUMA_IO_ERROR_MESSAGE_AREA_H__  */
@@ -0,0 +1,504 @@
+/*
+ * pluma-literal-search.c
+ * This file is part of pluma
+ *
+ * Copyright (C) 2012-2021 MATE Developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Literal (non regex) search on a GtkTextBuffer.
+ *
+ * gtk_text_iter_forward_search () compares the buffer character by
+ * character and, when ignoring case, casefolds and normalizes every line
+ * it looks at. Here the buffer is copied in large chunks and scanned as
+ * plain UTF-8: candidates are found on the first byte of the needle with
+ * memchr () (or a lead byte table when ignoring case), and only the
+ * candidates are compared, converted to iters and checked for word
+ * boundaries.
+ *
+ * Unlike the GTK search, text is not normalized, so canonically
+ * equivalent but differently encoded strings do not match.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include "pluma-literal-search.h"
+#include "pluma-document.h"
+
+/* characters copied out of the buffer at a time, the chunks grow from
+ * the min to the max size so that close matches (e.g. when replacing
+ * all) do not copy much more text than needed */
+#define MIN_CHUNK_CHARS 4096
+#define MAX_CHUNK_CHARS 65536
+
+struct _PlumaLiteralSearch
+{
+	gchar    *text;		/* as given, to check if we can be reused */
+	guint     flags;
+
+	gchar    *needle;	/* casefolded when ignoring case */
+	gsize     needle_len;
+	gint      needle_chars;
+
+	gboolean  case_sensitive;
+	gboolean  entire_word;
+
+	/* lead bytes that may start a match when ignoring case */
+	guint8    lead_bytes[32];
+};
+
+#define LEAD_BYTE_SET(bits,b)	((bits)[(guchar) (b) >> 3] |= 1 << ((guchar) (b) & 7))
+#define LEAD_BYTE_IS_SET(bits,b) (((bits)[(guchar) (b) >> 3] & (1 << ((guchar) (b) & 7))) != 0)
+
+/* Maps a character to the lead bytes of the non ASCII characters whose
+ * casefolding starts with it, e.g. 'k' to the one of KELVIN SIGN and 's'
+ * to the ones of LATIN SMALL LETTER LONG S and SHARP S. */
+static gpointer
+build_fold_lead_bytes (gpointer data)
+{
+	GHashTable *table;
+	gunichar c;
+
+	table = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+
+	for (c = 0x80; c < 0x20000; c++)
+	{
+		gchar buf[6];
+		gint len;
+		gchar *folded;
+		gunichar f;
+
+		if (!g_unichar_validate (c))
+			continue;
+
+		len = g_unichar_to_utf8 (c, buf);
+		folded = g_utf8_casefold (buf, len);
+		f = g_utf8_get_char (folded);
+
+		if (f != c)
+		{
+			guint8 *bits;
+
+			bits = g_hash_table_lookup (table, GUINT_TO_POINTER (f));
+
+			if (bits == NULL)
+			{
+				bits = g_new0 (guint8, 32);
+				g_hash_table_insert (table, GUINT_TO_POINTER (f), bits);
+			}
+
+			LEAD_BYTE_SET (bits, buf[0]);
+		}
+
+		g_free (folded);
+	}
+
+	return table;
+}
+
+static void
+add_lead_byte (guint8   *bits,
+	       gunichar  c)
+{
+	gchar buf[6];
+
+	g_unichar_to_utf8 (c, buf);
+	LEAD_BYTE_SET (bits, buf[0]);
+}
+
+PlumaLiteralSearch *
+pluma_literal_search_new (const gchar *needle,
+			  guint        search_flags)
+{
+	PlumaLiteralSearch *search;
+
+	g_return_val_if_fail (needle != NULL && *needle != '\0', NULL);
+
+	search = g_slice_new0 (PlumaLiteralSearch);
+
+	search->text = g_strdup (needle);
+	search->flags = search_flags;
+	search->case_sensitive = PLUMA_SEARCH_IS_CASE_SENSITIVE (search_flags);
+	search->entire_word = PLUMA_SEARCH_IS_ENTIRE_WORD (search_flags);
+
+	if (search->case_sensitive)
+	{
+		search->needle = g_strdup (needle);
+	}
+	else
+	{
+		static GOnce fold_once = G_ONCE_INIT;
+		GHashTable *fold_lead_bytes;
+		guint8 *bits;
+		gunichar c;
+		gint i;
+
+		search->needle = g_utf8_casefold (needle, -1);
+
+		c = g_utf8_get_char (search->needle);
+
+		add_lead_byte (search->lead_bytes, c);
+		add_lead_byte (search->lead_bytes, g_unichar_toupper (c));
+		add_lead_byte (search->lead_bytes, g_unichar_totitle (c));
+
+		fold_lead_bytes = g_once (&fold_once, build_fold_lead_bytes, NULL);
+		bits = g_hash_table_lookup (fold_lead_bytes, GUINT_TO_POINTER (c));
+
+		if (bits != NULL)
+		{
+			for (i = 0; i < 32; i++)
+				search->lead_bytes[i] |= bits[i];
+		}
+	}
+
+	search->needle_len = strlen (search->needle);
+	search->needle_chars = g_utf8_strlen (search->needle, -1);
+
+	return search;
+}
+
+void
+pluma_literal_search_free (PlumaLiteralSearch *search)
+{
+	if (search == NULL)
+		return;
+
+	g_free (search->text);
+	g_free (search->needle);
+
+	g_slice_free (PlumaLiteralSearch, search);
+}
+
+gboolean
+pluma_literal_search_matches (PlumaLiteralSearch *search,
+			      const gchar        *needle,
+			      guint               search_flags)
+{
+	guint mask = PLUMA_SEARCH_CASE_SENSITIVE | PLUMA_SEARCH_ENTIRE_WORD;
+
+	return (search != NULL) &&
+	       ((search->flags & mask) == (search_flags & mask)) &&
+	       (strcmp (search->text, needle) == 0);
+}
+
+static const gchar *
+find_candidate (PlumaLiteralSearch *search,
+		const gchar        *p,
+		const gchar        *stop)
+{
+	if (p >= stop)
+		return NULL;
+
+	if (search->case_sensitive)
+		return memchr (p, search->needle[0], stop - p);
+
+	for (; p < stop; p++)
+	{
+		if (LEAD_BYTE_IS_SET (search->lead_bytes, *p))
+			return p;
+	}
+
+	return NULL;
+}
+
+/* Returns the end of the match starting at @p or NULL */
+static const gchar *
+match_at (PlumaLiteralSearch *search,
+	  const gchar        *p,
+	  const gchar        *end)
+{
+	const gchar *q;
+	const gchar *q_end;
+
+	if (search->case_sensitive)
+	{
+		gsize len = search->needle_len;
+
+		if ((gsize) (end - p) < len ||
+		    p[len - 1] != search->needle[len - 1] ||
+		    memcmp (p, search->needle, len) != 0)
+			return NULL;
+
+		return p + len;
+	}
+
+	q = search->needle;
+	q_end = search->needle + search->needle_len;
+
+	while (q < q_end)
+	{
+		if (p >= end)
+			return NULL;
+
+		if ((guchar) *p < 0x80)
+		{
+			if (g_ascii_tolower (*p) != *q)
+				return NULL;
+
+			p++;
+			q++;
+		}
+		else
+		{
+			const gchar *next;
+			gchar *folded;
+			gsize len;
+			gboolean equal;
+
+			next = g_utf8_next_char (p);
+			folded = g_utf8_casefold (p, next - p);
+			len = strlen (folded);
+
+			equal = (len <= (gsize) (q_end - q)) &&
+				(memcmp (folded, q, len) == 0);
+
+			g_free (folded);
+
+			if (!equal)
+				return NULL;
+
+			p = next;
+			q += len;
+		}
+	}
+
+	return p;
+}
+
+/* Looks for matches starting in the first @boundary bytes of @text,
+ * @base being the iter at the start of @text. */
+static gboolean
+scan_chunk (PlumaLiteralSearch *search,
+	    const gchar        *text,
+	    gsize               text_len,
+	    gsize               boundary,
+	    const GtkTextIter  *base,
+	    gboolean            find_last,
+	    GtkTextIter        *match_start,
+	    GtkTextIter        *match_end)
+{
+	const gchar *p = text;
+	const gchar *end = text + text_len;
+	const gchar *stop = text + boundary;
+	const gchar *cursor = text;
+	GtkTextIter cursor_iter = *base;
+	gboolean found = FALSE;
+
+	while ((p = find_candidate (search, p, stop)) != NULL)
+	{
+		const gchar *m_end;
+
+		m_end = match_at (search, p, end);
+
+		if (m_end != NULL)
+		{
+			GtkTextIter m_start_iter;
+			GtkTextIter m_end_iter;
+
+			/* candidates only go forward, so does the cursor */
+			gtk_text_iter_forward_chars (&cursor_iter,
+						     g_utf8_strlen (cursor, p - cursor));
+			cursor = p;
+
+			m_start_iter = cursor_iter;
+			m_end_iter = cursor_iter;
+			gtk_text_iter_forward_chars (&m_end_iter,
+						     g_utf8_strlen (p, m_end - p));
+
+			if (!search->entire_word ||
+			    (gtk_text_iter_starts_word (&m_start_iter) &&
+			     gtk_text_iter_ends_word (&m_end_iter)))
+			{
+				*match_start = m_start_iter;
+				*match_end = m_end_iter;
+				found = TRUE;
+
+				if (!find_last)
+					return TRUE;
+			}
+		}
+
+		/* lead bytes never show up inside a character, so
+		 * stepping one byte is enough */
+		p++;
+	}
+
+	return found;
+}
+
+static gboolean
+search_range (PlumaLiteralSearch *search,
+	      const GtkTextIter  *chunk_start,
+	      const GtkTextIter  *chunk_end,
+	      const GtkTextIter  *limit,
+	      gboolean            find_last,
+	      GtkTextIter        *match_start,
+	      GtkTextIter        *match_end)
+{
+	GtkTextIter text_end;
+	gchar *text;
+	const gchar *boundary;
+	gboolean found;
+
+	/* a match starting before chunk_end may run past it: a
+	 * casefolded character is never shorter than the original one so
+	 * it spans at most needle_chars characters */
+	text_end = *chunk_end;
+	gtk_text_iter_forward_chars (&text_end, search->needle_chars);
+
+	if (gtk_text_iter_compare (&text_end, limit) > 0)
+		text_end = *limit;
+
+	text = gtk_text_iter_get_slice (chunk_start, &text_end);
+
+	boundary = g_utf8_offset_to_pointer (text,
+					     gtk_text_iter_get_offset (chunk_end) -
+					     gtk_text_iter_get_offset (chunk_start));
+
+	found = scan_chunk (search,
+			    text,
+			    strlen (text),
+			    boundary - text,
+			    chunk_start,
+			    find_last,
+			    match_start,
+			    match_end);
+
+	g_free (text);
+
+	return found;
+}
+
+/**
+ * pluma_literal_search_forward:
+ * @search: a #PlumaLiteralSearch
+ * @start: where to start the search
+ * @limit: (allow-none): the match must end before @limit, %NULL for the
+ * end of the buffer
+ * @match_start: return location for the start of the match
+ * @match_end: return location for the end of the match
+ *
+ * Returns: %TRUE if a match was found.
+ */
+gboolean
+pluma_literal_search_forward (PlumaLiteralSearch *search,
+			      const GtkTextIter  *start,
+			      const GtkTextIter  *limit,
+			      GtkTextIter        *match_start,
+			      GtkTextIter        *match_end)
+{
+	GtkTextIter chunk_start;
+	GtkTextIter chunk_end;
+	GtkTextIter end;
+	gint chunk_chars = MIN_CHUNK_CHARS;
+
+	g_return_val_if_fail (search != NULL, FALSE);
+	g_return_val_if_fail (start != NULL, FALSE);
+
+	if (limit != NULL)
+		end = *limit;
+	else
+		gtk_text_buffer_get_end_iter (gtk_text_iter_get_buffer (start), &end);
+
+	chunk_start = *start;
+
+	while (gtk_text_iter_compare (&chunk_start, &end) < 0)
+	{
+		chunk_end = chunk_start;
+		gtk_text_iter_forward_chars (&chunk_end, chunk_chars);
+
+		if (gtk_text_iter_compare (&chunk_end, &end) > 0)
+			chunk_end = end;
+
+		if (search_range (search,
+				  &chunk_start,
+				  &chunk_end,
+				  &end,
+				  FALSE,
+				  match_start,
+				  match_end))
+			return TRUE;
+
+		chunk_start = chunk_end;
+		chunk_chars = MIN (chunk_chars * 2, MAX_CHUNK_CHARS);
+	}
+
+	return FALSE;
+}
+
+/**
+ * pluma_literal_search_backward:
+ * @search: a #PlumaLiteralSearch
+ * @start: where to start the search, the match ends before it
+ * @limit: (allow-none): the match must start after @limit, %NULL for the
+ * start of the buffer
+ * @match_start: return location for the start of the match
+ * @match_end: return location for the end of the match
+ *
+ * Returns: %TRUE if a match was found.
+ */
+gboolean
+pluma_literal_search_backward (PlumaLiteralSearch *search,
+			       const GtkTextIter  *start,
+			       const GtkTextIter  *limit,
+			       GtkTextIter        *match_start,
+			       GtkTextIter        *match_end)
+{
+	GtkTextIter chunk_start;
+	GtkTextIter chunk_end;
+	GtkTextIter begin;
+	gint chunk_chars = MIN_CHUNK_CHARS;
+
+	g_return_val_if_fail (search != NULL, FALSE);
+	g_return_val_if_fail (start != NULL, FALSE);
+
+	if (limit != NULL)
+		begin = *limit;
+	else
+		gtk_text_buffer_get_start_iter (gtk_text_iter_get_buffer (start), &begin);
+
+	chunk_end = *start;
+
+	while (gtk_text_iter_compare (&chunk_end, &begin) > 0)
+	{
+		chunk_start = chunk_end;
+		gtk_text_iter_backward_chars (&chunk_start, chunk_chars);
+
+		if (gtk_text_iter_compare (&chunk_start, &begin) < 0)
+			chunk_start = begin;
+
+		/* the last match of the chunk is the closest to start */
+		if (search_range (search,
+				  &chunk_start,
+				  &chunk_end,
+				  start,
+				  TRUE,
+				  match_start,
+				  match_end))
+			return TRUE;
+
+		chunk_end = chunk_start;
+		chunk_chars = MIN (chunk_chars * 2, MAX_CHUNK_CHARS);
+	}
+
+	return FALSE;
+}
@@ -0,0 +1,55 @@
+/*
+ * pluma-literal-search.h
+ * This file is part of pluma
+ *
+ * Copyright (C) 2012-2021 MATE Developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __PLUMA_LITERAL_SEARCH_H__
+#define __PLUMA_LITERAL_SEARCH_H__
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+typedef struct _PlumaLiteralSearch PlumaLiteralSearch;
+
+PlumaLiteralSearch	*pluma_literal_search_new	(const gchar        *needle,
+							 guint               search_flags);
+
+void			 pluma_literal_search_free	(PlumaLiteralSearch *search);
+
+gboolean		 pluma_literal_search_matches	(PlumaLiteralSearch *search,
+							 const gchar        *needle,
+							 guint               search_flags);
+
+gboolean		 pluma_literal_search_forward	(PlumaLiteralSearch *search,
+							 const GtkTextIter  *start,
+							 const GtkTextIter  *limit,
+							 GtkTextIter        *match_start,
+							 GtkTextIter        *match_end);
+
+gboolean		 pluma_literal_search_backward	(PlumaLiteralSearch *search,
+							 const GtkTextIter  *start,
+							 const GtkTextIter  *limit,
+							 GtkTextIter        *match_start,
+							 GtkTextIter        *match_end);
+
+G_END_DECLS
+
+#endif /* __PLUMA_LITERAL_SEARCH_H__ */
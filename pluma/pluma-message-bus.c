@@ -1,4 +1,5 @@
 #include "pluma-message-bus.h"
+#include "pluma-debug.h"
 
 #include <string.h>
 #include <stdarg.h>
@@ -121,6 +122,7 @@ struct _PlumaMessageBusPrivate
 
 	GList *message_queue;
 	guint idle_id;
+	gint64 queued_time;
 
 	guint next_id;
 
@@ -397,7 +399,13 @@ static void
 dispatch_message (PlumaMessageBus *bus,
 		  PlumaMessage    *message)
 {
+	gint64 trace;
+
+	trace = pluma_trace_begin ();
+
 	g_signal_emit (bus, message_bus_signals[DISPATCH], 0, message);
+
+	pluma_trace_end (PLUMA_DEBUG_PLUGINS, "dispatch", trace);
 }
 
 static gboolean
@@ -410,6 +418,10 @@ idle_dispatch (PlumaMessageBus *bus)
 	   will be queued properly */
 	bus->priv->idle_id = 0;
 
+	/* time from the first queued message to its delivery */
+	pluma_trace_end (PLUMA_DEBUG_PLUGINS, "dispatch-latency", bus->priv->queued_time);
+	bus->priv->queued_time = 0;
+
 	/* reverse queue to get correct delivery order */
 	list = g_list_reverse (bus->priv->message_queue);
 	bus->priv->message_queue = NULL;
@@ -981,10 +993,13 @@ send_message_real (PlumaMessageBus *bus,
 						   g_object_ref (message));
 
 	if (bus->priv->idle_id == 0)
+	{
+		bus->priv->queued_time = pluma_trace_begin ();
 		bus->priv->idle_id = g_idle_add_full (G_PRIORITY_HIGH,
 						      (GSourceFunc)idle_dispatch,
 						      bus,
 						      NULL);
+	}
 }
 
 /**
@@ -366,6 +366,18 @@ on_undo_actions_limit_changed (GSettings     *settings,
     g_list_free (docs);
 }
 
+/* The documents in large file mode keep the costly features off until
+ * the user asks for them from the info bar of the tab */
+static gboolean
+view_in_large_file_mode (gpointer view)
+{
+    GtkTextBuffer *buffer;
+
+    buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (view));
+
+    return pluma_document_get_large_file_mode (PLUMA_DOCUMENT (buffer));
+}
+
 static void
 on_wrap_mode_changed (GSettings     *settings,
                       const gchar   *key,
@@ -380,6 +392,9 @@ on_wrap_mode_changed (GSettings     *settings,
 
     for (l = views; l != NULL; l = g_list_next (l))
     {
+        if (view_in_large_file_mode (l->data))
+            continue;
+
         gtk_text_view_set_wrap_mode (GTK_TEXT_VIEW (l->data), wrap_mode);
     }
 
@@ -463,6 +478,9 @@ on_display_line_numbers_changed (GSettings     *settings,
 
     for (l = views; l != NULL; l = g_list_next (l))
     {
+        if (view_in_large_file_mode (l->data))
+            continue;
+
         gtk_source_view_set_show_line_numbers (GTK_SOURCE_VIEW (l->data), line_numbers);
     }
 
@@ -503,6 +521,9 @@ on_bracket_matching_changed (GSettings     *settings,
 
     for (l = docs; l != NULL; l = g_list_next (l))
     {
+        if (pluma_document_get_large_file_mode (PLUMA_DOCUMENT (l->data)))
+            continue;
+
         gtk_source_buffer_set_highlight_matching_brackets (GTK_SOURCE_BUFFER (l->data),
                                                            enable);
     }
@@ -587,6 +608,9 @@ on_syntax_highlighting_changed (GSettings     *settings,
 
     for (l = docs; l != NULL; l = g_list_next (l))
     {
+        if (pluma_document_get_large_file_mode (PLUMA_DOCUMENT (l->data)))
+            continue;
+
         gtk_source_buffer_set_highlight_syntax (GTK_SOURCE_BUFFER (l->data), enable);
     }
 
@@ -623,6 +647,9 @@ on_search_highlighting_changed (GSettings     *settings,
 
     for (l = docs; l != NULL; l = g_list_next (l))
     {
+        if (pluma_document_get_large_file_mode (PLUMA_DOCUMENT (l->data)))
+            continue;
+
         pluma_document_set_enable_search_highlighting (PLUMA_DOCUMENT (l->data),
                                                        enable);
     }
@@ -25,9 +25,14 @@
 #include "pluma-debug.h"
 #include "pluma-document.h"
 
+#include <errno.h>
+#include <string.h>
 #include <gio/gio.h>
 #include <glib/gi18n.h>
 
+/* Only the start of the first block is looked at to rank the candidates */
+#define MAX_SNIFF_SIZE 65536
+
 struct _PlumaSmartCharsetConverterPrivate
 {
 	GCharsetConverter *charset_conv;
@@ -35,6 +40,9 @@ struct _PlumaSmartCharsetConverterPrivate
 	GSList *encodings;
 	GSList *current_encoding;
 
+	/* candidate known to convert the first block without errors */
+	const PlumaEncoding *verified;
+
 	guint is_utf8 : 1;
 	guint use_first : 1;
 };
@@ -92,6 +100,7 @@ pluma_smart_charset_converter_init (PlumaSmartCharsetConverter *smart)
 	smart->priv->charset_conv = NULL;
 	smart->priv->encodings = NULL;
 	smart->priv->current_encoding = NULL;
+	smart->priv->verified = NULL;
 	smart->priv->is_utf8 = FALSE;
 	smart->priv->use_first = FALSE;
 
@@ -196,6 +205,507 @@ try_convert (GCharsetConverter *converter,
 	return ret;
 }
 
+/*
+ * Candidate ranking.
+ *
+ * Instead of converting the first block with every candidate in turn,
+ * the block is scanned once to collect some statistics (BOM, where the
+ * NUL bytes are, UTF-8 validity and how the bytes >= 0x80 are used) and
+ * the candidates are sorted so that the most likely one is tried first:
+ *
+ *  - a matching BOM wins;
+ *  - then UTF-8 when the block is valid UTF-8, and UTF-16/UTF-32 when
+ *    the NUL bytes fall where ASCII text in that encoding puts them;
+ *  - then the rest, where the single byte charsets are reordered among
+ *    themselves by how well their letters fit the surrounding text;
+ *  - the candidates that cannot decode the block go last.
+ */
+
+typedef enum
+{
+	BOM_NONE,
+	BOM_UTF8,
+	BOM_UTF16_LE,
+	BOM_UTF16_BE,
+	BOM_UTF32_LE,
+	BOM_UTF32_BE
+} Bom;
+
+typedef struct
+{
+	gsize    size;
+	Bom      bom;
+	gboolean valid_utf8;
+	gsize    high_bytes;
+	gsize    zeros[4];	/* NUL bytes, by offset modulo 4 */
+
+	/* for every byte >= 0x80: how many times it appears, how many of
+	 * its neighbours may be letters and how many times it follows an
+	 * ASCII lower case letter */
+	guint    count[128];
+	guint    letter_neighbours[128];
+	guint    after_lower[128];
+} BlockStats;
+
+static inline gboolean
+maybe_letter (guchar c)
+{
+	return g_ascii_isalpha (c) || c >= 0x80;
+}
+
+static void
+collect_stats (const guchar *buf,
+	       gsize         size,
+	       BlockStats   *stats)
+{
+	gsize i;
+	guint need = 0;
+	guchar lo = 0x80, hi = 0xbf;
+
+	memset (stats, 0, sizeof (BlockStats));
+
+	stats->size = size = MIN (size, MAX_SNIFF_SIZE);
+	stats->valid_utf8 = TRUE;
+
+	if (size >= 3 && buf[0] == 0xef && buf[1] == 0xbb && buf[2] == 0xbf)
+		stats->bom = BOM_UTF8;
+	else if (size >= 4 && buf[0] == 0xff && buf[1] == 0xfe && buf[2] == 0 && buf[3] == 0)
+		stats->bom = BOM_UTF32_LE;
+	else if (size >= 4 && buf[0] == 0 && buf[1] == 0 && buf[2] == 0xfe && buf[3] == 0xff)
+		stats->bom = BOM_UTF32_BE;
+	else if (size >= 2 && buf[0] == 0xff && buf[1] == 0xfe)
+		stats->bom = BOM_UTF16_LE;
+	else if (size >= 2 && buf[0] == 0xfe && buf[1] == 0xff)
+		stats->bom = BOM_UTF16_BE;
+
+	for (i = 0; i < size; i++)
+	{
+		guchar c = buf[i];
+
+		if (c < 0x80)
+		{
+			if (c == 0)
+			{
+				stats->zeros[i & 3]++;
+
+				/* g_utf8_validate() does not accept NUL */
+				stats->valid_utf8 = FALSE;
+			}
+
+			if (need > 0)
+				stats->valid_utf8 = FALSE;
+
+			need = 0;
+			continue;
+		}
+
+		stats->high_bytes++;
+		stats->count[c - 0x80]++;
+
+		if (i > 0 && maybe_letter (buf[i - 1]))
+			stats->letter_neighbours[c - 0x80]++;
+		if (i + 1 < size && maybe_letter (buf[i + 1]))
+			stats->letter_neighbours[c - 0x80]++;
+		if (i > 0 && g_ascii_islower (buf[i - 1]))
+			stats->after_lower[c - 0x80]++;
+
+		if (!stats->valid_utf8)
+			continue;
+
+		/* UTF-8 state machine, rejecting overlong forms, surrogates
+		 * and code points above U+10FFFF like g_utf8_validate() */
+		if (need > 0)
+		{
+			if (c < lo || c > hi)
+				stats->valid_utf8 = FALSE;
+
+			lo = 0x80;
+			hi = 0xbf;
+			need--;
+			continue;
+		}
+
+		if (c >= 0xc2 && c <= 0xdf)
+			need = 1;
+		else if (c >= 0xe0 && c <= 0xef)
+		{
+			need = 2;
+			if (c == 0xe0)
+				lo = 0xa0;
+			else if (c == 0xed)
+				hi = 0x9f;
+		}
+		else if (c >= 0xf0 && c <= 0xf4)
+		{
+			need = 3;
+			if (c == 0xf0)
+				lo = 0x90;
+			else if (c == 0xf4)
+				hi = 0x8f;
+		}
+		else
+			stats->valid_utf8 = FALSE;
+	}
+
+	/* a character cut at the end of the block is fine */
+}
+
+/* The mapping of the bytes >= 0x80 of a single byte charset */
+typedef struct
+{
+	gboolean single_byte;
+	gunichar map[128];	/* (gunichar) -1 if the byte is not valid */
+} CharsetTable;
+
+G_LOCK_DEFINE_STATIC (charset_tables);
+static GHashTable *charset_tables = NULL;
+
+static CharsetTable *
+build_charset_table (const gchar *charset)
+{
+	CharsetTable *table;
+	GIConv cd;
+	guint b;
+
+	table = g_new0 (CharsetTable, 1);
+
+	cd = g_iconv_open ("UTF-8", charset);
+	if (cd == (GIConv) -1)
+		return table;
+
+	table->single_byte = TRUE;
+
+	for (b = 0x80; b <= 0xff && table->single_byte; b++)
+	{
+		gchar in = (gchar) b;
+		gchar out[8];
+		gchar *inp = &in;
+		gchar *outp = out;
+		gsize in_left = 1;
+		gsize out_left = sizeof (out);
+
+		/* reset the conversion state */
+		g_iconv (cd, NULL, NULL, NULL, NULL);
+
+		if (g_iconv (cd, &inp, &in_left, &outp, &out_left) == (gsize) -1)
+		{
+			/* EINVAL means the byte starts a multi byte sequence */
+			if (errno == EINVAL)
+				table->single_byte = FALSE;
+
+			table->map[b - 0x80] = (gunichar) -1;
+		}
+		else if (outp == out)
+		{
+			/* a shift sequence of a stateful charset */
+			table->single_byte = FALSE;
+		}
+		else
+		{
+			gunichar ch;
+
+			ch = g_utf8_get_char_validated (out, outp - out);
+			table->map[b - 0x80] = (ch == (gunichar) -2) ? (gunichar) -1 : ch;
+		}
+	}
+
+	/* ASCII must be left alone too: this is not the case for UTF-7 and
+	 * the ISO-2022 charsets for instance */
+	if (table->single_byte)
+	{
+		gchar ascii[127];
+		gchar out[sizeof (ascii)];
+		gchar *inp = ascii;
+		gchar *outp = out;
+		gsize in_left = sizeof (ascii);
+		gsize out_left = sizeof (out);
+
+		for (b = 0; b < sizeof (ascii); b++)
+			ascii[b] = (gchar) (b + 1);
+
+		g_iconv (cd, NULL, NULL, NULL, NULL);
+
+		if (g_iconv (cd, &inp, &in_left, &outp, &out_left) == (gsize) -1 ||
+		    out_left != 0 ||
+		    memcmp (ascii, out, sizeof (ascii)) != 0)
+			table->single_byte = FALSE;
+	}
+
+	g_iconv_close (cd);
+
+	return table;
+}
+
+static const CharsetTable *
+get_charset_table (const gchar *charset)
+{
+	CharsetTable *table;
+
+	G_LOCK (charset_tables);
+
+	if (charset_tables == NULL)
+		charset_tables = g_hash_table_new_full (g_str_hash, g_str_equal,
+							g_free, g_free);
+
+	table = g_hash_table_lookup (charset_tables, charset);
+	if (table == NULL)
+	{
+		table = build_charset_table (charset);
+		g_hash_table_insert (charset_tables, g_strdup (charset), table);
+	}
+
+	G_UNLOCK (charset_tables);
+
+	return table;
+}
+
+/* Scores how well the text reads in a single byte charset, looking at the
+ * classes of each character and of its neighbours. Returns FALSE if the
+ * charset cannot decode the block. */
+static gboolean
+score_charset (const CharsetTable *table,
+	       const BlockStats   *stats,
+	       gint64             *score)
+{
+	guint b;
+
+	*score = 0;
+
+	for (b = 0; b < 128; b++)
+	{
+		gunichar ch;
+		guint count = stats->count[b];
+
+		if (count == 0)
+			continue;
+
+		ch = table->map[b];
+
+		if (ch == (gunichar) -1)
+			return FALSE;
+
+		if (ch >= 0x80 && ch <= 0x9f)
+		{
+			/* C1 controls do not show up in text */
+			*score -= 4 * count;
+		}
+		else if (g_unichar_isalpha (ch))
+		{
+			*score += count + stats->letter_neighbours[b];
+
+			/* running text is mostly lower case, and an upper case
+			 * letter rarely follows a lower case one */
+			if (g_unichar_islower (ch))
+				*score += count;
+			else if (g_unichar_isupper (ch))
+				*score -= 2 * stats->after_lower[b];
+		}
+		else if (!g_unichar_isspace (ch))
+		{
+			/* symbols are seldom glued to letters */
+			*score -= stats->letter_neighbours[b] / 2;
+		}
+	}
+
+	return TRUE;
+}
+
+typedef enum
+{
+	TIER_BOM,
+	TIER_LIKELY,
+	TIER_POSSIBLE,
+	TIER_UNLIKELY
+} Tier;
+
+typedef struct
+{
+	const PlumaEncoding *enc;
+	guint                index;
+	Tier                 tier;
+	gboolean             scored;
+	gint64               score;
+} Candidate;
+
+static gboolean
+charset_is (const gchar *charset,
+	    const gchar *name)
+{
+	return g_ascii_strcasecmp (charset, name) == 0;
+}
+
+static Tier
+unicode_tier (const gchar      *charset,
+	      const BlockStats *stats,
+	      gboolean         *is_unicode)
+{
+	gsize units;
+	gboolean le16, be16, le32, be32;
+	Tier other;
+
+	*is_unicode = TRUE;
+
+	/* ASCII text in UTF-16 has a NUL every other byte, and three out of
+	 * four in UTF-32 */
+	units = stats->size / 4;
+	le32 = units > 0 &&
+	       stats->zeros[1] + stats->zeros[2] + stats->zeros[3] >= units * 2 &&
+	       stats->zeros[0] < units / 4;
+	be32 = units > 0 &&
+	       stats->zeros[0] + stats->zeros[1] + stats->zeros[2] >= units * 2 &&
+	       stats->zeros[3] < units / 4;
+	units = stats->size / 2;
+	le16 = !le32 && units > 0 &&
+	       stats->zeros[1] + stats->zeros[3] >= units / 3 &&
+	       stats->zeros[0] + stats->zeros[2] < units / 12;
+	be16 = !be32 && units > 0 &&
+	       stats->zeros[0] + stats->zeros[2] >= units / 3 &&
+	       stats->zeros[1] + stats->zeros[3] < units / 12;
+
+	/* Without the pattern, text that has no NUL at all is unlikely to
+	 * be in these encodings; otherwise it could still be non-Latin text */
+	other = (stats->zeros[0] + stats->zeros[1] +
+		 stats->zeros[2] + stats->zeros[3] > 0) ? TIER_POSSIBLE : TIER_UNLIKELY;
+
+	/* UTF-16 and UTF-32 without a BOM are big endian */
+	if (charset_is (charset, "UTF-16"))
+	{
+		if (stats->bom == BOM_UTF16_LE || stats->bom == BOM_UTF16_BE)
+			return TIER_BOM;
+		return be16 ? TIER_LIKELY : other;
+	}
+	if (charset_is (charset, "UTF-16LE"))
+		return le16 ? TIER_LIKELY : other;
+	if (charset_is (charset, "UTF-16BE"))
+		return be16 ? TIER_LIKELY : other;
+	if (charset_is (charset, "UCS-2"))
+		return (le16 || be16) ? TIER_LIKELY : other;
+	if (charset_is (charset, "UTF-32"))
+	{
+		if (stats->bom == BOM_UTF32_LE || stats->bom == BOM_UTF32_BE)
+			return TIER_BOM;
+		return be32 ? TIER_LIKELY : other;
+	}
+	if (charset_is (charset, "UCS-4"))
+		return (le32 || be32) ? TIER_LIKELY : other;
+
+	*is_unicode = FALSE;
+
+	return TIER_POSSIBLE;
+}
+
+static gint
+compare_candidates (gconstpointer a,
+		    gconstpointer b)
+{
+	const Candidate *ca = a;
+	const Candidate *cb = b;
+
+	if (ca->tier != cb->tier)
+		return ca->tier < cb->tier ? -1 : 1;
+
+	if (ca->score != cb->score)
+		return ca->score > cb->score ? -1 : 1;
+
+	return ca->index < cb->index ? -1 : (ca->index > cb->index);
+}
+
+static void
+rank_encodings (PlumaSmartCharsetConverter *smart,
+		const BlockStats           *stats)
+{
+	GArray *candidates;
+	GArray *scored;
+	GSList *l;
+	GSList *ranked = NULL;
+	guint i, j;
+
+	candidates = g_array_new (FALSE, FALSE, sizeof (Candidate));
+	scored = g_array_new (FALSE, FALSE, sizeof (Candidate));
+
+	for (l = smart->priv->encodings, i = 0; l != NULL; l = g_slist_next (l), i++)
+	{
+		Candidate c = { l->data, i, TIER_POSSIBLE, FALSE, 0 };
+		const gchar *charset = pluma_encoding_get_charset (c.enc);
+		gboolean is_unicode;
+
+		if (c.enc == pluma_encoding_get_utf8 ())
+		{
+			if (stats->bom == BOM_UTF8)
+				c.tier = TIER_BOM;
+			else
+				c.tier = stats->valid_utf8 ? TIER_LIKELY : TIER_UNLIKELY;
+		}
+		else
+		{
+			c.tier = unicode_tier (charset, stats, &is_unicode);
+
+			if (!is_unicode)
+			{
+				const CharsetTable *table;
+
+				table = get_charset_table (charset);
+
+				if (table->single_byte)
+				{
+					c.scored = TRUE;
+
+					if (!score_charset (table, stats, &c.score))
+						c.tier = TIER_UNLIKELY;
+				}
+			}
+		}
+
+		g_array_append_val (candidates, c);
+
+		if (c.scored && c.tier == TIER_POSSIBLE)
+			g_array_append_val (scored, c);
+	}
+
+	/* the single byte charsets take each other's place, best first, so
+	 * that their order relative to the other candidates is kept */
+	g_array_sort (scored, compare_candidates);
+
+	for (i = 0, j = 0; i < candidates->len; i++)
+	{
+		Candidate *c = &g_array_index (candidates, Candidate, i);
+
+		if (c->scored && c->tier == TIER_POSSIBLE)
+			c->enc = g_array_index (scored, Candidate, j++).enc;
+
+		c->score = 0;
+	}
+
+	g_array_sort (candidates, compare_candidates);
+
+	for (i = candidates->len; i > 0; i--)
+	{
+		Candidate *c = &g_array_index (candidates, Candidate, i - 1);
+
+		ranked = g_slist_prepend (ranked, (gpointer) c->enc);
+	}
+
+	/* A single byte charset that maps every byte of the block converts
+	 * it for sure, unless there are NULs, which are not valid UTF-8 */
+	smart->priv->verified = NULL;
+	if (candidates->len > 0 && scored->len > 0)
+	{
+		Candidate *first = &g_array_index (candidates, Candidate, 0);
+		Candidate *best = &g_array_index (scored, Candidate, 0);
+
+		if (first->enc == best->enc &&
+		    stats->zeros[0] + stats->zeros[1] + stats->zeros[2] + stats->zeros[3] == 0 &&
+		    stats->size < MAX_SNIFF_SIZE)
+			smart->priv->verified = first->enc;
+	}
+
+	g_slist_free (smart->priv->encodings);
+	smart->priv->encodings = ranked;
+
+	g_array_free (candidates, TRUE);
+	g_array_free (scored, TRUE);
+}
+
 static GCharsetConverter *
 guess_encoding (PlumaSmartCharsetConverter *smart,
 		const void                 *inbuf,
@@ -213,6 +723,26 @@ guess_encoding (PlumaSmartCharsetConverter *smart,
 	    smart->priv->encodings->next == NULL)
 		smart->priv->use_first = TRUE;
 
+	if (!smart->priv->use_first)
+	{
+		BlockStats stats;
+
+		collect_stats (inbuf, inbuf_size, &stats);
+
+		/* Plain ASCII is valid UTF-8: no need to look further */
+		if (stats.high_bytes == 0 &&
+		    stats.bom == BOM_NONE &&
+		    stats.valid_utf8 &&
+		    g_slist_find (smart->priv->encodings,
+				  (gpointer) pluma_encoding_get_utf8 ()) != NULL)
+		{
+			smart->priv->is_utf8 = TRUE;
+			return NULL;
+		}
+
+		rank_encodings (smart, &stats);
+	}
+
 	/* We just check the first block */
 	while (TRUE)
 	{
@@ -269,8 +799,9 @@ guess_encoding (PlumaSmartCharsetConverter *smart,
 			break;
 		}
 
-		/* Try to convert */
-		if (try_convert (conv, inbuf, inbuf_size))
+		/* Try to convert, unless we already know it works */
+		if (enc == smart->priv->verified ||
+		    try_convert (conv, inbuf, inbuf_size))
 		{
 			break;
 		}
@@ -299,12 +830,16 @@ pluma_smart_charset_converter_convert (GConverter *converter,
 				       GError    **error)
 {
 	PlumaSmartCharsetConverter *smart = PLUMA_SMART_CHARSET_CONVERTER (converter);
+	GConverterResult ret;
+	gint64 trace;
 
 	/* Guess the encoding if we didn't make it yet */
 	if (smart->priv->charset_conv == NULL &&
 	    !smart->priv->is_utf8)
 	{
+		trace = pluma_trace_begin ();
 		smart->priv->charset_conv = guess_encoding (smart, inbuf, inbuf_size);
+		pluma_trace_end (PLUMA_DEBUG_LOADER, "guess-encoding", trace);
 
 		/* If we still have the previous case is that we didn't guess
 		   anything */
@@ -323,7 +858,6 @@ pluma_smart_charset_converter_convert (GConverter *converter,
 	if (smart->priv->is_utf8)
 	{
 		gsize size;
-		GConverterResult ret;
 
 		size = MIN (inbuf_size, outbuf_size);
 
@@ -343,15 +877,21 @@ pluma_smart_charset_converter_convert (GConverter *converter,
 
 	/* If we reached here is because we need to convert the text so, we
 	   convert it with the charset converter */
-	return g_converter_convert (G_CONVERTER (smart->priv->charset_conv),
-				    inbuf,
-				    inbuf_size,
-				    outbuf,
-				    outbuf_size,
-				    flags,
-				    bytes_read,
-				    bytes_written,
-				    error);
+	trace = pluma_trace_begin ();
+
+	ret = g_converter_convert (G_CONVERTER (smart->priv->charset_conv),
+				   inbuf,
+				   inbuf_size,
+				   outbuf,
+				   outbuf_size,
+				   flags,
+				   bytes_read,
+				   bytes_written,
+				   error);
+
+	pluma_trace_end (PLUMA_DEBUG_LOADER, "convert", trace);
+
+	return ret;
 }
 
 static void
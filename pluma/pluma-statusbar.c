@@ -52,6 +52,11 @@ struct _PlumaStatusbarPrivate
 	GtkWidget     *error_frame;
 	GtkWidget     *error_event_box;
 
+	/* what the labels show, to avoid relayouts when nothing changed */
+	gint           cursor_line;
+	gint           cursor_col;
+	gint           overwrite;	/* -1 when cleared */
+
 	/* tmp flash timeout data */
 	guint          flash_timeout;
 	guint          flash_context_id;
@@ -105,6 +110,10 @@ pluma_statusbar_init (PlumaStatusbar *statusbar)
 
 	statusbar->priv = pluma_statusbar_get_instance_private (statusbar);
 
+	statusbar->priv->cursor_line = -1;
+	statusbar->priv->cursor_col = -1;
+	statusbar->priv->overwrite = -1;
+
 	gtk_widget_set_margin_top (GTK_WIDGET (statusbar), 0);
 	gtk_widget_set_margin_bottom (GTK_WIDGET (statusbar), 0);
 
@@ -207,6 +216,12 @@ pluma_statusbar_set_overwrite (PlumaStatusbar *statusbar,
 
 	g_return_if_fail (PLUMA_IS_STATUSBAR (statusbar));
 
+	overwrite = overwrite != FALSE;
+	if (statusbar->priv->overwrite == overwrite)
+		return;
+
+	statusbar->priv->overwrite = overwrite;
+
 	msg = get_overwrite_mode_string (overwrite);
 
 	gtk_label_set_text (GTK_LABEL (statusbar->priv->overwrite_mode_label), msg);
@@ -219,6 +234,8 @@ pluma_statusbar_clear_overwrite (PlumaStatusbar *statusbar)
 {
 	g_return_if_fail (PLUMA_IS_STATUSBAR (statusbar));
 
+	statusbar->priv->overwrite = -1;
+
 	gtk_label_set_text (GTK_LABEL (statusbar->priv->overwrite_mode_label), NULL);
 }
 
@@ -239,6 +256,13 @@ pluma_statusbar_set_cursor_position (PlumaStatusbar *statusbar,
 
 	g_return_if_fail (PLUMA_IS_STATUSBAR (statusbar));
 
+	if (line == statusbar->priv->cursor_line &&
+	    col == statusbar->priv->cursor_col)
+		return;
+
+	statusbar->priv->cursor_line = line;
+	statusbar->priv->cursor_col = col;
+
 	if ((line >= 0) || (col >= 0))
 	{
 		/* Translators: "Ln" is an abbreviation for "Line", Col is an abbreviation for "Column". Please,
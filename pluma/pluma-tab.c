@@ -84,6 +84,12 @@ struct _PlumaTabPrivate
 	gint                    ask_if_externally_modified : 1;
 
 	guint			idle_scroll;
+
+	/* icon of the file, queried asynchronously for icon_location */
+	GFile                  *icon_location;
+	GIcon                  *file_icon;
+	GCancellable           *icon_cancellable;
+	GtkIconTheme           *icon_theme;
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE (PlumaTab, pluma_tab, GTK_TYPE_BOX)
@@ -98,6 +104,7 @@ enum
 };
 
 static gboolean pluma_tab_auto_save (PlumaTab *tab);
+static void forget_file_icon (PlumaTab *tab);
 
 static void
 install_auto_save_timeout (PlumaTab *tab)
@@ -243,6 +250,8 @@ pluma_tab_finalize (GObject *object)
 		tab->priv->idle_scroll = 0;
 	}
 
+	forget_file_icon (tab);
+
 	/* settings must be cleared in finalize and not in dispose to prevent
 	a warning when trying to close pluma while print-preview is active */
 	g_clear_object (&tab->priv->editor_settings);
@@ -448,6 +457,47 @@ document_shortname_notify_handler (PlumaDocument *document,
 	g_object_notify (G_OBJECT (tab), "name");
 }
 
+static void
+bind_view_map_visibility (PlumaTab *tab)
+{
+	g_settings_bind (tab->priv->editor_settings,
+			 PLUMA_SETTINGS_DISPLAY_OVERVIEW_MAP,
+			 tab->priv->view_map_frame,
+			 "visible",
+			 G_SETTINGS_BIND_GET | G_SETTINGS_BIND_NO_SENSITIVITY);
+}
+
+/* The document turns off its own costly features, the view ones are
+ * up to us: wrapping and line numbers need to lay out every line and
+ * the overview map renders the whole text a second time */
+static void
+document_large_file_mode_notify_handler (PlumaDocument *document,
+					 GParamSpec    *pspec,
+					 PlumaTab      *tab)
+{
+	GtkTextView *view = GTK_TEXT_VIEW (tab->priv->view);
+
+	if (pluma_document_get_large_file_mode (document))
+	{
+		gtk_text_view_set_wrap_mode (view, GTK_WRAP_NONE);
+		gtk_source_view_set_show_line_numbers (GTK_SOURCE_VIEW (view), FALSE);
+
+		g_settings_unbind (tab->priv->view_map_frame, "visible");
+		gtk_widget_hide (tab->priv->view_map_frame);
+	}
+	else
+	{
+		gtk_text_view_set_wrap_mode (view,
+					     pluma_settings_get_wrap_mode (tab->priv->editor_settings,
+									   PLUMA_SETTINGS_WRAP_MODE));
+		gtk_source_view_set_show_line_numbers (GTK_SOURCE_VIEW (view),
+						       g_settings_get_boolean (tab->priv->editor_settings,
+									       PLUMA_SETTINGS_DISPLAY_LINE_NUMBERS));
+
+		bind_view_map_visibility (tab);
+	}
+}
+
 static void
 document_modified_changed (GtkTextBuffer *document,
 			   PlumaTab      *tab)
@@ -572,6 +622,48 @@ file_already_open_warning_message_area_response (GtkWidget   *message_area,
 	gtk_widget_grab_focus (GTK_WIDGET (view));
 }
 
+static void
+large_file_message_area_response (GtkWidget *message_area,
+				  gint       response_id,
+				  PlumaTab  *tab)
+{
+	PlumaView *view;
+	PlumaDocument *doc;
+
+	view = pluma_tab_get_view (tab);
+	doc = pluma_tab_get_document (tab);
+
+	switch (response_id)
+	{
+		case PLUMA_LARGE_FILE_RESPONSE_HIGHLIGHTING:
+			gtk_source_buffer_set_highlight_syntax (GTK_SOURCE_BUFFER (doc),
+								pluma_document_get_language (doc) != NULL &&
+								g_settings_get_boolean (tab->priv->editor_settings,
+											PLUMA_SETTINGS_SYNTAX_HIGHLIGHTING));
+			gtk_info_bar_set_response_sensitive (GTK_INFO_BAR (message_area),
+							     response_id,
+							     FALSE);
+			return;
+		case PLUMA_LARGE_FILE_RESPONSE_WRAPPING:
+			gtk_text_view_set_wrap_mode (GTK_TEXT_VIEW (view),
+						     pluma_settings_get_wrap_mode (tab->priv->editor_settings,
+										   PLUMA_SETTINGS_WRAP_MODE));
+			gtk_info_bar_set_response_sensitive (GTK_INFO_BAR (message_area),
+							     response_id,
+							     FALSE);
+			return;
+		case GTK_RESPONSE_YES:
+			_pluma_document_set_large_file_mode (doc, FALSE);
+			break;
+		default:
+			break;
+	}
+
+	set_message_area (tab, NULL);
+
+	gtk_widget_grab_focus (GTK_WIDGET (view));
+}
+
 static void
 load_cancelled (GtkWidget        *area,
                 gint              response_id,
@@ -905,6 +997,9 @@ document_loaded (PlumaDocument *document,
 			  (tab->priv->state == PLUMA_TAB_STATE_REVERTING));
 	g_return_if_fail (tab->priv->auto_save_timeout <= 0);
 
+	/* the content type may have changed */
+	forget_file_icon (tab);
+
 	if (tab->priv->timer != NULL)
 	{
 		g_timer_destroy (tab->priv->timer);
@@ -1071,6 +1166,33 @@ document_loaded (PlumaDocument *document,
 
 		g_list_free (all_documents);
 
+		if (pluma_document_get_large_file_mode (document) &&
+		    tab->priv->message_area == NULL)
+		{
+			GtkWidget *w;
+
+			w = pluma_large_file_message_area_new ();
+
+			/* nothing to turn back on */
+			if (pluma_document_get_language (document) == NULL ||
+			    !g_settings_get_boolean (tab->priv->editor_settings,
+						     PLUMA_SETTINGS_SYNTAX_HIGHLIGHTING))
+			{
+				gtk_info_bar_set_response_sensitive (GTK_INFO_BAR (w),
+								     PLUMA_LARGE_FILE_RESPONSE_HIGHLIGHTING,
+								     FALSE);
+			}
+
+			set_message_area (tab, w);
+
+			gtk_widget_show (w);
+
+			g_signal_connect (w,
+					  "response",
+					  G_CALLBACK (large_file_message_area_response),
+					  tab);
+		}
+
 		pluma_tab_set_state (tab, PLUMA_TAB_STATE_NORMAL);
 
 		install_auto_save_timeout_if_needed (tab);
@@ -1279,6 +1401,8 @@ document_saved (PlumaDocument *document,
 	g_return_if_fail (tab->priv->tmp_encoding != NULL);
 	g_return_if_fail (tab->priv->auto_save_timeout <= 0);
 
+	forget_file_icon (tab);
+
 	g_timer_destroy (tab->priv->timer);
 	tab->priv->timer = NULL;
 	tab->priv->times_called = 0;
@@ -1442,47 +1566,56 @@ display_externally_modified_notification (PlumaTab *tab)
 			  tab);
 }
 
-static gboolean
-view_focused_in (GtkWidget     *widget,
-                 GdkEventFocus *event,
-                 PlumaTab      *tab)
+static void
+check_externally_modified (PlumaTab *tab)
 {
 	PlumaDocument *doc;
 
-	g_return_val_if_fail (PLUMA_IS_TAB (tab), FALSE);
-
 	/* we try to detect file changes only in the normal state */
 	if (tab->priv->state != PLUMA_TAB_STATE_NORMAL)
 	{
-		return FALSE;
+		return;
 	}
 
 	/* we already asked, don't bug the user again */
 	if (!tab->priv->ask_if_externally_modified)
 	{
-		return FALSE;
+		return;
 	}
 
 	doc = pluma_tab_get_document (tab);
 
-	/* If file was never saved or is remote we do not check */
-	if (!pluma_document_is_local (doc))
-	{
-		return FALSE;
-	}
-
+	/* does no I/O, the document watches the file */
 	if (_pluma_document_check_externally_modified (doc))
 	{
 		pluma_tab_set_state (tab, PLUMA_TAB_STATE_EXTERNALLY_MODIFIED_NOTIFICATION);
 
 		display_externally_modified_notification (tab);
-
-		return FALSE;
 	}
+}
+
+static gboolean
+view_focused_in (GtkWidget     *widget,
+                 GdkEventFocus *event,
+                 PlumaTab      *tab)
+{
+	g_return_val_if_fail (PLUMA_IS_TAB (tab), FALSE);
+
+	check_externally_modified (tab);
 
 	return FALSE;
 }
 
+static void
+document_externally_modified_notify_handler (PlumaDocument *document,
+					     GParamSpec    *pspec,
+					     PlumaTab      *tab)
+{
+	/* the other tabs ask when they get the focus */
+	if (gtk_widget_has_focus (tab->priv->view))
+		check_externally_modified (tab);
+}
+
 static GMountOperation *
 tab_mount_operation_factory (PlumaDocument *doc,
 			     gpointer userdata)
@@ -1590,11 +1723,7 @@ pluma_tab_init (PlumaTab *tab)
 	gtk_widget_show (hbox);
 	gtk_widget_show (tab->priv->overlay);
 
-	g_settings_bind (tab->priv->editor_settings,
-			 PLUMA_SETTINGS_DISPLAY_OVERVIEW_MAP,
-			 tab->priv->view_map_frame,
-			 "visible",
-			 G_SETTINGS_BIND_GET | G_SETTINGS_BIND_NO_SENSITIVITY);
+	bind_view_map_visibility (tab);
 
 	g_signal_connect (doc,
 			  "notify::uri",
@@ -1604,6 +1733,14 @@ pluma_tab_init (PlumaTab *tab)
 			  "notify::shortname",
 			  G_CALLBACK (document_shortname_notify_handler),
 			  tab);
+	g_signal_connect (doc,
+			  "notify::large-file-mode",
+			  G_CALLBACK (document_large_file_mode_notify_handler),
+			  tab);
+	g_signal_connect (doc,
+			  "notify::externally-modified",
+			  G_CALLBACK (document_externally_modified_notify_handler),
+			  tab);
 	g_signal_connect (doc,
 			  "modified_changed",
 			  G_CALLBACK (document_modified_changed),
@@ -1860,67 +1997,228 @@ resize_icon (GdkPixbuf *pixbuf,
 	return pixbuf;
 }
 
+#define ICON_CACHE_KEY "pluma-tab-icon-cache"
+
+static void
+icon_cache_theme_changed (GtkIconTheme *theme,
+			  GHashTable   *cache)
+{
+	g_hash_table_remove_all (cache);
+}
+
+/* The icons of all the tabs and of the documents panel, by icon name,
+ * for a given theme. Most files share a few content types, so this
+ * avoids loading and scaling the same pixbufs over and over. */
+static GHashTable *
+get_icon_cache (GtkIconTheme *theme)
+{
+	GHashTable *cache;
+
+	cache = g_object_get_data (G_OBJECT (theme), ICON_CACHE_KEY);
+
+	if (cache == NULL)
+	{
+		cache = g_hash_table_new_full (g_str_hash,
+					       g_str_equal,
+					       g_free,
+					       g_object_unref);
+
+		g_object_set_data_full (G_OBJECT (theme),
+					ICON_CACHE_KEY,
+					cache,
+					(GDestroyNotify) g_hash_table_destroy);
+
+		/* connected before any tab, so the tabs see the new icons */
+		g_signal_connect (theme,
+				  "changed",
+				  G_CALLBACK (icon_cache_theme_changed),
+				  cache);
+	}
+
+	return cache;
+}
+
 static GdkPixbuf *
 get_stock_icon (GtkIconTheme *theme,
 		const gchar  *icon_name,
 		gint          size)
 {
+	GHashTable *cache;
 	GdkPixbuf *pixbuf;
 
-	pixbuf = gtk_icon_theme_load_icon (theme, icon_name, size, 0, NULL);
+	cache = get_icon_cache (theme);
+	pixbuf = g_hash_table_lookup (cache, icon_name);
+
 	if (pixbuf == NULL)
-		return NULL;
+	{
+		pixbuf = gtk_icon_theme_load_icon (theme, icon_name, size, 0, NULL);
+		if (pixbuf == NULL)
+			return NULL;
+
+		pixbuf = resize_icon (pixbuf, size);
+		g_hash_table_insert (cache, g_strdup (icon_name), pixbuf);
+	}
 
-	return resize_icon (pixbuf, size);
+	return g_object_ref (pixbuf);
 }
 
 static GdkPixbuf *
 get_icon (GtkIconTheme *theme,
-	  GFile        *location,
+	  GIcon        *gicon,
 	  gint          size)
 {
+	GHashTable *cache;
 	GdkPixbuf *pixbuf;
 	GtkIconInfo *icon_info;
-	GFileInfo *info;
-	GIcon *gicon;
+	gchar *key;
 
-	if (location == NULL)
+	if (gicon == NULL)
 		return get_stock_icon (theme, "text-x-generic", size);
 
-	/* FIXME: Doing a sync stat is bad, this should be fixed */
-	info = g_file_query_info (location,
-	                          G_FILE_ATTRIBUTE_STANDARD_ICON,
-	                          G_FILE_QUERY_INFO_NONE,
-	                          NULL,
-	                          NULL);
-	if (info == NULL)
-		return get_stock_icon (theme, "text-x-generic", size);
+	cache = get_icon_cache (theme);
 
-	gicon = g_file_info_get_icon (info);
+	/* NULL for icons that cannot be serialized, they are not cached */
+	key = g_icon_to_string (gicon);
 
-	if (gicon == NULL)
+	if (key != NULL)
 	{
-		g_object_unref (info);
-		return get_stock_icon (theme, "text-x-generic", size);
+		pixbuf = g_hash_table_lookup (cache, key);
+
+		if (pixbuf != NULL)
+		{
+			g_free (key);
+			return g_object_ref (pixbuf);
+		}
 	}
 
 	icon_info = gtk_icon_theme_lookup_by_gicon (theme, gicon, size, 0);
-	g_object_unref (info);
 
 	if (icon_info == NULL)
+	{
+		g_free (key);
 		return get_stock_icon (theme, "text-x-generic", size);
+	}
 
 	pixbuf = gtk_icon_info_load_icon (icon_info, NULL);
 	g_object_unref (icon_info);
 
 	if (pixbuf == NULL)
+	{
+		g_free (key);
 		return get_stock_icon (theme, "text-x-generic", size);
+	}
+
+	pixbuf = resize_icon (pixbuf, size);
+
+	if (key != NULL)
+		g_hash_table_insert (cache, key, g_object_ref (pixbuf));
 
-	return resize_icon (pixbuf, size);
+	return pixbuf;
+}
+
+static void
+forget_file_icon (PlumaTab *tab)
+{
+	if (tab->priv->icon_cancellable != NULL)
+	{
+		g_cancellable_cancel (tab->priv->icon_cancellable);
+		g_clear_object (&tab->priv->icon_cancellable);
+	}
+
+	g_clear_object (&tab->priv->icon_location);
+	g_clear_object (&tab->priv->file_icon);
 }
 
-/* FIXME: add support for theme changed. I think it should be as easy as
-   call g_object_notify (tab, "name") when the icon theme changes */
+static void
+file_icon_queried (GFile        *location,
+		   GAsyncResult *result,
+		   PlumaTab     *tab)
+{
+	GFileInfo *info;
+	GError *error = NULL;
+
+	info = g_file_query_info_finish (location, result, &error);
+
+	/* the tab may be gone already */
+	if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+	{
+		g_error_free (error);
+		return;
+	}
+
+	g_clear_object (&tab->priv->icon_cancellable);
+
+	if (info != NULL)
+	{
+		GIcon *gicon;
+
+		gicon = g_file_info_get_icon (info);
+		if (gicon != NULL)
+			tab->priv->file_icon = g_object_ref (gicon);
+
+		g_object_unref (info);
+	}
+	else
+	{
+		/* keep the generic icon, do not query again */
+		g_error_free (error);
+	}
+
+	/* the tab label and the documents panel update the icon with
+	 * the name */
+	g_object_notify (G_OBJECT (tab), "name");
+}
+
+static void
+query_file_icon (PlumaTab *tab,
+		 GFile    *location)
+{
+	forget_file_icon (tab);
+
+	tab->priv->icon_location = g_object_ref (location);
+	tab->priv->icon_cancellable = g_cancellable_new ();
+
+	g_file_query_info_async (location,
+				 G_FILE_ATTRIBUTE_STANDARD_ICON,
+				 G_FILE_QUERY_INFO_NONE,
+				 G_PRIORITY_DEFAULT,
+				 tab->priv->icon_cancellable,
+				 (GAsyncReadyCallback) file_icon_queried,
+				 tab);
+}
+
+static void
+tab_icon_theme_changed (PlumaTab *tab)
+{
+	g_object_notify (G_OBJECT (tab), "name");
+}
+
+static void
+watch_icon_theme (PlumaTab     *tab,
+		  GtkIconTheme *theme)
+{
+	if (tab->priv->icon_theme == theme)
+		return;
+
+	if (tab->priv->icon_theme != NULL)
+	{
+		g_signal_handlers_disconnect_by_func (tab->priv->icon_theme,
+						      tab_icon_theme_changed,
+						      tab);
+	}
+
+	tab->priv->icon_theme = theme;
+
+	g_signal_connect_object (theme,
+				 "changed",
+				 G_CALLBACK (tab_icon_theme_changed),
+				 tab,
+				 G_CONNECT_SWAPPED);
+}
+
+/* The icon of a file is only known once an async query returns: until
+ * then the generic one is used, and "name" is notified when it is
+ * there. The pixbufs are shared by all the tabs, so asking is cheap. */
 GdkPixbuf *
 _pluma_tab_get_icon (PlumaTab *tab)
 {
@@ -1936,6 +2234,10 @@ _pluma_tab_get_icon (PlumaTab *tab)
 	theme = gtk_icon_theme_get_for_screen (screen);
 	g_return_val_if_fail (theme != NULL, NULL);
 
+	/* the cache must follow theme changes before the tab does */
+	get_icon_cache (theme);
+	watch_icon_theme (tab, theme);
+
 	gtk_icon_size_lookup (GTK_ICON_SIZE_MENU, NULL, &icon_size);
 
 	switch (tab->priv->state)
@@ -1994,7 +2296,17 @@ _pluma_tab_get_icon (PlumaTab *tab)
 			doc = pluma_tab_get_document (tab);
 
 			location = pluma_document_get_location (doc);
-			pixbuf = get_icon (theme, location, icon_size);
+
+			if (location != NULL &&
+			    (tab->priv->icon_location == NULL ||
+			     !g_file_equal (location, tab->priv->icon_location)))
+			{
+				query_file_icon (tab, location);
+			}
+
+			pixbuf = get_icon (theme,
+					   location != NULL ? tab->priv->file_icon : NULL,
+					   icon_size);
 
 			if (location)
 				g_object_unref (location);
@@ -57,6 +57,9 @@
 
 #define MIN_SEARCH_COMPLETION_KEY_LEN 3
 
+/* characters scanned per idle slice by the typeahead search */
+#define TYPEAHEAD_SLICE_CHARS (1 << 20)
+
 /* Local variables */
 static gboolean middle_or_right_down = FALSE;
 
@@ -99,6 +102,35 @@ struct _PlumaViewPrivate
     guint        typeselect_flush_timeout;
     guint        search_entry_changed_id;
 
+    /* state of the incremental search while typing: the last query
+     * that completed, where it matched (or whether it matched at all)
+     * and the scan in progress for the current query
+     */
+    gchar       *typeahead_text;
+    guint        typeahead_flags;
+    gint         typeahead_match;
+    gboolean     typeahead_failed;
+
+    gchar       *typeahead_pending;
+    guint        typeahead_idle_id;
+    gint         typeahead_pos;
+    gint         typeahead_limit;
+    gint         typeahead_overlap;
+    gboolean     typeahead_wrap;
+
+    /* bounds (as offsets) of the text on screen at the last draw and
+     * the document highlight generation at that time: while neither
+     * changes there is nothing new to highlight
+     */
+    guint        highlight_generation;
+    gint         highlight_start;
+    gint         highlight_end;
+
+    /* the document has lines so long that only the part of them on
+     * screen may be looked at when drawing
+     */
+    gboolean     long_line_mode;
+
     gboolean     disable_popdown;
 
     GtkTextBuffer        *current_buffer;
@@ -172,6 +204,13 @@ static void     search_highlight_updated_cb  (PlumaDocument    *doc,
                                               GtkTextIter      *end,
                                               PlumaView        *view);
 
+static void     typeahead_buffer_changed_cb  (GtkTextBuffer    *buffer,
+                                              PlumaView        *view);
+
+static void     document_loaded_cb           (PlumaDocument    *doc,
+                                              const GError     *error,
+                                              PlumaView        *view);
+
 static void    pluma_view_delete_from_cursor (GtkTextView     *text_view,
                                               GtkDeleteType    type,
                                               gint             count);
@@ -381,10 +420,18 @@ current_buffer_removed (PlumaView *view)
         g_signal_handlers_disconnect_by_func (view->priv->current_buffer,
                                               search_highlight_updated_cb,
                                               view);
+        g_signal_handlers_disconnect_by_func (view->priv->current_buffer,
+                                              typeahead_buffer_changed_cb,
+                                              view);
+        g_signal_handlers_disconnect_by_func (view->priv->current_buffer,
+                                              document_loaded_cb,
+                                              view);
 
         g_object_unref (view->priv->current_buffer);
         view->priv->current_buffer = NULL;
     }
+
+    view->priv->highlight_start = -1;
 }
 
 static void
@@ -414,6 +461,18 @@ on_notify_buffer_cb (PlumaView  *view,
                       G_CALLBACK (search_highlight_updated_cb),
                       view);
 
+    g_signal_connect (buffer,
+                      "changed",
+                      G_CALLBACK (typeahead_buffer_changed_cb),
+                      view);
+
+    g_signal_connect (buffer,
+                      "loaded",
+                      G_CALLBACK (document_loaded_cb),
+                      view);
+
+    document_loaded_cb (PLUMA_DOCUMENT (buffer), NULL, view);
+
     /* We only activate the extensions when the right buffer is set,
      * because most plugins will expect this behaviour, and we won't
      * change the buffer later anyway. */
@@ -501,6 +560,39 @@ pluma_set_source_space_drawer (GSettings *settings, GtkSourceView *view)
 }
 #endif
 
+/* Drawing the white space looks at every character of the lines on
+ * screen, even the parts scrolled away: off in long line mode */
+static void
+set_long_line_mode (PlumaView *view,
+                    gboolean   long_line_mode)
+{
+    if (view->priv->long_line_mode == long_line_mode)
+        return;
+
+    pluma_debug_message (DEBUG_VIEW, "long line mode: %d", long_line_mode);
+
+    view->priv->long_line_mode = long_line_mode;
+    view->priv->highlight_start = -1;
+
+#ifdef GTK_SOURCE_VERSION_3_24
+    gtk_source_space_drawer_set_enable_matrix (gtk_source_view_get_space_drawer (GTK_SOURCE_VIEW (view)),
+                                               !long_line_mode);
+#else
+    if (long_line_mode)
+        gtk_source_view_set_draw_spaces (GTK_SOURCE_VIEW (view), 0);
+    else
+        pluma_set_source_space_drawer (view->priv->editor_settings, GTK_SOURCE_VIEW (view));
+#endif
+}
+
+static void
+document_loaded_cb (PlumaDocument *doc,
+                    const GError  *error,
+                    PlumaView     *view)
+{
+    set_long_line_mode (view, _pluma_document_has_long_lines (doc));
+}
+
 static void
 pluma_view_init (PlumaView *view)
 {
@@ -594,6 +686,8 @@ pluma_view_init (PlumaView *view)
 
     view->priv->typeselect_flush_timeout = 0;
     view->priv->wrap_around = TRUE;
+    view->priv->typeahead_match = -1;
+    view->priv->highlight_start = -1;
 
     /* Drag and drop support */
     tl = gtk_drag_dest_get_target_list (GTK_WIDGET (view));
@@ -628,6 +722,12 @@ pluma_view_dispose (GObject *object)
         view->priv->extensions = NULL;
     }
 
+    if (view->priv->typeahead_idle_id != 0)
+    {
+        g_source_remove (view->priv->typeahead_idle_id);
+        view->priv->typeahead_idle_id = 0;
+    }
+
     if (view->priv->search_window != NULL)
     {
         gtk_widget_destroy (view->priv->search_window);
@@ -666,6 +766,8 @@ pluma_view_finalize (GObject *object)
     current_buffer_removed (view);
 
     g_free (view->priv->old_search_text);
+    g_free (view->priv->typeahead_text);
+    g_free (view->priv->typeahead_pending);
 
     (* G_OBJECT_CLASS (pluma_view_parent_class)->finalize) (object);
 }
@@ -838,7 +940,7 @@ pluma_view_upper_case_selection (PlumaView *view)
 
     if (gtk_text_buffer_get_selection_bounds (buffer, &start, &end))
     {
-        gtk_source_buffer_change_case (GTK_SOURCE_BUFFER (buffer), GTK_SOURCE_CHANGE_CASE_UPPER, &start, &end);
+        pluma_document_change_case (PLUMA_DOCUMENT (buffer), GTK_SOURCE_CHANGE_CASE_UPPER, &start, &end);
     }
 }
 
@@ -857,7 +959,7 @@ pluma_view_lower_case_selection (PlumaView *view)
 
     if (gtk_text_buffer_get_selection_bounds (buffer, &start, &end))
     {
-        gtk_source_buffer_change_case (GTK_SOURCE_BUFFER (buffer), GTK_SOURCE_CHANGE_CASE_LOWER, &start, &end);
+        pluma_document_change_case (PLUMA_DOCUMENT (buffer), GTK_SOURCE_CHANGE_CASE_LOWER, &start, &end);
     }
 }
 
@@ -876,7 +978,7 @@ pluma_view_invert_case_selection (PlumaView *view)
 
     if (gtk_text_buffer_get_selection_bounds (buffer, &start, &end))
     {
-        gtk_source_buffer_change_case (GTK_SOURCE_BUFFER (buffer), GTK_SOURCE_CHANGE_CASE_TOGGLE, &start, &end);
+        pluma_document_change_case (PLUMA_DOCUMENT (buffer), GTK_SOURCE_CHANGE_CASE_TOGGLE, &start, &end);
     }
 }
 
@@ -895,7 +997,7 @@ pluma_view_title_case_selection (PlumaView *view)
 
     if (gtk_text_buffer_get_selection_bounds (buffer, &start, &end))
     {
-        gtk_source_buffer_change_case (GTK_SOURCE_BUFFER (buffer), GTK_SOURCE_CHANGE_CASE_TITLE, &start, &end);
+        pluma_document_change_case (PLUMA_DOCUMENT (buffer), GTK_SOURCE_CHANGE_CASE_TITLE, &start, &end);
     }
 }
 
@@ -1087,6 +1189,48 @@ set_entry_state (GtkWidget             *entry,
     }
 }
 
+static void
+show_search_result (PlumaView   *view,
+                    GtkTextIter *match_start,
+                    GtkTextIter *match_end,
+                    gboolean     typing,
+                    gboolean     empty)
+{
+    GtkTextBuffer *buffer;
+
+    buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (view));
+
+    if (match_start != NULL)
+    {
+        gtk_text_buffer_place_cursor (buffer, match_start);
+
+        gtk_text_buffer_move_mark_by_name (buffer,
+                                           "selection_bound",
+                                           match_end);
+    }
+    else
+    {
+        if (typing)
+        {
+            gtk_text_buffer_place_cursor (buffer,
+                                          &view->priv->start_search_iter);
+        }
+    }
+
+    if ((match_start != NULL) || empty)
+    {
+        pluma_view_scroll_to_cursor (view);
+
+        set_entry_state (view->priv->search_entry,
+                         PLUMA_SEARCH_ENTRY_NORMAL);
+    }
+    else
+    {
+        set_entry_state (view->priv->search_entry,
+                         PLUMA_SEARCH_ENTRY_NOT_FOUND);
+    }
+}
+
 static gboolean
 run_search (PlumaView        *view,
             const gchar      *entry_text,
@@ -1171,37 +1315,224 @@ run_search (PlumaView        *view,
                                               NULL);
     }
 
-    if (found)
+    show_search_result (view,
+                        found ? &match_start : NULL,
+                        found ? &match_end : NULL,
+                        typing,
+                        *entry_text == '\0');
+
+    return found;
+}
+
+static void
+typeahead_cancel (PlumaView *view)
+{
+    if (view->priv->typeahead_idle_id != 0)
     {
-        gtk_text_buffer_place_cursor (GTK_TEXT_BUFFER (doc), &match_start);
+        g_source_remove (view->priv->typeahead_idle_id);
+        view->priv->typeahead_idle_id = 0;
+    }
 
-        gtk_text_buffer_move_mark_by_name (GTK_TEXT_BUFFER (doc),
-                                           "selection_bound",
-                                           &match_end);
+    g_free (view->priv->typeahead_pending);
+    view->priv->typeahead_pending = NULL;
+}
+
+static void
+typeahead_reset (PlumaView *view)
+{
+    typeahead_cancel (view);
+
+    g_free (view->priv->typeahead_text);
+    view->priv->typeahead_text = NULL;
+    view->priv->typeahead_match = -1;
+    view->priv->typeahead_failed = FALSE;
+}
+
+static void
+typeahead_buffer_changed_cb (GtkTextBuffer *buffer,
+                             PlumaView     *view)
+{
+    /* offsets and the "no match" watermark are stale */
+    typeahead_reset (view);
+}
+
+static void
+typeahead_finish (PlumaView   *view,
+                  GtkTextIter *match_start,
+                  GtkTextIter *match_end)
+{
+    g_free (view->priv->typeahead_text);
+    view->priv->typeahead_text = view->priv->typeahead_pending;
+    view->priv->typeahead_pending = NULL;
+    view->priv->typeahead_flags = view->priv->search_flags;
+
+    if (match_start != NULL)
+    {
+        view->priv->typeahead_match = gtk_text_iter_get_offset (match_start);
+        view->priv->typeahead_failed = FALSE;
     }
     else
     {
-        if (typing)
-        {
-            gtk_text_buffer_place_cursor (GTK_TEXT_BUFFER (doc),
-                                          &view->priv->start_search_iter);
-        }
+        view->priv->typeahead_match = -1;
+        view->priv->typeahead_failed = TRUE;
     }
 
-    if (found || (*entry_text == '\0'))
+    show_search_result (view, match_start, match_end, TRUE, FALSE);
+}
+
+/* Scans one slice of the buffer, returns TRUE if there is more to scan */
+static gboolean
+typeahead_search_slice (PlumaView *view)
+{
+    PlumaDocument *doc;
+    GtkTextIter    iter;
+    GtkTextIter    limit;
+    GtkTextIter    match_start;
+    GtkTextIter    match_end;
+    gint           limit_offset;
+
+    doc = PLUMA_DOCUMENT (gtk_text_view_get_buffer (GTK_TEXT_VIEW (view)));
+
+    limit_offset = view->priv->typeahead_limit;
+
+    if (limit_offset < 0)
+        limit_offset = gtk_text_buffer_get_char_count (GTK_TEXT_BUFFER (doc));
+
+    if (view->priv->typeahead_overlap >= 0)
+        limit_offset = MIN (limit_offset,
+                            view->priv->typeahead_pos + TYPEAHEAD_SLICE_CHARS);
+
+    gtk_text_buffer_get_iter_at_offset (GTK_TEXT_BUFFER (doc),
+                                        &iter,
+                                        view->priv->typeahead_pos);
+    gtk_text_buffer_get_iter_at_offset (GTK_TEXT_BUFFER (doc),
+                                        &limit,
+                                        limit_offset);
+
+    if (pluma_document_search_forward (doc,
+                                       &iter,
+                                       &limit,
+                                       &match_start,
+                                       &match_end))
     {
-        pluma_view_scroll_to_cursor (view);
+        typeahead_finish (view, &match_start, &match_end);
+        return FALSE;
+    }
 
-        set_entry_state (view->priv->search_entry,
-                         PLUMA_SEARCH_ENTRY_NORMAL);
+    if (!gtk_text_iter_is_end (&limit) &&
+        (view->priv->typeahead_limit < 0 ||
+         limit_offset < view->priv->typeahead_limit))
+    {
+        /* matches must end before the limit, so rescan the tail of
+         * this slice to find the ones crossing it */
+        view->priv->typeahead_pos = MAX (view->priv->typeahead_pos + 1,
+                                         limit_offset - view->priv->typeahead_overlap);
+        return TRUE;
+    }
+
+    if (view->priv->typeahead_wrap)
+    {
+        view->priv->typeahead_wrap = FALSE;
+        view->priv->typeahead_pos = 0;
+
+        /* everything after the start point has been scanned already */
+        if (view->priv->typeahead_overlap >= 0)
+            view->priv->typeahead_limit =
+                gtk_text_iter_get_offset (&view->priv->start_search_iter) +
+                view->priv->typeahead_overlap;
+        else
+            view->priv->typeahead_limit = -1;
+
+        return TRUE;
     }
+
+    typeahead_finish (view, NULL, NULL);
+
+    return FALSE;
+}
+
+static gboolean
+typeahead_search_idle (PlumaView *view)
+{
+    if (typeahead_search_slice (view))
+        return G_SOURCE_CONTINUE;
+
+    view->priv->typeahead_idle_id = 0;
+
+    return G_SOURCE_REMOVE;
+}
+
+/* Search while typing. A query extending the previous one cannot match
+ * before the previous match, and cannot match at all if the previous
+ * one did not, so the scan resumes from the previous match or is
+ * skipped. Large buffers are scanned in idle slices, the next keystroke
+ * cancels the scan in progress.
+ */
+static void
+run_typeahead_search (PlumaView   *view,
+                      const gchar *entry_text)
+{
+    gint     start_offset;
+    gint     len;
+    gboolean incremental;
+
+    typeahead_cancel (view);
+
+    if (*entry_text == '\0')
+    {
+        typeahead_reset (view);
+        run_search (view, entry_text, FALSE, view->priv->wrap_around, TRUE);
+
+        return;
+    }
+
+    incremental = (view->priv->typeahead_text != NULL) &&
+                  (view->priv->typeahead_flags == view->priv->search_flags) &&
+                  !PLUMA_SEARCH_IS_MATCH_REGEX (view->priv->search_flags) &&
+                  !PLUMA_SEARCH_IS_ENTIRE_WORD (view->priv->search_flags) &&
+                  g_str_has_prefix (entry_text, view->priv->typeahead_text);
+
+    view->priv->typeahead_pending = g_strdup (entry_text);
+
+    if (incremental && view->priv->typeahead_failed)
+    {
+        typeahead_finish (view, NULL, NULL);
+
+        return;
+    }
+
+    start_offset = gtk_text_iter_get_offset (&view->priv->start_search_iter);
+    len = g_utf8_strlen (entry_text, -1);
+
+    /* case folding may change the length of the match, regex matches
+     * can be of any length so they are not sliced */
+    if (PLUMA_SEARCH_IS_MATCH_REGEX (view->priv->search_flags))
+        view->priv->typeahead_overlap = -1;
     else
+        view->priv->typeahead_overlap = 2 * len;
+
+    view->priv->typeahead_pos = start_offset;
+    view->priv->typeahead_limit = -1;
+    view->priv->typeahead_wrap = view->priv->wrap_around;
+
+    if (incremental && view->priv->typeahead_match >= 0)
     {
-        set_entry_state (view->priv->search_entry,
-                         PLUMA_SEARCH_ENTRY_NOT_FOUND);
+        view->priv->typeahead_pos = view->priv->typeahead_match;
+
+        /* the previous match had wrapped around, nothing can match
+         * after the start point */
+        if (view->priv->typeahead_match < start_offset)
+        {
+            view->priv->typeahead_limit = start_offset + view->priv->typeahead_overlap;
+            view->priv->typeahead_wrap = FALSE;
+        }
     }
 
-    return found;
+    if (typeahead_search_slice (view))
+    {
+        view->priv->typeahead_idle_id =
+            g_idle_add ((GSourceFunc) typeahead_search_idle, view);
+    }
 }
 
 /* Cut and paste from gtkwindow.c */
@@ -1244,6 +1575,8 @@ hide_search_window (PlumaView *view, gboolean cancel)
         view->priv->typeselect_flush_timeout = 0;
     }
 
+    typeahead_reset (view);
+
     /* send focus-in event */
     send_focus_change (GTK_WIDGET (view->priv->search_entry), FALSE);
     gtk_text_view_set_cursor_visible (GTK_TEXT_VIEW (view), TRUE);
@@ -1334,6 +1667,8 @@ search_again (PlumaView *view,
 
     add_search_completion_entry (entry_text);
 
+    typeahead_cancel (view);
+
     run_search (view,
                 entry_text,
                 search_backward,
@@ -1977,11 +2312,7 @@ search_init (GtkWidget *entry,
 
         g_free (search_text);
 
-        run_search (view,
-                    entry_text,
-                    FALSE,
-                    view->priv->wrap_around,
-                    TRUE);
+        run_typeahead_search (view, entry_text);
     }
     else
     {
@@ -2129,14 +2460,50 @@ start_interactive_goto_line (PlumaView *view)
     return start_interactive_search_real (view);
 }
 
+/* Without wrapping, the text between the first and the last character
+ * on screen also holds what is scrolled away on the left and on the
+ * right of each line: search the visible columns one line at a time */
+static void
+search_visible_columns (PlumaView          *view,
+                        PlumaDocument      *doc,
+                        const GdkRectangle *visible_rect)
+{
+    GtkTextView *text_view = GTK_TEXT_VIEW (view);
+    GtkTextIter line;
+
+    gtk_text_view_get_line_at_y (text_view, &line, visible_rect->y, NULL);
+
+    do
+    {
+        GtkTextIter start, end;
+        gint y, height;
+
+        gtk_text_view_get_line_yrange (text_view, &line, &y, &height);
+
+        if (y >= visible_rect->y + visible_rect->height)
+            break;
+
+        gtk_text_view_get_iter_at_location (text_view, &start,
+                                            visible_rect->x, y);
+        gtk_text_view_get_iter_at_location (text_view, &end,
+                                            visible_rect->x + visible_rect->width, y);
+        gtk_text_iter_forward_char (&end);
+
+        _pluma_document_search_region (doc, &start, &end);
+    }
+    while (gtk_text_iter_forward_line (&line));
+}
+
 static gboolean
 pluma_view_draw (GtkWidget *widget,
                  cairo_t   *cr)
 {
+    PlumaView *view;
     GtkTextView *text_view;
     PlumaDocument *doc;
     GdkWindow *window;
 
+    view = PLUMA_VIEW (widget);
     text_view = GTK_TEXT_VIEW (widget);
 
     doc = PLUMA_DOCUMENT (gtk_text_view_get_buffer (text_view));
@@ -2147,18 +2514,59 @@ pluma_view_draw (GtkWidget *widget,
     {
         GdkRectangle visible_rect;
         GtkTextIter iter1, iter2;
+        guint generation;
+        gint start, end;
 
         gtk_text_view_get_visible_rect (text_view, &visible_rect);
-        gtk_text_view_get_line_at_y (text_view, &iter1,
-                                     visible_rect.y, NULL);
-        gtk_text_view_get_line_at_y (text_view, &iter2,
-                                     visible_rect.y
-                                     + visible_rect.height, NULL);
-        gtk_text_iter_forward_line (&iter2);
 
-        _pluma_document_search_region (doc,
-                                       &iter1,
-                                       &iter2);
+        if (view->priv->long_line_mode)
+        {
+            gtk_text_view_get_iter_at_location (text_view, &iter1,
+                                                visible_rect.x,
+                                                visible_rect.y);
+            gtk_text_view_get_iter_at_location (text_view, &iter2,
+                                                visible_rect.x
+                                                + visible_rect.width,
+                                                visible_rect.y
+                                                + visible_rect.height);
+            gtk_text_iter_forward_char (&iter2);
+        }
+        else
+        {
+            gtk_text_view_get_line_at_y (text_view, &iter1,
+                                         visible_rect.y, NULL);
+            gtk_text_view_get_line_at_y (text_view, &iter2,
+                                         visible_rect.y
+                                         + visible_rect.height, NULL);
+            gtk_text_iter_forward_line (&iter2);
+        }
+
+        /* most draws (cursor blinking, the tags we have just applied...)
+         * do not expose anything new: skip the region lookup for them */
+        generation = _pluma_document_get_highlight_generation (doc);
+        start = gtk_text_iter_get_offset (&iter1);
+        end = gtk_text_iter_get_offset (&iter2);
+
+        if (generation != view->priv->highlight_generation ||
+            start != view->priv->highlight_start ||
+            end != view->priv->highlight_end)
+        {
+            if (view->priv->long_line_mode &&
+                gtk_text_view_get_wrap_mode (text_view) == GTK_WRAP_NONE)
+            {
+                search_visible_columns (view, doc, &visible_rect);
+            }
+            else
+            {
+                _pluma_document_search_region (doc,
+                                               &iter1,
+                                               &iter2);
+            }
+
+            view->priv->highlight_generation = generation;
+            view->priv->highlight_start = start;
+            view->priv->highlight_end = end;
+        }
     }
 
     return GTK_WIDGET_CLASS (pluma_view_parent_class)->draw (widget, cr);
@@ -2475,6 +2883,7 @@ delete_line (GtkTextView *text_view,
     GtkTextIter start;
     GtkTextIter end;
     GtkTextBuffer *buffer;
+    gboolean selection;
 
     buffer = gtk_text_view_get_buffer (text_view);
 
@@ -2482,33 +2891,40 @@ delete_line (GtkTextView *text_view,
 
     /* If there is a selection delete the selected lines and
      * ignore count */
-    if (gtk_text_buffer_get_selection_bounds (buffer, &start, &end))
+    selection = gtk_text_buffer_get_selection_bounds (buffer, &start, &end);
+
+    if (selection || count > 0)
     {
-        gtk_text_iter_order (&start, &end);
+        if (!selection)
+            gtk_text_iter_forward_lines (&end, count);
 
-        if (gtk_text_iter_starts_line (&end))
+        if (!gtk_text_view_get_editable (text_view) ||
+            gtk_text_buffer_get_char_count (buffer) == 0)
         {
-            /* Do no delete the line with the cursor if the cursor
-             * is at the beginning of the line */
-            count = 0;
+            gtk_widget_error_bell (GTK_WIDGET (text_view));
+            return;
         }
-        else
-            count = 1;
-    }
 
-    gtk_text_iter_set_line_offset (&start, 0);
+        /* the document deletes the whole lines at once, but leaves
+         * the line of the cursor if the selection ends at its start */
+        gtk_text_buffer_begin_user_action (buffer);
 
-    if (count > 0)
-    {
-        gtk_text_iter_forward_lines (&end, count);
+        pluma_document_delete_lines (PLUMA_DOCUMENT (buffer), &start, &end,
+                                     gtk_text_view_get_editable (text_view));
 
-        if (gtk_text_iter_is_end (&end))
-        {
-            if (gtk_text_iter_backward_line (&start) && !gtk_text_iter_ends_line (&start))
-                gtk_text_iter_forward_to_line_end (&start);
-        }
+        gtk_text_iter_set_line_offset (&start, 0);
+        gtk_text_buffer_place_cursor (buffer, &start);
+
+        gtk_text_buffer_end_user_action (buffer);
+
+        gtk_text_view_scroll_mark_onscreen (text_view,
+                                            gtk_text_buffer_get_insert (buffer));
+        return;
     }
-    else if (count < 0)
+
+    gtk_text_iter_set_line_offset (&start, 0);
+
+    if (count < 0)
     {
         if (!gtk_text_iter_ends_line (&end))
             gtk_text_iter_forward_to_line_end (&end);
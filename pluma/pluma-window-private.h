@@ -73,6 +73,19 @@ struct _PlumaWindowPrivate
 	guint 		spaces_instead_of_tabs_id;
 	guint 		language_changed_id;
 
+	/* cursor position, overwrite mode and tab width are shown at most
+	 * once per frame */
+	guint           statusbar_tick_id;
+	guint           statusbar_dirty;
+
+	/* last visual column computed for the cursor, so that moving along
+	 * a long line does not expand its tabs from the start every time */
+	GtkTextBuffer  *column_buffer;
+	gint            column_line;
+	gint            column_offset;
+	gint            column_value;
+	guint           column_tab_width;
+
 	/* Menus & Toolbars */
 	GtkUIManager   *manager;
 	GtkActionGroup *action_group;
@@ -203,6 +203,13 @@ pluma_window_dispose (GObject *object)
         window->priv->fullscreen_animation_timeout_id = 0;
     }
 
+    if (window->priv->statusbar_tick_id != 0)
+    {
+        gtk_widget_remove_tick_callback (GTK_WIDGET (window),
+                                         window->priv->statusbar_tick_id);
+        window->priv->statusbar_tick_id = 0;
+    }
+
     if (window->priv->fullscreen_controls != NULL)
     {
         gtk_widget_destroy (window->priv->fullscreen_controls);
@@ -2122,20 +2129,157 @@ clone_window (PlumaWindow *origin)
     return window;
 }
 
+enum
+{
+    STATUSBAR_CURSOR    = 1 << 0,
+    STATUSBAR_OVERWRITE = 1 << 1,
+    STATUSBAR_TAB_WIDTH = 1 << 2
+};
+
+static void sync_tab_width_combo (PlumaWindow *window,
+                                  guint        new_tab_width);
+
+/* A tab before the cached position makes its width depend on what is
+ * before it: only a backward move over plain characters can reuse the
+ * cache */
+static gboolean
+no_tab_before (const GtkTextIter *iter,
+               gint               cached_offset)
+{
+    GtkTextIter pos;
+    gint i;
+
+    pos = *iter;
+
+    for (i = gtk_text_iter_get_line_offset (iter); i < cached_offset; i++)
+    {
+        if (gtk_text_iter_get_char (&pos) == '\t')
+            return FALSE;
+
+        gtk_text_iter_forward_char (&pos);
+    }
+
+    return TRUE;
+}
+
+/* Same as gtk_source_view_get_visual_column(), but when the cursor moved
+ * on the line of the previous call only the characters in between are
+ * looked at: moving around a very long line does not rescan it */
+static gint
+get_cursor_visual_column (PlumaWindow       *window,
+                          PlumaView         *view,
+                          const GtkTextIter *iter)
+{
+    GtkTextBuffer *buffer;
+    GtkTextIter pos;
+    guint tab_width;
+    gint line;
+    gint offset;
+    gint column;
+
+    buffer = gtk_text_iter_get_buffer (iter);
+    tab_width = gtk_source_view_get_tab_width (GTK_SOURCE_VIEW (view));
+    line = gtk_text_iter_get_line (iter);
+    offset = gtk_text_iter_get_line_offset (iter);
+
+    if (window->priv->column_buffer == buffer &&
+        window->priv->column_tab_width == tab_width &&
+        window->priv->column_line == line &&
+        window->priv->column_offset <= offset)
+    {
+        column = window->priv->column_value;
+
+        gtk_text_buffer_get_iter_at_line_offset (buffer,
+                                                 &pos,
+                                                 line,
+                                                 window->priv->column_offset);
+
+        while (gtk_text_iter_compare (&pos, iter) < 0)
+        {
+            if (gtk_text_iter_get_char (&pos) == '\t')
+                column += tab_width - (column % tab_width);
+            else
+                column++;
+
+            gtk_text_iter_forward_char (&pos);
+        }
+    }
+    else if (window->priv->column_buffer == buffer &&
+             window->priv->column_tab_width == tab_width &&
+             window->priv->column_line == line &&
+             no_tab_before (iter, window->priv->column_offset))
+    {
+        /* no tab in between, each character is a column */
+        column = window->priv->column_value -
+                 (window->priv->column_offset - offset);
+    }
+    else
+    {
+        column = gtk_source_view_get_visual_column (GTK_SOURCE_VIEW (view), iter);
+    }
+
+    window->priv->column_buffer = buffer;
+    window->priv->column_tab_width = tab_width;
+    window->priv->column_line = line;
+    window->priv->column_offset = offset;
+    window->priv->column_value = column;
+
+    return column;
+}
+
+/* An edit before the cached position changes its visual column */
 static void
-update_cursor_position_statusbar (GtkTextBuffer *buffer,
-                                  PlumaWindow   *window)
+invalidate_cursor_column (PlumaWindow       *window,
+                          GtkTextBuffer     *buffer,
+                          const GtkTextIter *pos)
+{
+    gint line;
+
+    if (window->priv->column_buffer != buffer)
+        return;
+
+    line = gtk_text_iter_get_line (pos);
+
+    if (line < window->priv->column_line ||
+        (line == window->priv->column_line &&
+         gtk_text_iter_get_line_offset (pos) < window->priv->column_offset))
+    {
+        window->priv->column_buffer = NULL;
+    }
+}
+
+static void
+column_insert_text_cb (GtkTextBuffer *buffer,
+                       GtkTextIter   *pos,
+                       gchar         *text,
+                       gint           len,
+                       PlumaWindow   *window)
+{
+    invalidate_cursor_column (window, buffer, pos);
+}
+
+static void
+column_delete_range_cb (GtkTextBuffer *buffer,
+                        GtkTextIter   *start,
+                        GtkTextIter   *end,
+                        PlumaWindow   *window)
+{
+    invalidate_cursor_column (window, buffer, start);
+}
+
+static void
+sync_cursor_position (PlumaWindow *window)
 {
     gint row, col;
     GtkTextIter iter;
+    GtkTextBuffer *buffer;
     PlumaView *view;
 
-    pluma_debug (DEBUG_WINDOW);
-
-     if (buffer != GTK_TEXT_BUFFER (pluma_window_get_active_document (window)))
-         return;
+    view = pluma_window_get_active_view (window);
+    if (view == NULL)
+        return;
 
-     view = pluma_window_get_active_view (window);
+    buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (view));
 
     gtk_text_buffer_get_iter_at_mark (buffer,
                                       &iter,
@@ -2143,13 +2287,72 @@ update_cursor_position_statusbar (GtkTextBuffer *buffer,
 
     row = gtk_text_iter_get_line (&iter);
 
-    col = gtk_source_view_get_visual_column (GTK_SOURCE_VIEW(view), &iter);
+    col = get_cursor_visual_column (window, view, &iter);
 
     pluma_statusbar_set_cursor_position (PLUMA_STATUSBAR (window->priv->statusbar),
                                          row + 1,
                                          col + 1);
 }
 
+static gboolean
+statusbar_tick_cb (GtkWidget     *widget,
+                   GdkFrameClock *frame_clock,
+                   gpointer       user_data)
+{
+    PlumaWindow *window = PLUMA_WINDOW (widget);
+    PlumaView *view;
+    guint dirty;
+
+    dirty = window->priv->statusbar_dirty;
+    window->priv->statusbar_dirty = 0;
+    window->priv->statusbar_tick_id = 0;
+
+    view = pluma_window_get_active_view (window);
+    if (view == NULL)
+        return G_SOURCE_REMOVE;
+
+    if (dirty & STATUSBAR_TAB_WIDTH)
+        sync_tab_width_combo (window,
+                              gtk_source_view_get_tab_width (GTK_SOURCE_VIEW (view)));
+
+    if (dirty & STATUSBAR_CURSOR)
+        sync_cursor_position (window);
+
+    if (dirty & STATUSBAR_OVERWRITE)
+        pluma_statusbar_set_overwrite (PLUMA_STATUSBAR (window->priv->statusbar),
+                                       gtk_text_view_get_overwrite (GTK_TEXT_VIEW (view)));
+
+    return G_SOURCE_REMOVE;
+}
+
+static void
+queue_statusbar_update (PlumaWindow *window,
+                        guint        what)
+{
+    window->priv->statusbar_dirty |= what;
+
+    if (window->priv->statusbar_tick_id == 0)
+    {
+        window->priv->statusbar_tick_id =
+            gtk_widget_add_tick_callback (GTK_WIDGET (window),
+                                          statusbar_tick_cb,
+                                          NULL,
+                                          NULL);
+    }
+}
+
+static void
+update_cursor_position_statusbar (GtkTextBuffer *buffer,
+                                  PlumaWindow   *window)
+{
+    pluma_debug (DEBUG_WINDOW);
+
+    if (buffer != GTK_TEXT_BUFFER (pluma_window_get_active_document (window)))
+        return;
+
+    queue_statusbar_update (window, STATUSBAR_CURSOR);
+}
+
 static void
 update_overwrite_mode_statusbar (GtkTextView *view,
                                  PlumaWindow *window)
@@ -2157,12 +2360,9 @@ update_overwrite_mode_statusbar (GtkTextView *view,
     if (view != GTK_TEXT_VIEW (pluma_window_get_active_view (window)))
         return;
 
-    /* Note that we have to use !gtk_text_view_get_overwrite since we
-       are in the in the signal handler of "toggle overwrite" that is
-       G_SIGNAL_RUN_LAST
-    */
-    pluma_statusbar_set_overwrite (PLUMA_STATUSBAR (window->priv->statusbar),
-                                   !gtk_text_view_get_overwrite (view));
+    /* the mode is read when the statusbar is updated, by then the
+       "toggle overwrite" signal has run */
+    queue_statusbar_update (window, STATUSBAR_OVERWRITE);
 }
 
 #define MAX_TITLE_LENGTH 100
@@ -2306,20 +2506,16 @@ spaces_instead_of_tabs_changed (GObject     *object,
 }
 
 static void
-tab_width_changed (GObject     *object,
-                   GParamSpec  *pspec,
-                   PlumaWindow *window)
+sync_tab_width_combo (PlumaWindow *window,
+                      guint        new_tab_width)
 {
     GList *items;
     GList *item;
     PlumaStatusComboBox *combo = PLUMA_STATUS_COMBO_BOX (window->priv->tab_width_combo);
-    guint new_tab_width;
     gboolean found = FALSE;
 
     items = pluma_status_combo_box_get_items (combo);
 
-    new_tab_width = gtk_source_view_get_tab_width (GTK_SOURCE_VIEW (object));
-
     for (item = items; item; item = item->next)
     {
         guint tab_width = GPOINTER_TO_INT (g_object_get_data (G_OBJECT (item->data), TAB_WIDTH_DATA));
@@ -2360,6 +2556,15 @@ tab_width_changed (GObject     *object,
     g_list_free (items);
 }
 
+static void
+tab_width_changed (GObject     *object,
+                   GParamSpec  *pspec,
+                   PlumaWindow *window)
+{
+    /* the visual column depends on the tab width too */
+    queue_statusbar_update (window, STATUSBAR_TAB_WIDTH | STATUSBAR_CURSOR);
+}
+
 static void
 language_changed (GObject     *object,
                   GParamSpec  *pspec,
@@ -2466,8 +2671,7 @@ notebook_switch_page (GtkNotebook     *book,
     view = pluma_tab_get_view (tab);
 
     /* sync the statusbar */
-    update_cursor_position_statusbar (GTK_TEXT_BUFFER (pluma_tab_get_document (tab)),
-                                      window);
+    sync_cursor_position (window);
     pluma_statusbar_set_overwrite (PLUMA_STATUSBAR (window->priv->statusbar),
                                    gtk_text_view_get_overwrite (GTK_TEXT_VIEW (view)));
 
@@ -2489,7 +2693,8 @@ notebook_switch_page (GtkNotebook     *book,
                                                           window);
 
     /* call it for the first time */
-    tab_width_changed (G_OBJECT (view), NULL, window);
+    sync_tab_width_combo (window,
+                          gtk_source_view_get_tab_width (GTK_SOURCE_VIEW (view)));
     spaces_instead_of_tabs_changed (G_OBJECT (view), NULL, window);
     language_changed (G_OBJECT (pluma_tab_get_document (tab)), NULL, window);
 
@@ -3225,6 +3430,14 @@ notebook_tab_added (PlumaNotebook *notebook,
                       "cursor-moved",
                       G_CALLBACK (update_cursor_position_statusbar),
                       window);
+    g_signal_connect (doc,
+                      "insert-text",
+                      G_CALLBACK (column_insert_text_cb),
+                      window);
+    g_signal_connect (doc,
+                      "delete-range",
+                      G_CALLBACK (column_delete_range_cb),
+                      window);
     g_signal_connect (doc,
                       "notify::can-search-again",
                       G_CALLBACK (can_search_again),
@@ -3296,6 +3509,15 @@ notebook_tab_removed (PlumaNotebook *notebook,
     g_signal_handlers_disconnect_by_func (doc,
                                           G_CALLBACK (update_cursor_position_statusbar),
                                           window);
+    g_signal_handlers_disconnect_by_func (doc,
+                                          G_CALLBACK (column_insert_text_cb),
+                                          window);
+    g_signal_handlers_disconnect_by_func (doc,
+                                          G_CALLBACK (column_delete_range_cb),
+                                          window);
+
+    if (window->priv->column_buffer == GTK_TEXT_BUFFER (doc))
+        window->priv->column_buffer = NULL;
     g_signal_handlers_disconnect_by_func (doc,
                                           G_CALLBACK (can_search_again),
                                           window);
@@ -652,6 +652,8 @@ main (int argc, char *argv[])
 	pluma_metadata_manager_shutdown ();
 #endif
 
+	pluma_trace_shutdown ();
+
 	return EXIT_SUCCESS;
 }
 
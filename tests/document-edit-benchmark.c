@@ -0,0 +1,599 @@
+/*
+ * document-edit-benchmark.c
+ * This file is part of pluma
+ *
+ * Copyright (C) 2012-2021 MATE Developers
+ *
+ * pluma is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * pluma is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pluma; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA  02110-1301  USA
+ */
+
+/*
+ * Headless editing and search benchmark.
+ *
+ * PlumaDocument instances are created without any window or view and
+ * driven through scripted workloads (replace all, search, highlighting,
+ * goto line, insert/delete traces and the operations done by the sort,
+ * docinfo and trailsave plugins). Each workload is run a number of times
+ * on a freshly generated document and a summary with percentiles is
+ * printed as one JSON object per line.
+ *
+ * With --markers=/sys/kernel/tracing/trace_marker (or any other file)
+ * "pluma-bench: begin/end <workload>" markers are written around every
+ * timed section, so that the workloads can be located in perf/ftrace
+ * recordings.
+ */
+
+#include "pluma-document.h"
+#include "plugins/sort/pluma-sort-engine.h"
+#include "plugins/docinfo/pluma-docinfo-count.h"
+#include "plugins/trailsave/pluma-trail-save-strip.h"
+#include <gtk/gtk.h>
+#include <glib.h>
+#include <glib/gprintf.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SEARCH_WORD  "fox"
+#define REPLACE_WORD "cat"
+#define N_RANDOM_OPS 10000
+
+typedef void (*WorkloadFunc) (PlumaDocument *doc,
+                              GRand         *rand);
+
+typedef struct
+{
+	const gchar  *name;
+	gboolean      search_highlighting;
+	WorkloadFunc  run;
+} Workload;
+
+static gint   n_lines = 200000;
+static gint   iterations = 10;
+static gchar *workload_filter = NULL;
+static gchar *markers_path = NULL;
+
+static FILE  *markers = NULL;
+
+static GOptionEntry entries[] =
+{
+	{ "lines", 'l', 0, G_OPTION_ARG_INT, &n_lines,
+	  "Number of lines of the generated document (default 200000)", "N" },
+	{ "iterations", 'i', 0, G_OPTION_ARG_INT, &iterations,
+	  "Number of runs per workload (default 10)", "N" },
+	{ "workload", 'w', 0, G_OPTION_ARG_STRING, &workload_filter,
+	  "Only run the named workload", "NAME" },
+	{ "markers", 'm', 0, G_OPTION_ARG_FILENAME, &markers_path,
+	  "Write begin/end markers to FILE (e.g. a trace_marker file)", "FILE" },
+	{ NULL }
+};
+
+static gchar *
+generate_text (void)
+{
+	GString *text;
+	gint i;
+
+	text = g_string_sized_new ((gsize) n_lines * 64);
+
+	for (i = 0; i < n_lines; i++)
+	{
+		/* every other line has trailing white spaces, every line has
+		 * exactly one match of SEARCH_WORD, and the leading number is
+		 * not sorted so that sorting has some work to do */
+		g_string_append_printf (text,
+		                        "%08d the quick brown " SEARCH_WORD " jumps over the lazy dog%s\n",
+		                        (i * 7919) % n_lines,
+		                        (i % 2) ? "  \t " : "");
+	}
+
+	return g_string_free (text, FALSE);
+}
+
+static void
+marker (const gchar *what,
+        const gchar *name)
+{
+	if (markers == NULL)
+		return;
+
+	fprintf (markers, "pluma-bench: %s %s\n", what, name);
+	fflush (markers);
+}
+
+static void
+run_replace_all (PlumaDocument *doc,
+                 GRand         *rand)
+{
+	pluma_document_replace_all (doc,
+	                            SEARCH_WORD,
+	                            REPLACE_WORD,
+	                            PLUMA_SEARCH_CASE_SENSITIVE);
+}
+
+static void
+run_replace_all_nocase (PlumaDocument *doc,
+                        GRand         *rand)
+{
+	pluma_document_replace_all (doc, "FOX", REPLACE_WORD, 0);
+}
+
+static void
+run_replace_all_regex (PlumaDocument *doc,
+                       GRand         *rand)
+{
+	pluma_document_replace_all (doc,
+	                            "f[aeiou]x",
+	                            REPLACE_WORD,
+	                            PLUMA_SEARCH_CASE_SENSITIVE | PLUMA_SEARCH_MATCH_REGEX);
+}
+
+static void
+run_search_forward (PlumaDocument *doc,
+                    GRand         *rand)
+{
+	GtkTextIter iter;
+	GtkTextIter match_end;
+
+	pluma_document_set_search_text (doc, SEARCH_WORD, PLUMA_SEARCH_CASE_SENSITIVE);
+
+	gtk_text_buffer_get_start_iter (GTK_TEXT_BUFFER (doc), &iter);
+
+	while (pluma_document_search_forward (doc, &iter, NULL, NULL, &match_end))
+	{
+		iter = match_end;
+	}
+}
+
+static void
+run_search_miss (PlumaDocument *doc,
+                 GRand         *rand)
+{
+	/* full scan of the document without any match */
+	pluma_document_set_search_text (doc, "zebra", 0);
+	pluma_document_search_forward (doc, NULL, NULL, NULL, NULL);
+}
+
+static void
+run_search_forward_gtk (PlumaDocument *doc,
+                        GRand         *rand)
+{
+	GtkTextIter iter;
+	GtkTextIter match_end;
+
+	/* baseline for search-forward: the generic GtkTextIter search */
+	gtk_text_buffer_get_start_iter (GTK_TEXT_BUFFER (doc), &iter);
+
+	while (gtk_text_iter_forward_search (&iter, SEARCH_WORD, 0,
+	                                     NULL, &match_end, NULL))
+	{
+		iter = match_end;
+	}
+}
+
+static void
+run_search_miss_gtk (PlumaDocument *doc,
+                     GRand         *rand)
+{
+	GtkTextIter iter;
+
+	gtk_text_buffer_get_start_iter (GTK_TEXT_BUFFER (doc), &iter);
+	gtk_text_iter_forward_search (&iter, "zebra",
+	                              GTK_TEXT_SEARCH_CASE_INSENSITIVE,
+	                              NULL, NULL, NULL);
+}
+
+static void
+run_search_highlight (PlumaDocument *doc,
+                      GRand         *rand)
+{
+	GtkTextIter start, end;
+
+	pluma_document_set_search_text (doc, SEARCH_WORD, PLUMA_SEARCH_CASE_SENSITIVE);
+
+	/* what the view does once the whole document is exposed */
+	gtk_text_buffer_get_bounds (GTK_TEXT_BUFFER (doc), &start, &end);
+	_pluma_document_search_region (doc, &start, &end);
+}
+
+static void
+run_search_retarget (PlumaDocument *doc,
+                     GRand         *rand)
+{
+	static const gchar *words[] = { SEARCH_WORD, "dog", "the" };
+	GtkTextIter start, end;
+	gint line;
+	gint i;
+
+	/* typing in the search dialog while a window of lines is shown */
+	for (i = 0; i < 100; i++)
+	{
+		pluma_document_set_search_text (doc,
+		                                words[i % G_N_ELEMENTS (words)],
+		                                PLUMA_SEARCH_CASE_SENSITIVE);
+
+		line = g_rand_int_range (rand, 0, MAX (1, n_lines - 50));
+		gtk_text_buffer_get_iter_at_line (GTK_TEXT_BUFFER (doc), &start, line);
+		gtk_text_buffer_get_iter_at_line (GTK_TEXT_BUFFER (doc), &end, line + 50);
+		_pluma_document_search_region (doc, &start, &end);
+	}
+}
+
+static void
+run_goto_line (PlumaDocument *doc,
+               GRand         *rand)
+{
+	gint i;
+
+	for (i = 0; i < N_RANDOM_OPS; i++)
+	{
+		pluma_document_goto_line (doc, g_rand_int_range (rand, 0, n_lines));
+	}
+}
+
+static void
+run_insert_trace (PlumaDocument *doc,
+                  GRand         *rand)
+{
+	GtkTextBuffer *buffer = GTK_TEXT_BUFFER (doc);
+	GtkTextIter iter;
+	gint chars;
+	gint i;
+
+	chars = gtk_text_buffer_get_char_count (buffer);
+
+	for (i = 0; i < N_RANDOM_OPS; i++)
+	{
+		gtk_text_buffer_get_iter_at_offset (buffer,
+		                                    &iter,
+		                                    g_rand_int_range (rand, 0, chars));
+
+		/* one undo step per keystroke, as when typing */
+		gtk_text_buffer_begin_user_action (buffer);
+		gtk_text_buffer_insert (buffer, &iter, "x", 1);
+		gtk_text_buffer_end_user_action (buffer);
+
+		++chars;
+	}
+}
+
+static void
+run_delete_trace (PlumaDocument *doc,
+                  GRand         *rand)
+{
+	GtkTextBuffer *buffer = GTK_TEXT_BUFFER (doc);
+	GtkTextIter start, end;
+	gint chars;
+	gint i;
+
+	chars = gtk_text_buffer_get_char_count (buffer);
+
+	for (i = 0; i < N_RANDOM_OPS && chars > 1; i++)
+	{
+		gtk_text_buffer_get_iter_at_offset (buffer,
+		                                    &start,
+		                                    g_rand_int_range (rand, 0, chars - 1));
+		end = start;
+		gtk_text_iter_forward_char (&end);
+
+		gtk_text_buffer_begin_user_action (buffer);
+		gtk_text_buffer_delete (buffer, &start, &end);
+		gtk_text_buffer_end_user_action (buffer);
+
+		--chars;
+	}
+}
+
+static void
+sort_ready_cb (GObject       *source,
+               GAsyncResult  *result,
+               GAsyncResult **ret)
+{
+	*ret = g_object_ref (result);
+}
+
+static void
+run_sort (PlumaDocument *doc,
+          GRand         *rand)
+{
+	PlumaSortOptions options = { 0 };
+	GAsyncResult *result = NULL;
+	GtkTextIter start, end;
+	gchar **lines;
+
+	/* the sort plugin on the whole document, case sensitive text keys */
+	options.key_type = PLUMA_SORT_KEY_TEXT;
+	options.case_sensitive = TRUE;
+
+	gtk_text_buffer_get_bounds (GTK_TEXT_BUFFER (doc), &start, &end);
+
+	pluma_sort_lines_async (pluma_sort_get_lines (GTK_TEXT_BUFFER (doc), &start, &end),
+	                        &options,
+	                        NULL,
+	                        NULL,
+	                        NULL,
+	                        (GAsyncReadyCallback) sort_ready_cb,
+	                        &result);
+
+	while (result == NULL)
+		g_main_context_iteration (NULL, TRUE);
+
+	lines = pluma_sort_lines_finish (result, NULL);
+	g_object_unref (result);
+
+	if (lines != NULL)
+	{
+		gtk_text_buffer_get_bounds (GTK_TEXT_BUFFER (doc), &start, &end);
+		pluma_sort_replace_lines (doc, &start, &end, lines);
+
+		g_strfreev (lines);
+	}
+}
+
+static void
+run_docinfo (PlumaDocument *doc,
+             GRand         *rand)
+{
+	GtkTextIter start, end;
+	gint chars, words, white_chars, bytes;
+
+	/* the docinfo plugin on the whole document */
+	gtk_text_buffer_get_bounds (GTK_TEXT_BUFFER (doc), &start, &end);
+
+	pluma_docinfo_count (doc,
+	                     &start,
+	                     &end,
+	                     &chars,
+	                     &words,
+	                     &white_chars,
+	                     &bytes);
+}
+
+static void
+run_change_case (PlumaDocument *doc,
+                 GRand         *rand)
+{
+	GtkTextIter start, end;
+
+	/* Edit > Change Case on the whole document */
+	gtk_text_buffer_get_bounds (GTK_TEXT_BUFFER (doc), &start, &end);
+
+	pluma_document_change_case (doc, GTK_SOURCE_CHANGE_CASE_TITLE, &start, &end);
+}
+
+static void
+run_change_case_gtk (PlumaDocument *doc,
+                     GRand         *rand)
+{
+	GtkTextIter start, end;
+
+	gtk_text_buffer_get_bounds (GTK_TEXT_BUFFER (doc), &start, &end);
+
+	gtk_source_buffer_change_case (GTK_SOURCE_BUFFER (doc),
+	                               GTK_SOURCE_CHANGE_CASE_TITLE,
+	                               &start,
+	                               &end);
+}
+
+static void
+run_indent (PlumaDocument *doc,
+            GRand         *rand)
+{
+	GtkTextIter start, end;
+
+	gtk_text_buffer_get_bounds (GTK_TEXT_BUFFER (doc), &start, &end);
+
+	pluma_document_indent_lines (doc, &start, &end, "\t");
+	pluma_document_unindent_lines (doc, &start, &end, "\t");
+}
+
+static void
+run_trailsave (PlumaDocument *doc,
+               GRand         *rand)
+{
+	GtkTextBuffer *buffer = GTK_TEXT_BUFFER (doc);
+	GtkTextTag *dirty_tag;
+	GtkTextIter start, end;
+
+	/* the trailsave plugin on the first save of a new document, where
+	 * every line is dirty */
+	dirty_tag = gtk_text_buffer_create_tag (buffer, NULL, NULL);
+	gtk_text_buffer_get_bounds (buffer, &start, &end);
+	gtk_text_buffer_apply_tag (buffer, dirty_tag, &start, &end);
+
+	pluma_trail_save_strip (buffer, dirty_tag);
+}
+
+static const Workload workloads[] =
+{
+	{ "replace-all",           FALSE, run_replace_all          },
+	{ "replace-all-nocase",    FALSE, run_replace_all_nocase   },
+	{ "replace-all-regex",     FALSE, run_replace_all_regex    },
+	{ "search-forward",        FALSE, run_search_forward       },
+	{ "search-forward-gtk",    FALSE, run_search_forward_gtk   },
+	{ "search-miss",           FALSE, run_search_miss          },
+	{ "search-miss-gtk",       FALSE, run_search_miss_gtk      },
+	{ "search-highlight",      TRUE,  run_search_highlight     },
+	{ "search-retarget",       TRUE,  run_search_retarget      },
+	{ "goto-line",             FALSE, run_goto_line            },
+	{ "insert-trace",          FALSE, run_insert_trace         },
+	{ "delete-trace",          FALSE, run_delete_trace         },
+	{ "sort",                  FALSE, run_sort                 },
+	{ "docinfo",               FALSE, run_docinfo              },
+	{ "change-case",           FALSE, run_change_case          },
+	{ "change-case-gtk",       FALSE, run_change_case_gtk      },
+	{ "indent",                FALSE, run_indent               },
+	{ "trailsave",             FALSE, run_trailsave            }
+};
+
+static PlumaDocument *
+create_document (const gchar *text,
+                 gboolean     search_highlighting)
+{
+	PlumaDocument *doc;
+
+	doc = pluma_document_new ();
+
+	pluma_document_set_enable_search_highlighting (doc, search_highlighting);
+
+	/* do not measure the undo manager while setting up */
+	gtk_source_buffer_begin_not_undoable_action (GTK_SOURCE_BUFFER (doc));
+	gtk_text_buffer_set_text (GTK_TEXT_BUFFER (doc), text, -1);
+	gtk_source_buffer_end_not_undoable_action (GTK_SOURCE_BUFFER (doc));
+
+	return doc;
+}
+
+static gint
+compare_doubles (gconstpointer a,
+                 gconstpointer b)
+{
+	gdouble da = *(const gdouble *) a;
+	gdouble db = *(const gdouble *) b;
+
+	return (da > db) - (da < db);
+}
+
+/* nearest-rank percentile of a sorted array */
+static gdouble
+percentile (const gdouble *sorted,
+            gint           n,
+            gdouble        p)
+{
+	gint rank;
+
+	rank = (gint) (p * n + 0.999999);
+	rank = CLAMP (rank, 1, n);
+
+	return sorted[rank - 1];
+}
+
+static void
+run_workload (const Workload *workload,
+              const gchar    *text)
+{
+	gdouble *timings;
+	gdouble total = 0;
+	GTimer *timer;
+	gint i;
+
+	timings = g_new (gdouble, iterations);
+	timer = g_timer_new ();
+
+	for (i = 0; i < iterations; i++)
+	{
+		PlumaDocument *doc;
+		GRand *rand;
+
+		doc = create_document (text, workload->search_highlighting);
+
+		/* same sequence of random operations for each run */
+		rand = g_rand_new_with_seed (i);
+
+		marker ("begin", workload->name);
+		g_timer_start (timer);
+
+		workload->run (doc, rand);
+
+		g_timer_stop (timer);
+		marker ("end", workload->name);
+
+		timings[i] = g_timer_elapsed (timer, NULL) * 1000.0;
+		total += timings[i];
+
+		g_rand_free (rand);
+		g_object_unref (doc);
+	}
+
+	qsort (timings, iterations, sizeof (gdouble), compare_doubles);
+
+	g_printf ("{\"workload\":\"%s\",\"lines\":%d,\"iterations\":%d,"
+	          "\"mean_ms\":%.3f,\"min_ms\":%.3f,\"p50_ms\":%.3f,"
+	          "\"p90_ms\":%.3f,\"p99_ms\":%.3f,\"max_ms\":%.3f}\n",
+	          workload->name, n_lines, iterations,
+	          total / iterations,
+	          timings[0],
+	          percentile (timings, iterations, 0.50),
+	          percentile (timings, iterations, 0.90),
+	          percentile (timings, iterations, 0.99),
+	          timings[iterations - 1]);
+
+	fflush (stdout);
+
+	g_timer_destroy (timer);
+	g_free (timings);
+}
+
+int main (int   argc,
+          char *argv[])
+{
+	GOptionContext *context;
+	GError *error = NULL;
+	gchar *text;
+	guint i;
+
+	context = g_option_context_new ("- benchmark pluma editing and search operations");
+	g_option_context_add_main_entries (context, entries, NULL);
+
+	if (!g_option_context_parse (context, &argc, &argv, &error))
+	{
+		g_printerr ("%s\n", error->message);
+		g_error_free (error);
+		g_option_context_free (context);
+		return 1;
+	}
+
+	g_option_context_free (context);
+
+	if (n_lines <= 0 || iterations <= 0)
+	{
+		g_printerr ("--lines and --iterations must be positive\n");
+		return 1;
+	}
+
+	if (markers_path != NULL)
+	{
+		markers = fopen (markers_path, "w");
+
+		if (markers == NULL)
+		{
+			g_printerr ("Could not open %s for writing markers\n", markers_path);
+			return 1;
+		}
+	}
+
+	text = generate_text ();
+
+	for (i = 0; i < G_N_ELEMENTS (workloads); i++)
+	{
+		if (workload_filter != NULL &&
+		    strcmp (workload_filter, workloads[i].name) != 0)
+		{
+			continue;
+		}
+
+		run_workload (&workloads[i], text);
+	}
+
+	if (markers != NULL)
+		fclose (markers);
+
+	g_free (text);
+	g_free (workload_filter);
+	g_free (markers_path);
+
+	return 0;
+}
@@ -0,0 +1,367 @@
+/*
+ * document-edit.c
+ * This file is part of pluma
+ *
+ * Copyright (C) 2012-2021 MATE Developers
+ *
+ * pluma is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * pluma is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pluma; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA  02110-1301  USA
+ */
+
+#include "pluma-document.h"
+#include <gtk/gtk.h>
+#include <glib.h>
+#include <string.h>
+
+/* pluma_document_change_case() works in chunks of this many characters */
+#define TRANSFORM_CHUNK_SIZE (16 * 1024)
+
+static PlumaDocument *
+create_document (const gchar *text)
+{
+	PlumaDocument *doc;
+
+	doc = pluma_document_new ();
+	gtk_text_buffer_set_text (GTK_TEXT_BUFFER (doc), text, -1);
+
+	return doc;
+}
+
+static gchar *
+get_text (PlumaDocument *doc)
+{
+	GtkTextIter start, end;
+
+	gtk_text_buffer_get_bounds (GTK_TEXT_BUFFER (doc), &start, &end);
+
+	return gtk_text_buffer_get_slice (GTK_TEXT_BUFFER (doc), &start, &end, TRUE);
+}
+
+static void
+get_lines (PlumaDocument *doc,
+	   gint           start_line,
+	   gint           end_line,
+	   GtkTextIter   *start,
+	   GtkTextIter   *end)
+{
+	gtk_text_buffer_get_iter_at_line (GTK_TEXT_BUFFER (doc), start, start_line);
+	gtk_text_buffer_get_iter_at_line (GTK_TEXT_BUFFER (doc), end, end_line);
+}
+
+static void
+test_change_case (const gchar             *in,
+		  GtkSourceChangeCaseType  case_type,
+		  const gchar             *out)
+{
+	PlumaDocument *doc;
+	GtkTextIter start, end;
+	gchar *text;
+
+	doc = create_document (in);
+
+	gtk_text_buffer_get_bounds (GTK_TEXT_BUFFER (doc), &start, &end);
+	pluma_document_change_case (doc, case_type, &start, &end);
+
+	text = get_text (doc);
+	g_assert_cmpstr (text, ==, out);
+
+	/* the iters cover the new text */
+	g_assert_cmpint (gtk_text_iter_get_offset (&start), ==, 0);
+	g_assert_cmpint (gtk_text_iter_get_offset (&end), ==, g_utf8_strlen (out, -1));
+
+	g_free (text);
+	g_object_unref (doc);
+}
+
+static void
+test_change_case_simple ()
+{
+	test_change_case ("Hello World", GTK_SOURCE_CHANGE_CASE_LOWER, "hello world");
+	test_change_case ("Hello World", GTK_SOURCE_CHANGE_CASE_UPPER, "HELLO WORLD");
+	test_change_case ("Hello World", GTK_SOURCE_CHANGE_CASE_TOGGLE, "hELLO wORLD");
+	test_change_case ("hELLO wORLD it's", GTK_SOURCE_CHANGE_CASE_TITLE, "Hello World It's");
+	test_change_case ("", GTK_SOURCE_CHANGE_CASE_UPPER, "");
+}
+
+static void
+test_change_case_length ()
+{
+	GString *in;
+	GString *out;
+	gint i;
+
+	test_change_case ("stra\xc3\x9f" "e", GTK_SOURCE_CHANGE_CASE_UPPER, "STRASSE");
+
+	/* 'ß' becomes "SS": every chunk grows, the next ones must still
+	 * start at the right place */
+	in = g_string_new (NULL);
+	out = g_string_new (NULL);
+
+	for (i = 0; i < TRANSFORM_CHUNK_SIZE; i++)
+	{
+		g_string_append (in, "\xc3\x9f ");
+		g_string_append (out, "SS ");
+	}
+
+	g_string_append (in, " end");
+	g_string_append (out, " END");
+
+	test_change_case (in->str, GTK_SOURCE_CHANGE_CASE_UPPER, out->str);
+
+	g_string_free (in, TRUE);
+	g_string_free (out, TRUE);
+}
+
+static void
+test_change_case_title_chunks ()
+{
+	GString *in;
+	GString *out;
+
+	/* a word across the first chunk boundary only gets one capital */
+	in = g_string_new (NULL);
+	g_string_append_c (in, 'x');
+	while (in->len < TRANSFORM_CHUNK_SIZE - 1)
+		g_string_append_c (in, 'a');
+	g_string_append (in, "BCD efg");
+
+	out = g_string_new (NULL);
+	g_string_append_c (out, 'X');
+	while (out->len < TRANSFORM_CHUNK_SIZE - 1)
+		g_string_append_c (out, 'a');
+	g_string_append (out, "bcd Efg");
+
+	test_change_case (in->str, GTK_SOURCE_CHANGE_CASE_TITLE, out->str);
+
+	g_string_free (in, TRUE);
+	g_string_free (out, TRUE);
+}
+
+static void
+test_change_case_final_sigma ()
+{
+	GString *in;
+	GString *out;
+
+	/* a capital sigma is lowered to a final sigma at the end of a word
+	 * only: the word must not be cut by the end of a chunk */
+	in = g_string_new (NULL);
+	while (in->len < TRANSFORM_CHUNK_SIZE - 2)
+		g_string_append_c (in, 'X');
+	g_string_append (in, " \xce\xa3\xce\x91 \xce\x91\xce\xa3");
+
+	out = g_string_new (NULL);
+	while (out->len < TRANSFORM_CHUNK_SIZE - 2)
+		g_string_append_c (out, 'x');
+	g_string_append (out, " \xcf\x83\xce\xb1 \xce\xb1\xcf\x82");
+
+	test_change_case (in->str, GTK_SOURCE_CHANGE_CASE_LOWER, out->str);
+
+	g_string_free (in, TRUE);
+	g_string_free (out, TRUE);
+}
+
+static void
+test_change_case_range ()
+{
+	PlumaDocument *doc;
+	GtkTextIter start, end;
+	gchar *text;
+
+	doc = create_document ("one two three");
+
+	gtk_text_buffer_get_iter_at_offset (GTK_TEXT_BUFFER (doc), &start, 4);
+	gtk_text_buffer_get_iter_at_offset (GTK_TEXT_BUFFER (doc), &end, 7);
+
+	/* the iters may come in any order */
+	pluma_document_change_case (doc, GTK_SOURCE_CHANGE_CASE_UPPER, &end, &start);
+
+	text = get_text (doc);
+	g_assert_cmpstr (text, ==, "one TWO three");
+	g_free (text);
+
+	g_object_unref (doc);
+}
+
+static void
+test_delete_lines (const gchar *in,
+		   gint         start_line,
+		   gint         start_offset,
+		   gint         end_line,
+		   gint         end_offset,
+		   const gchar *out)
+{
+	PlumaDocument *doc;
+	GtkTextIter start, end;
+	gchar *text;
+
+	doc = create_document (in);
+
+	gtk_text_buffer_get_iter_at_line_offset (GTK_TEXT_BUFFER (doc), &start,
+						 start_line, start_offset);
+	gtk_text_buffer_get_iter_at_line_offset (GTK_TEXT_BUFFER (doc), &end,
+						 end_line, end_offset);
+
+	g_assert (pluma_document_delete_lines (doc, &start, &end, TRUE));
+
+	text = get_text (doc);
+	g_assert_cmpstr (text, ==, out);
+	g_assert (gtk_text_iter_equal (&start, &end));
+
+	g_free (text);
+	g_object_unref (doc);
+}
+
+static void
+test_delete_lines_simple ()
+{
+	test_delete_lines ("one\ntwo\nthree", 1, 1, 1, 1, "one\nthree");
+	test_delete_lines ("one\ntwo\nthree", 0, 2, 1, 1, "three");
+	test_delete_lines ("one\ntwo\nthree\n", 1, 0, 2, 3, "one\n");
+
+	/* a selection ending at the start of a line leaves it */
+	test_delete_lines ("one\ntwo\nthree", 0, 1, 2, 0, "three");
+}
+
+static void
+test_delete_lines_last ()
+{
+	/* the newline before the last line goes away with it */
+	test_delete_lines ("one\ntwo\nthree", 2, 1, 2, 1, "one\ntwo");
+	test_delete_lines ("one\ntwo\nthree", 1, 1, 2, 2, "one");
+	test_delete_lines ("one\ntwo\n", 2, 0, 2, 0, "one\ntwo");
+	test_delete_lines ("only", 0, 2, 0, 2, "");
+}
+
+static void
+test_delete_lines_not_editable ()
+{
+	PlumaDocument *doc;
+	GtkTextTag *tag;
+	GtkTextIter start, end;
+	gchar *text;
+
+	doc = create_document ("one\ntwo\nthree");
+
+	tag = gtk_text_buffer_create_tag (GTK_TEXT_BUFFER (doc), NULL,
+					  "editable", FALSE,
+					  NULL);
+
+	gtk_text_buffer_get_iter_at_line_offset (GTK_TEXT_BUFFER (doc), &start, 1, 0);
+	gtk_text_buffer_get_iter_at_line_offset (GTK_TEXT_BUFFER (doc), &end, 1, 3);
+	gtk_text_buffer_apply_tag (GTK_TEXT_BUFFER (doc), tag, &start, &end);
+
+	get_lines (doc, 0, 1, &start, &end);
+	gtk_text_iter_forward_to_line_end (&end);
+	g_assert (pluma_document_delete_lines (doc, &start, &end, TRUE));
+
+	text = get_text (doc);
+	g_assert (strstr (text, "two") != NULL);
+	g_assert (strstr (text, "one") == NULL);
+	g_free (text);
+
+	/* nothing is editable */
+	get_lines (doc, 0, 0, &start, &end);
+	g_assert (!pluma_document_delete_lines (doc, &start, &end, FALSE));
+
+	g_object_unref (doc);
+}
+
+static void
+test_indent_lines ()
+{
+	PlumaDocument *doc;
+	GtkTextIter start, end;
+	gchar *text;
+
+	doc = create_document ("a\n\nb\nc");
+
+	/* the empty line is left alone, the last one is not selected */
+	get_lines (doc, 0, 3, &start, &end);
+	pluma_document_indent_lines (doc, &start, &end, "\t");
+
+	text = get_text (doc);
+	g_assert_cmpstr (text, ==, "\ta\n\n\tb\nc");
+	g_free (text);
+
+	g_assert_cmpint (gtk_text_iter_get_line (&start), ==, 0);
+	g_assert (gtk_text_iter_starts_line (&start));
+	g_assert_cmpint (gtk_text_iter_get_line (&end), ==, 2);
+	g_assert (gtk_text_iter_ends_line (&end));
+
+	/* a single line, the iters in reverse order */
+	get_lines (doc, 3, 3, &start, &end);
+	gtk_text_iter_forward_to_line_end (&end);
+	pluma_document_indent_lines (doc, &end, &start, "  ");
+
+	text = get_text (doc);
+	g_assert_cmpstr (text, ==, "\ta\n\n\tb\n  c");
+	g_free (text);
+
+	g_object_unref (doc);
+}
+
+static void
+test_unindent_lines ()
+{
+	PlumaDocument *doc;
+	GtkTextIter start, end;
+	gchar *text;
+
+	doc = create_document ("\t\ta\n      b\n  c\nd\n");
+
+	get_lines (doc, 0, 4, &start, &end);
+	pluma_document_unindent_lines (doc, &start, &end, "    ");
+
+	/* one tab, or up to four spaces */
+	text = get_text (doc);
+	g_assert_cmpstr (text, ==, "\ta\n  b\nc\nd\n");
+	g_free (text);
+
+	g_assert_cmpint (gtk_text_iter_get_line (&start), ==, 0);
+	g_assert_cmpint (gtk_text_iter_get_line (&end), ==, 3);
+	g_assert (gtk_text_iter_ends_line (&end));
+
+	get_lines (doc, 0, 4, &start, &end);
+	pluma_document_unindent_lines (doc, &start, &end, "\t");
+
+	/* a tab indentation removes one space at most */
+	text = get_text (doc);
+	g_assert_cmpstr (text, ==, "a\n b\nc\nd\n");
+	g_free (text);
+
+	g_object_unref (doc);
+}
+
+int main (int   argc,
+          char *argv[])
+{
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add_func ("/document-edit/change-case", test_change_case_simple);
+	g_test_add_func ("/document-edit/change-case-length", test_change_case_length);
+	g_test_add_func ("/document-edit/change-case-title-chunks", test_change_case_title_chunks);
+	g_test_add_func ("/document-edit/change-case-final-sigma", test_change_case_final_sigma);
+	g_test_add_func ("/document-edit/change-case-range", test_change_case_range);
+
+	g_test_add_func ("/document-edit/delete-lines", test_delete_lines_simple);
+	g_test_add_func ("/document-edit/delete-lines-last", test_delete_lines_last);
+	g_test_add_func ("/document-edit/delete-lines-not-editable", test_delete_lines_not_editable);
+
+	g_test_add_func ("/document-edit/indent-lines", test_indent_lines);
+	g_test_add_func ("/document-edit/unindent-lines", test_unindent_lines);
+
+	return g_test_run ();
+}
@@ -138,6 +138,30 @@ test_consecutive_multibyte_big_read ()
 	test_consecutive_read ("hello\nhello\xe6\x96\x87\nworld\n", "hello\nhello\xe6\x96\x87\nworld\n\n", PLUMA_DOCUMENT_NEWLINE_TYPE_LF, 200);
 }
 
+static void
+test_long_line_cut ()
+{
+	GString *in, *out;
+	gint i;
+
+	/* a line many times longer than the reads, cut in the middle of
+	 * multibyte characters */
+	in = g_string_new (NULL);
+	for (i = 0; i < 40; i++)
+		g_string_append (in, "a\xe6\x96\x87");
+
+	out = g_string_new (in->str);
+
+	g_string_append (in, "\nb");
+	g_string_append (out, "\rb\r");
+
+	test_consecutive_read (in->str, out->str, PLUMA_DOCUMENT_NEWLINE_TYPE_CR, 7);
+	test_consecutive_read (in->str, out->str, PLUMA_DOCUMENT_NEWLINE_TYPE_CR, 6);
+
+	g_string_free (in, TRUE);
+	g_string_free (out, TRUE);
+}
+
 int main (int   argc,
           char *argv[])
 {
@@ -152,5 +176,7 @@ int main (int   argc,
 	g_test_add_func ("/document-input-stream/consecutive_multibyte_cut", test_consecutive_multibyte_cut);
 	g_test_add_func ("/document-input-stream/consecutive_multibyte_big_read", test_consecutive_multibyte_big_read);
 
+	g_test_add_func ("/document-input-stream/long_line_cut", test_long_line_cut);
+
 	return g_test_run ();
 }
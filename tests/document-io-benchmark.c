@@ -0,0 +1,498 @@
+/*
+ * document-io-benchmark.c
+ * This file is part of pluma
+ *
+ * Copyright (C) 2012-2021 MATE Developers
+ *
+ * pluma is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * pluma is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pluma; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA  02110-1301  USA
+ */
+
+/*
+ * Throughput benchmark for the load/save pipeline.
+ *
+ * Synthetic corpora are generated in a temporary directory, then loaded
+ * with PlumaDocumentLoader and written back with PlumaDocumentSaver.
+ * Every run prints one JSON object per line on stdout, e.g.
+ *
+ *   {"corpus":"ascii","op":"load","bytes":16777216,"seconds":0.41,...}
+ *
+ * so that results can be collected and compared between revisions.
+ * This is not part of "make check", run it by hand:
+ *
+ *   ./document-io-benchmark --size=64 --iterations=5 --corpus=utf8
+ */
+
+#include "pluma-document-loader.h"
+#include "pluma-document-saver.h"
+#include <gio/gio.h>
+#include <gtk/gtk.h>
+#include <glib.h>
+#include <glib/gprintf.h>
+#include <glib/gstdio.h>
+#include <string.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#ifdef __GLIBC__
+/* Count heap allocations by interposing the allocator entry points, glibc
+ * exports its own implementation under the __libc_ prefix */
+extern void *__libc_malloc  (size_t size);
+extern void *__libc_calloc  (size_t nmemb, size_t size);
+extern void *__libc_realloc (void *ptr, size_t size);
+extern void  __libc_free    (void *ptr);
+
+static guint64 n_allocs = 0;
+
+void *
+malloc (size_t size)
+{
+	__atomic_fetch_add (&n_allocs, 1, __ATOMIC_RELAXED);
+	return __libc_malloc (size);
+}
+
+void *
+calloc (size_t nmemb, size_t size)
+{
+	__atomic_fetch_add (&n_allocs, 1, __ATOMIC_RELAXED);
+	return __libc_calloc (nmemb, size);
+}
+
+void *
+realloc (void *ptr, size_t size)
+{
+	if (ptr == NULL)
+		__atomic_fetch_add (&n_allocs, 1, __ATOMIC_RELAXED);
+
+	return __libc_realloc (ptr, size);
+}
+
+void
+free (void *ptr)
+{
+	__libc_free (ptr);
+}
+
+static guint64
+get_n_allocs (void)
+{
+	return __atomic_load_n (&n_allocs, __ATOMIC_RELAXED);
+}
+#else
+static guint64
+get_n_allocs (void)
+{
+	/* not available on this platform */
+	return 0;
+}
+#endif
+
+typedef void (*CorpusLineFunc) (GString *line, guint n);
+
+typedef struct
+{
+	const gchar    *name;
+	const gchar    *charset;
+	const gchar    *newline;
+	CorpusLineFunc  line_func;
+} Corpus;
+
+typedef struct
+{
+	gboolean  done;
+	GError   *error;
+} OperationData;
+
+static gint     size_mb = 16;
+static gint     iterations = 3;
+static gchar   *corpus_filter = NULL;
+static gboolean keep_files = FALSE;
+
+static GOptionEntry entries[] =
+{
+	{ "size", 's', 0, G_OPTION_ARG_INT, &size_mb,
+	  "Size of each generated corpus in MB (default 16)", "MB" },
+	{ "iterations", 'i', 0, G_OPTION_ARG_INT, &iterations,
+	  "Number of load/save rounds per corpus (default 3)", "N" },
+	{ "corpus", 'c', 0, G_OPTION_ARG_STRING, &corpus_filter,
+	  "Only run the named corpus", "NAME" },
+	{ "keep", 'k', 0, G_OPTION_ARG_NONE, &keep_files,
+	  "Do not delete the generated files", NULL },
+	{ NULL }
+};
+
+static const gchar *lorem =
+	"Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod "
+	"tempor incididunt ut labore et dolore magna aliqua. Ut enim ad minim ";
+
+static void
+ascii_line (GString *line,
+            guint    n)
+{
+	g_string_append_printf (line, "%08u ", n);
+	g_string_append_len (line, lorem + (n % 32), 64);
+}
+
+static void
+utf8_line (GString *line,
+           guint    n)
+{
+	/* mix of 2, 3 and 4 bytes sequences */
+	static const gchar *words[] = {
+		"ñandú", "€uro", "日本語", "текст", "Ελληνικά", "😀🚀", "ünïcödé", "中文字符"
+	};
+	guint i;
+
+	g_string_append_printf (line, "%08u", n);
+
+	for (i = 0; i < 8; i++)
+	{
+		g_string_append_c (line, ' ');
+		g_string_append (line, words[(n + i) % G_N_ELEMENTS (words)]);
+	}
+}
+
+static void
+latin9_line (GString *line,
+             guint    n)
+{
+	/* raw ISO-8859-15 bytes: é, à, ü, ç, € (0xA4), œ (0xBD) */
+	static const gchar latin9[] = "caf\xe9 \xe0 la m\xfcnchen gar\xe7on \xa4 c\xbdur ";
+
+	g_string_append_printf (line, "%08u ", n);
+	g_string_append_len (line, latin9, sizeof (latin9) - 1);
+	g_string_append_len (line, lorem + (n % 32), 24);
+}
+
+static void
+long_line (GString *line,
+           guint    n)
+{
+	/* one line per MB */
+	while (line->len < 1024 * 1024)
+		g_string_append_len (line, lorem, 128);
+}
+
+static void
+short_line (GString *line,
+            guint    n)
+{
+	g_string_append_c (line, 'a' + (n % 26));
+}
+
+static const Corpus corpora[] =
+{
+	{ "ascii",       "UTF-8",       "\n",   ascii_line  },
+	{ "utf8",        "UTF-8",       "\n",   utf8_line   },
+	{ "crlf",        "UTF-8",       "\r\n", ascii_line  },
+	{ "iso-8859-15", "ISO-8859-15", "\n",   latin9_line },
+	{ "long-lines",  "UTF-8",       "\n",   long_line   },
+	{ "short-lines", "UTF-8",       "\n",   short_line  }
+};
+
+static gchar *
+generate_corpus (const Corpus *corpus,
+                 const gchar  *dir,
+                 gsize         size,
+                 gsize        *written)
+{
+	gchar *filename;
+	GString *contents;
+	GString *line;
+	guint n = 0;
+	GError *error = NULL;
+
+	contents = g_string_sized_new (size + 1024 * 1024 + 64);
+	line = g_string_new (NULL);
+
+	while (contents->len < size)
+	{
+		g_string_truncate (line, 0);
+		corpus->line_func (line, n++);
+
+		g_string_append_len (contents, line->str, line->len);
+		g_string_append (contents, corpus->newline);
+	}
+
+	filename = g_build_filename (dir, corpus->name, NULL);
+
+	if (!g_file_set_contents (filename, contents->str, contents->len, &error))
+	{
+		g_error ("Could not write corpus %s: %s", filename, error->message);
+	}
+
+	*written = contents->len;
+
+	g_string_free (line, TRUE);
+	g_string_free (contents, TRUE);
+
+	return filename;
+}
+
+static glong
+get_peak_rss_kb (void)
+{
+	struct rusage usage;
+
+	if (getrusage (RUSAGE_SELF, &usage) != 0)
+		return -1;
+
+	/* ru_maxrss is in kilobytes on Linux and the BSDs */
+	return usage.ru_maxrss;
+}
+
+static void
+report (const Corpus *corpus,
+        const gchar  *op,
+        gint          iteration,
+        gsize         bytes,
+        gdouble       seconds,
+        guint64       allocs,
+        const GError *error)
+{
+	gdouble mbs;
+
+	mbs = seconds > 0 ? (bytes / (1024.0 * 1024.0)) / seconds : 0;
+
+	g_printf ("{\"corpus\":\"%s\",\"op\":\"%s\",\"iteration\":%d,"
+	          "\"bytes\":%" G_GSIZE_FORMAT ",\"seconds\":%.6f,"
+	          "\"mb_per_sec\":%.3f,\"peak_rss_kb\":%ld,"
+	          "\"allocs\":%" G_GUINT64_FORMAT ",\"ok\":%s}\n",
+	          corpus->name, op, iteration,
+	          bytes, seconds,
+	          mbs, get_peak_rss_kb (),
+	          allocs, error == NULL ? "true" : "false");
+
+	if (error != NULL)
+	{
+		g_printerr ("%s/%s: %s\n", corpus->name, op, error->message);
+	}
+
+	fflush (stdout);
+}
+
+static void
+on_operation_done (PlumaDocument *document,
+                   const GError  *error,
+                   OperationData *data)
+{
+	if (error != NULL)
+		data->error = g_error_copy (error);
+
+	data->done = TRUE;
+}
+
+static void
+wait_for (OperationData *data)
+{
+	while (!data->done)
+	{
+		g_main_context_iteration (NULL, TRUE);
+	}
+}
+
+static PlumaDocument *
+bench_load (const Corpus        *corpus,
+            const PlumaEncoding *encoding,
+            const gchar         *uri,
+            gsize                bytes,
+            gint                 iteration)
+{
+	PlumaDocument *document;
+	OperationData data = { FALSE, NULL };
+	GTimer *timer;
+	guint64 allocs;
+	gulong id;
+
+	document = pluma_document_new ();
+
+	/* avoid measuring the highlighting of search matches */
+	pluma_document_set_enable_search_highlighting (document, FALSE);
+
+	id = g_signal_connect (document,
+	                       "loaded",
+	                       G_CALLBACK (on_operation_done),
+	                       &data);
+
+	allocs = get_n_allocs ();
+	timer = g_timer_new ();
+
+	pluma_document_load (document, uri, encoding, 0, FALSE);
+	wait_for (&data);
+
+	g_timer_stop (timer);
+
+	report (corpus, "load", iteration, bytes,
+	        g_timer_elapsed (timer, NULL),
+	        get_n_allocs () - allocs,
+	        data.error);
+
+	g_signal_handler_disconnect (document, id);
+	g_timer_destroy (timer);
+
+	if (data.error != NULL)
+	{
+		g_error_free (data.error);
+		g_object_unref (document);
+		return NULL;
+	}
+
+	return document;
+}
+
+static void
+bench_save (const Corpus        *corpus,
+            const PlumaEncoding *encoding,
+            PlumaDocument       *document,
+            const gchar         *uri,
+            gsize                bytes,
+            gint                 iteration)
+{
+	OperationData data = { FALSE, NULL };
+	GTimer *timer;
+	guint64 allocs;
+	gulong id;
+
+	id = g_signal_connect (document,
+	                       "saved",
+	                       G_CALLBACK (on_operation_done),
+	                       &data);
+
+	allocs = get_n_allocs ();
+	timer = g_timer_new ();
+
+	pluma_document_save_as (document,
+	                        uri,
+	                        encoding,
+	                        PLUMA_DOCUMENT_SAVE_IGNORE_BACKUP);
+	wait_for (&data);
+
+	g_timer_stop (timer);
+
+	report (corpus, "save", iteration, bytes,
+	        g_timer_elapsed (timer, NULL),
+	        get_n_allocs () - allocs,
+	        data.error);
+
+	g_signal_handler_disconnect (document, id);
+	g_timer_destroy (timer);
+
+	g_clear_error (&data.error);
+}
+
+static void
+bench_corpus (const Corpus *corpus,
+              const gchar  *dir)
+{
+	const PlumaEncoding *encoding;
+	gchar *filename;
+	gchar *saved_filename;
+	gchar *uri;
+	gchar *saved_uri;
+	gsize bytes;
+	gint i;
+
+	encoding = pluma_encoding_get_from_charset (corpus->charset);
+	g_return_if_fail (encoding != NULL);
+
+	filename = generate_corpus (corpus, dir, (gsize) size_mb * 1024 * 1024, &bytes);
+	saved_filename = g_strconcat (filename, ".saved", NULL);
+
+	uri = g_filename_to_uri (filename, NULL, NULL);
+	saved_uri = g_filename_to_uri (saved_filename, NULL, NULL);
+
+	for (i = 0; i < iterations; i++)
+	{
+		PlumaDocument *document;
+
+		document = bench_load (corpus, encoding, uri, bytes, i);
+
+		if (document == NULL)
+			break;
+
+		bench_save (corpus, encoding, document, saved_uri, bytes, i);
+
+		g_object_unref (document);
+	}
+
+	if (!keep_files)
+	{
+		g_unlink (filename);
+		g_unlink (saved_filename);
+	}
+
+	g_free (uri);
+	g_free (saved_uri);
+	g_free (filename);
+	g_free (saved_filename);
+}
+
+int main (int   argc,
+          char *argv[])
+{
+	GOptionContext *context;
+	GError *error = NULL;
+	gchar *dir;
+	guint i;
+
+	context = g_option_context_new ("- benchmark the pluma load/save pipeline");
+	g_option_context_add_main_entries (context, entries, NULL);
+
+	if (!g_option_context_parse (context, &argc, &argv, &error))
+	{
+		g_printerr ("%s\n", error->message);
+		g_error_free (error);
+		g_option_context_free (context);
+		return 1;
+	}
+
+	g_option_context_free (context);
+
+	if (size_mb <= 0 || iterations <= 0)
+	{
+		g_printerr ("--size and --iterations must be positive\n");
+		return 1;
+	}
+
+	dir = g_dir_make_tmp ("pluma-io-benchmark-XXXXXX", &error);
+
+	if (dir == NULL)
+	{
+		g_printerr ("%s\n", error->message);
+		g_error_free (error);
+		return 1;
+	}
+
+	for (i = 0; i < G_N_ELEMENTS (corpora); i++)
+	{
+		if (corpus_filter != NULL &&
+		    strcmp (corpus_filter, corpora[i].name) != 0)
+		{
+			continue;
+		}
+
+		bench_corpus (&corpora[i], dir);
+	}
+
+	if (!keep_files)
+		g_rmdir (dir);
+	else
+		g_printerr ("Generated files kept in %s\n", dir);
+
+	g_free (dir);
+	g_free (corpus_filter);
+
+	return 0;
+}
@@ -345,6 +345,48 @@ test_guessed ()
 	g_free (aux2);
 }
 
+static void
+test_ranked ()
+{
+	GSList *encs = NULL;
+	gchar *aux;
+	const PlumaEncoding *guessed;
+
+	/* plain ASCII goes to UTF-8 wherever it is in the list */
+	encs = g_slist_append (encs, (gpointer)pluma_encoding_get_from_charset ("ISO-8859-15"));
+	encs = g_slist_append (encs, (gpointer)pluma_encoding_get_utf8 ());
+
+	aux = do_test (TEXT_TO_CONVERT, NULL, encs, strlen (TEXT_TO_CONVERT), &guessed);
+	g_assert_cmpstr (aux, ==, TEXT_TO_CONVERT);
+	g_assert (guessed == pluma_encoding_get_utf8 ());
+
+	g_free (aux);
+	g_slist_free (encs);
+	encs = NULL;
+
+	/* 0x92 is a C1 control in ISO-8859-15, a quote in WINDOWS-1252 */
+	encs = g_slist_append (encs, (gpointer)pluma_encoding_get_from_charset ("ISO-8859-15"));
+	encs = g_slist_append (encs, (gpointer)pluma_encoding_get_from_charset ("WINDOWS-1252"));
+
+	aux = do_test ("caf\xe9 cr\xe8me, don\x92t", NULL, encs, 17, &guessed);
+	g_assert_cmpstr (aux, ==, "caf\xc3\xa9 cr\xc3\xa8me, don\xe2\x80\x99t");
+	g_assert (guessed == pluma_encoding_get_from_charset ("WINDOWS-1252"));
+
+	g_free (aux);
+	g_slist_free (encs);
+	encs = NULL;
+
+	/* lower case cyrillic in WINDOWS-1251 is upper case in KOI8-R */
+	encs = g_slist_append (encs, (gpointer)pluma_encoding_get_from_charset ("KOI8-R"));
+	encs = g_slist_append (encs, (gpointer)pluma_encoding_get_from_charset ("WINDOWS-1251"));
+
+	aux = do_test ("\xef\xf0\xe8\xe2\xe5\xf2 \xec\xe8\xf0", NULL, encs, 10, &guessed);
+	g_assert (guessed == pluma_encoding_get_from_charset ("WINDOWS-1251"));
+
+	g_free (aux);
+	g_slist_free (encs);
+}
+
 int main (int   argc,
           char *argv[])
 {
@@ -354,6 +396,7 @@ int main (int   argc,
 	//g_test_add_func ("/smart-converter/xxx-xxx", test_xxx_xxx);
 	g_test_add_func ("/smart-converter/guessed", test_guessed);
 	g_test_add_func ("/smart-converter/empty", test_empty);
+	g_test_add_func ("/smart-converter/ranked", test_ranked);
 
 	return g_test_run ();
 }